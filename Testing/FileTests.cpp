@@ -0,0 +1,85 @@
+/* Generated file, do not edit */
+
+#ifndef CXXTEST_RUNNING
+#define CXXTEST_RUNNING
+#endif
+
+#define _CXXTEST_HAVE_STD
+#include <cxxtest/TestListener.h>
+#include <cxxtest/TestTracker.h>
+#include <cxxtest/TestRunner.h>
+#include <cxxtest/RealDescriptions.h>
+
+#include "/root/repo/src/FileTests.h"
+
+static FileTests suite_FileTests;
+
+static CxxTest::List Tests_FileTests = { 0, 0 };
+CxxTest::StaticSuiteDescription suiteDescription_FileTests( "/root/repo/src/FileTests.h", 38, "FileTests", suite_FileTests, Tests_FileTests );
+
+static class TestDescription_FileTests_testmReadNextBlock : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testmReadNextBlock() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 66, "testmReadNextBlock" ) {}
+ void runTest() { suite_FileTests.testmReadNextBlock(); }
+} testDescription_FileTests_testmReadNextBlock;
+
+static class TestDescription_FileTests_testmMapNextBlock : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testmMapNextBlock() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 119, "testmMapNextBlock" ) {}
+ void runTest() { suite_FileTests.testmMapNextBlock(); }
+} testDescription_FileTests_testmMapNextBlock;
+
+static class TestDescription_FileTests_testmWriteNextBlock : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testmWriteNextBlock() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 169, "testmWriteNextBlock" ) {}
+ void runTest() { suite_FileTests.testmWriteNextBlock(); }
+} testDescription_FileTests_testmWriteNextBlock;
+
+static class TestDescription_FileTests_testGzipFile : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testGzipFile() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 245, "testGzipFile" ) {}
+ void runTest() { suite_FileTests.testGzipFile(); }
+} testDescription_FileTests_testGzipFile;
+
+static class TestDescription_FileTests_testZstdFile : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testZstdFile() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 389, "testZstdFile" ) {}
+ void runTest() { suite_FileTests.testZstdFile(); }
+} testDescription_FileTests_testZstdFile;
+
+static class TestDescription_FileTests_testIdentifyFile : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testIdentifyFile() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 492, "testIdentifyFile" ) {}
+ void runTest() { suite_FileTests.testIdentifyFile(); }
+} testDescription_FileTests_testIdentifyFile;
+
+static class TestDescription_FileTests_testUtf8Validator : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testUtf8Validator() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 617, "testUtf8Validator" ) {}
+ void runTest() { suite_FileTests.testUtf8Validator(); }
+} testDescription_FileTests_testUtf8Validator;
+
+static class TestDescription_FileTests_testUtf8FileBoundaries : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testUtf8FileBoundaries() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 667, "testUtf8FileBoundaries" ) {}
+ void runTest() { suite_FileTests.testUtf8FileBoundaries(); }
+} testDescription_FileTests_testUtf8FileBoundaries;
+
+static class TestDescription_FileTests_testmReadBlocks : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testmReadBlocks() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 749, "testmReadBlocks" ) {}
+ void runTest() { suite_FileTests.testmReadBlocks(); }
+} testDescription_FileTests_testmReadBlocks;
+
+static class TestDescription_FileTests_testCrlfLineEndings : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testCrlfLineEndings() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 818, "testCrlfLineEndings" ) {}
+ void runTest() { suite_FileTests.testCrlfLineEndings(); }
+} testDescription_FileTests_testCrlfLineEndings;
+
+static class TestDescription_FileTests_testTranscodedFiles : public CxxTest::RealTestDescription {
+public:
+ TestDescription_FileTests_testTranscodedFiles() : CxxTest::RealTestDescription( Tests_FileTests, suiteDescription_FileTests, 978, "testTranscodedFiles" ) {}
+ void runTest() { suite_FileTests.testTranscodedFiles(); }
+} testDescription_FileTests_testTranscodedFiles;
+
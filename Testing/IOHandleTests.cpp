@@ -0,0 +1,139 @@
+/* Generated file, do not edit */
+
+#ifndef CXXTEST_RUNNING
+#define CXXTEST_RUNNING
+#endif
+
+#define _CXXTEST_HAVE_STD
+#include <cxxtest/TestListener.h>
+#include <cxxtest/TestTracker.h>
+#include <cxxtest/TestRunner.h>
+#include <cxxtest/RealDescriptions.h>
+
+#include "/root/repo/src/IOHandleTests.h"
+
+static IOTests suite_IOTests;
+
+static CxxTest::List Tests_IOTests = { 0, 0 };
+CxxTest::StaticSuiteDescription suiteDescription_IOTests( "/root/repo/src/IOHandleTests.h", 45, "IOTests", suite_IOTests, Tests_IOTests );
+
+static class TestDescription_IOTests_testCreateFileForTests : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testCreateFileForTests() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 84, "testCreateFileForTests" ) {}
+ void runTest() { suite_IOTests.testCreateFileForTests(); }
+} testDescription_IOTests_testCreateFileForTests;
+
+static class TestDescription_IOTests_testPosixIOHandleErrorOnOpen : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleErrorOnOpen() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 97, "testPosixIOHandleErrorOnOpen" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleErrorOnOpen(); }
+} testDescription_IOTests_testPosixIOHandleErrorOnOpen;
+
+static class TestDescription_IOTests_testPosixIOHandleReadOnlyFileAsReadWrite : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleReadOnlyFileAsReadWrite() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 113, "testPosixIOHandleReadOnlyFileAsReadWrite" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleReadOnlyFileAsReadWrite(); }
+} testDescription_IOTests_testPosixIOHandleReadOnlyFileAsReadWrite;
+
+static class TestDescription_IOTests_testPosixIOHandleReadOnly : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleReadOnly() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 130, "testPosixIOHandleReadOnly" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleReadOnly(); }
+} testDescription_IOTests_testPosixIOHandleReadOnly;
+
+static class TestDescription_IOTests_testPosixIOHandleReadWrite : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleReadWrite() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 179, "testPosixIOHandleReadWrite" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleReadWrite(); }
+} testDescription_IOTests_testPosixIOHandleReadWrite;
+
+static class TestDescription_IOTests_testMmapIOHandleReadOnly : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testMmapIOHandleReadOnly() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 248, "testMmapIOHandleReadOnly" ) {}
+ void runTest() { suite_IOTests.testMmapIOHandleReadOnly(); }
+} testDescription_IOTests_testMmapIOHandleReadOnly;
+
+static class TestDescription_IOTests_testMemoryIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testMemoryIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 302, "testMemoryIOHandle" ) {}
+ void runTest() { suite_IOTests.testMemoryIOHandle(); }
+} testDescription_IOTests_testMemoryIOHandle;
+
+static class TestDescription_IOTests_testPosixIOHandleWriteV : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleWriteV() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 351, "testPosixIOHandleWriteV" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleWriteV(); }
+} testDescription_IOTests_testPosixIOHandleWriteV;
+
+static class TestDescription_IOTests_testPosixIOHandleCopyRange : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleCopyRange() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 383, "testPosixIOHandleCopyRange" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleCopyRange(); }
+} testDescription_IOTests_testPosixIOHandleCopyRange;
+
+static class TestDescription_IOTests_testAsyncIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testAsyncIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 479, "testAsyncIOHandle" ) {}
+ void runTest() { suite_IOTests.testAsyncIOHandle(); }
+} testDescription_IOTests_testAsyncIOHandle;
+
+static class TestDescription_IOTests_testAsyncIOHandleThreadPool : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testAsyncIOHandleThreadPool() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 485, "testAsyncIOHandleThreadPool" ) {}
+ void runTest() { suite_IOTests.testAsyncIOHandleThreadPool(); }
+} testDescription_IOTests_testAsyncIOHandleThreadPool;
+
+static class TestDescription_IOTests_testReadAheadIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testReadAheadIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 501, "testReadAheadIOHandle" ) {}
+ void runTest() { suite_IOTests.testReadAheadIOHandle(); }
+} testDescription_IOTests_testReadAheadIOHandle;
+
+static class TestDescription_IOTests_testBufferedIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testBufferedIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 576, "testBufferedIOHandle" ) {}
+ void runTest() { suite_IOTests.testBufferedIOHandle(); }
+} testDescription_IOTests_testBufferedIOHandle;
+
+static class TestDescription_IOTests_testLatencyIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testLatencyIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 656, "testLatencyIOHandle" ) {}
+ void runTest() { suite_IOTests.testLatencyIOHandle(); }
+} testDescription_IOTests_testLatencyIOHandle;
+
+static class TestDescription_IOTests_testIOStats : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testIOStats() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 698, "testIOStats" ) {}
+ void runTest() { suite_IOTests.testIOStats(); }
+} testDescription_IOTests_testIOStats;
+
+static class TestDescription_IOTests_testPosixIOHandleDirect : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleDirect() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 770, "testPosixIOHandleDirect" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleDirect(); }
+} testDescription_IOTests_testPosixIOHandleDirect;
+
+static class TestDescription_IOTests_testPosixIOHandleFIFO : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleFIFO() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 825, "testPosixIOHandleFIFO" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleFIFO(); }
+} testDescription_IOTests_testPosixIOHandleFIFO;
+
+static class TestDescription_IOTests_testIOReadinessWatch : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testIOReadinessWatch() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 859, "testIOReadinessWatch" ) {}
+ void runTest() { suite_IOTests.testIOReadinessWatch(); }
+} testDescription_IOTests_testIOReadinessWatch;
+
+static class TestDescription_IOTests_testStreamIOHandle : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testStreamIOHandle() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 902, "testStreamIOHandle" ) {}
+ void runTest() { suite_IOTests.testStreamIOHandle(); }
+} testDescription_IOTests_testStreamIOHandle;
+
+static class TestDescription_IOTests_testPosixIOHandleCleanUpRDONLYFile : public CxxTest::RealTestDescription {
+public:
+ TestDescription_IOTests_testPosixIOHandleCleanUpRDONLYFile() : CxxTest::RealTestDescription( Tests_IOTests, suiteDescription_IOTests, 969, "testPosixIOHandleCleanUpRDONLYFile" ) {}
+ void runTest() { suite_IOTests.testPosixIOHandleCleanUpRDONLYFile(); }
+} testDescription_IOTests_testPosixIOHandleCleanUpRDONLYFile;
+
@@ -0,0 +1,31 @@
+/* Generated file, do not edit */
+
+#ifndef CXXTEST_RUNNING
+#define CXXTEST_RUNNING
+#endif
+
+#define _CXXTEST_HAVE_STD
+#include <cxxtest/TestListener.h>
+#include <cxxtest/TestTracker.h>
+#include <cxxtest/TestRunner.h>
+#include <cxxtest/RealDescriptions.h>
+
+#include "/root/repo/src/PPtrListTests.h"
+
+static PageTests suite_PageTests;
+
+static CxxTest::List Tests_PageTests = { 0, 0 };
+CxxTest::StaticSuiteDescription suiteDescription_PageTests( "/root/repo/src/PPtrListTests.h", 48, "PageTests", suite_PageTests, Tests_PageTests );
+
+static class TestDescription_PageTests_testPPtrListBasic : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testPPtrListBasic() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 55, "testPPtrListBasic" ) {}
+ void runTest() { suite_PageTests.testPPtrListBasic(); }
+} testDescription_PageTests_testPPtrListBasic;
+
+static class TestDescription_PageTests_testPPtrListPersistantMove : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testPPtrListPersistantMove() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 262, "testPPtrListPersistantMove" ) {}
+ void runTest() { suite_PageTests.testPPtrListPersistantMove(); }
+} testDescription_PageTests_testPPtrListPersistantMove;
+
@@ -0,0 +1,91 @@
+/* Generated file, do not edit */
+
+#ifndef CXXTEST_RUNNING
+#define CXXTEST_RUNNING
+#endif
+
+#define _CXXTEST_HAVE_STD
+#include <cxxtest/TestListener.h>
+#include <cxxtest/TestTracker.h>
+#include <cxxtest/TestRunner.h>
+#include <cxxtest/RealDescriptions.h>
+
+#include "/root/repo/src/PageBufferTests.h"
+
+static PageBufferTests suite_PageBufferTests;
+
+static CxxTest::List Tests_PageBufferTests = { 0, 0 };
+CxxTest::StaticSuiteDescription suiteDescription_PageBufferTests( "/root/repo/src/PageBufferTests.h", 35, "PageBufferTests", suite_PageBufferTests, Tests_PageBufferTests );
+
+static class TestDescription_PageBufferTests_testChangeSet : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testChangeSet() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 90, "testChangeSet" ) {}
+ void runTest() { suite_PageBufferTests.testChangeSet(); }
+} testDescription_PageBufferTests_testChangeSet;
+
+static class TestDescription_PageBufferTests_testPageBuffer : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBuffer() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 122, "testPageBuffer" ) {}
+ void runTest() { suite_PageBufferTests.testPageBuffer(); }
+} testDescription_PageBufferTests_testPageBuffer;
+
+static class TestDescription_PageBufferTests_testPageBlockIterator : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBlockIterator() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 253, "testPageBlockIterator" ) {}
+ void runTest() { suite_PageBufferTests.testPageBlockIterator(); }
+} testDescription_PageBufferTests_testPageBlockIterator;
+
+static class TestDescription_PageBufferTests_testPageIterator : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageIterator() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 315, "testPageIterator" ) {}
+ void runTest() { suite_PageBufferTests.testPageIterator(); }
+} testDescription_PageBufferTests_testPageIterator;
+
+static class TestDescription_PageBufferTests_testPageInsertSplitDeleteCleanup : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageInsertSplitDeleteCleanup() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 361, "testPageInsertSplitDeleteCleanup" ) {}
+ void runTest() { suite_PageBufferTests.testPageInsertSplitDeleteCleanup(); }
+} testDescription_PageBufferTests_testPageInsertSplitDeleteCleanup;
+
+static class TestDescription_PageBufferTests_testPageBufferExport : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferExport() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 415, "testPageBufferExport" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferExport(); }
+} testDescription_PageBufferTests_testPageBufferExport;
+
+static class TestDescription_PageBufferTests_testPageBufferSave : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferSave() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 453, "testPageBufferSave" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferSave(); }
+} testDescription_PageBufferTests_testPageBufferSave;
+
+static class TestDescription_PageBufferTests_testPageBufferSaveInPlace : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferSaveInPlace() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 497, "testPageBufferSaveInPlace" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferSaveInPlace(); }
+} testDescription_PageBufferTests_testPageBufferSaveInPlace;
+
+static class TestDescription_PageBufferTests_testPageBufferSaveAs : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferSaveAs() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 565, "testPageBufferSaveAs" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferSaveAs(); }
+} testDescription_PageBufferTests_testPageBufferSaveAs;
+
+static class TestDescription_PageBufferTests_testPageBufferFollow : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferFollow() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 638, "testPageBufferFollow" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferFollow(); }
+} testDescription_PageBufferTests_testPageBufferFollow;
+
+static class TestDescription_PageBufferTests_testPageBufferSizing : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferSizing() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 706, "testPageBufferSizing" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferSizing(); }
+} testDescription_PageBufferTests_testPageBufferSizing;
+
+static class TestDescription_PageBufferTests_testPageBufferMappedLoad : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageBufferTests_testPageBufferMappedLoad() : CxxTest::RealTestDescription( Tests_PageBufferTests, suiteDescription_PageBufferTests, 755, "testPageBufferMappedLoad" ) {}
+ void runTest() { suite_PageBufferTests.testPageBufferMappedLoad(); }
+} testDescription_PageBufferTests_testPageBufferMappedLoad;
+
@@ -0,0 +1,85 @@
+/* Generated file, do not edit */
+
+#ifndef CXXTEST_RUNNING
+#define CXXTEST_RUNNING
+#endif
+
+#define _CXXTEST_HAVE_STD
+#include <cxxtest/TestListener.h>
+#include <cxxtest/TestTracker.h>
+#include <cxxtest/TestRunner.h>
+#include <cxxtest/RealDescriptions.h>
+
+#include "/root/repo/src/PageTests.h"
+
+static PageTests suite_PageTests;
+
+static CxxTest::List Tests_PageTests = { 0, 0 };
+CxxTest::StaticSuiteDescription suiteDescription_PageTests( "/root/repo/src/PageTests.h", 32, "PageTests", suite_PageTests, Tests_PageTests );
+
+static class TestDescription_PageTests_testByteArrayClass : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testByteArrayClass() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 39, "testByteArrayClass" ) {}
+ void runTest() { suite_PageTests.testByteArrayClass(); }
+} testDescription_PageTests_testByteArrayClass;
+
+static class TestDescription_PageTests_testBlockFlags : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testBlockFlags() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 91, "testBlockFlags" ) {}
+ void runTest() { suite_PageTests.testBlockFlags(); }
+} testDescription_PageTests_testBlockFlags;
+
+static class TestDescription_PageTests_testByteArraySlices : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testByteArraySlices() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 117, "testByteArraySlices" ) {}
+ void runTest() { suite_PageTests.testByteArraySlices(); }
+} testDescription_PageTests_testByteArraySlices;
+
+static class TestDescription_PageTests_testmCreateBlock : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testmCreateBlock() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 155, "testmCreateBlock" ) {}
+ void runTest() { suite_PageTests.testmCreateBlock(); }
+} testDescription_PageTests_testmCreateBlock;
+
+static class TestDescription_PageTests_testChangeSet : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testChangeSet() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 238, "testChangeSet" ) {}
+ void runTest() { suite_PageTests.testChangeSet(); }
+} testDescription_PageTests_testChangeSet;
+
+static class TestDescription_PageTests_testInsertDeleteBlock : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testInsertDeleteBlock() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 289, "testInsertDeleteBlock" ) {}
+ void runTest() { suite_PageTests.testInsertDeleteBlock(); }
+} testDescription_PageTests_testInsertDeleteBlock;
+
+static class TestDescription_PageTests_testNextPrevBlockIterator : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testNextPrevBlockIterator() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 390, "testNextPrevBlockIterator" ) {}
+ void runTest() { suite_PageTests.testNextPrevBlockIterator(); }
+} testDescription_PageTests_testNextPrevBlockIterator;
+
+static class TestDescription_PageTests_testInsertDelete : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testInsertDelete() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 451, "testInsertDelete" ) {}
+ void runTest() { suite_PageTests.testInsertDelete(); }
+} testDescription_PageTests_testInsertDelete;
+
+static class TestDescription_PageTests_testNextPrevIterator : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testNextPrevIterator() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 532, "testNextPrevIterator" ) {}
+ void runTest() { suite_PageTests.testNextPrevIterator(); }
+} testDescription_PageTests_testNextPrevIterator;
+
+static class TestDescription_PageTests_testmSplitBlocks : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testmSplitBlocks() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 656, "testmSplitBlocks" ) {}
+ void runTest() { suite_PageTests.testmSplitBlocks(); }
+} testDescription_PageTests_testmSplitBlocks;
+
+static class TestDescription_PageTests_testMovingBlocks : public CxxTest::RealTestDescription {
+public:
+ TestDescription_PageTests_testMovingBlocks() : CxxTest::RealTestDescription( Tests_PageTests, suiteDescription_PageTests, 701, "testMovingBlocks" ) {}
+ void runTest() { suite_PageTests.testMovingBlocks(); }
+} testDescription_PageTests_testMovingBlocks;
+
@@ -0,0 +1,598 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <AsyncIOHandle.h>
+#include <WorkerPool.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(HAVE_IO_URING) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define OLLIE_IO_URING 1
+#endif
+
+/*!
+ * Interface to the mechanism that performs the reads
+ */
+class AsyncEngine {
+    public:
+        virtual ~AsyncEngine() { }
+        // Submit a batch of reads
+        virtual void mSubmit( AsyncRequest**, int ) = 0;
+        // Block until the request has completed
+        virtual void mWait( AsyncRequest* ) = 0;
+        virtual bool mIsIOUring( void ) { return false; }
+};
+
+// --- Begin threadengine.cpp ---
+
+/*!
+ * Perform the read described by the request
+ */
+static OffSet asyncPread( AsyncRequest* req ) {
+    OffSet offVal = 0;
+
+    while( ( offVal = pread( req->intFile, req->arrData, req->offSize, req->offOffSet ) ) == -1 ) {
+        if( errno != EINTR ) return -errno;
+    }
+    return offVal;
+}
+
+/*!
+ * Called by a WorkerPool thread
+ */
+void AsyncRequest::mRun( void ) {
+    offResult = asyncPread( this );
+}
+
+/*!
+ * Performs the reads with pread() on a small WorkerPool
+ */
+class ThreadAsyncEngine : public AsyncEngine {
+    public:
+        ThreadAsyncEngine( int intThreads ) : _pool( intThreads ) { }
+        virtual ~ThreadAsyncEngine() { }
+
+        virtual void mSubmit( AsyncRequest**, int );
+        virtual void mWait( AsyncRequest* req ) { _pool.mWait( req ); }
+
+        WorkerPool  _pool;
+};
+
+void ThreadAsyncEngine::mSubmit( AsyncRequest** arrRequests, int intCount ) {
+    for( int i = 0 ; i < intCount ; ++i ) {
+        _pool.mSubmit( arrRequests[i] );
+    }
+}
+
+// --- End threadengine.cpp ---
+
+#ifdef OLLIE_IO_URING
+
+// --- Begin uringengine.cpp ---
+
+/*!
+ * Performs the reads through io_uring, this talks to the kernel
+ * directly so we do not depend on liburing
+ */
+class UringAsyncEngine : public AsyncEngine {
+    public:
+        UringAsyncEngine() : _ioRing(-1), _ptrSq(0), _ptrCq(0), _ptrSqes(0),
+                             _sizeSq(0), _sizeCq(0), _sizeSqes(0) { }
+        virtual ~UringAsyncEngine();
+
+        bool mSetup( unsigned );
+        virtual void mSubmit( AsyncRequest**, int );
+        virtual void mWait( AsyncRequest* );
+        virtual bool mIsIOUring( void ) { return true; }
+        void mReap( void );
+
+        int         _ioRing;
+        char*       _ptrSq;
+        char*       _ptrCq;
+        struct io_uring_sqe* _ptrSqes;
+        size_t      _sizeSq;
+        size_t      _sizeCq;
+        size_t      _sizeSqes;
+
+        unsigned*   _ptrSqTail;
+        unsigned*   _ptrSqMask;
+        unsigned*   _ptrSqArray;
+        unsigned*   _ptrCqHead;
+        unsigned*   _ptrCqTail;
+        unsigned*   _ptrCqMask;
+        struct io_uring_cqe* _ptrCqes;
+};
+
+/*!
+ * Create the ring and map the submission and completion queues
+ */
+bool UringAsyncEngine::mSetup( unsigned intEntries ) {
+    struct io_uring_params params;
+    memset( &params, 0, sizeof(params) );
+
+    if( ( _ioRing = syscall( __NR_io_uring_setup, intEntries, &params ) ) < 0 ) {
+        _ioRing = -1;
+        return false;
+    }
+
+    _sizeSq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _sizeCq = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    _sizeSqes = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    // Newer kernels map both rings with a single mmap()
+    if( params.features & IORING_FEAT_SINGLE_MMAP ) {
+        if( _sizeCq > _sizeSq ) _sizeSq = _sizeCq;
+        _sizeCq = 0;
+    }
+
+    void* ptr = mmap( 0, _sizeSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ioRing, IORING_OFF_SQ_RING );
+    if( ptr == MAP_FAILED ) return false;
+    _ptrSq = static_cast<char*>( ptr );
+
+    if( _sizeCq ) {
+        ptr = mmap( 0, _sizeCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ioRing, IORING_OFF_CQ_RING );
+        if( ptr == MAP_FAILED ) return false;
+        _ptrCq = static_cast<char*>( ptr );
+    } else {
+        _ptrCq = _ptrSq;
+    }
+
+    ptr = mmap( 0, _sizeSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ioRing, IORING_OFF_SQES );
+    if( ptr == MAP_FAILED ) return false;
+    _ptrSqes = static_cast<struct io_uring_sqe*>( ptr );
+
+    _ptrSqTail  = reinterpret_cast<unsigned*>( _ptrSq + params.sq_off.tail );
+    _ptrSqMask  = reinterpret_cast<unsigned*>( _ptrSq + params.sq_off.ring_mask );
+    _ptrSqArray = reinterpret_cast<unsigned*>( _ptrSq + params.sq_off.array );
+    _ptrCqHead  = reinterpret_cast<unsigned*>( _ptrCq + params.cq_off.head );
+    _ptrCqTail  = reinterpret_cast<unsigned*>( _ptrCq + params.cq_off.tail );
+    _ptrCqMask  = reinterpret_cast<unsigned*>( _ptrCq + params.cq_off.ring_mask );
+    _ptrCqes    = reinterpret_cast<struct io_uring_cqe*>( _ptrCq + params.cq_off.cqes );
+
+    return true;
+}
+
+UringAsyncEngine::~UringAsyncEngine() {
+    if( _ptrSqes ) munmap( _ptrSqes, _sizeSqes );
+    if( _ptrCq and _ptrCq != _ptrSq ) munmap( _ptrCq, _sizeCq );
+    if( _ptrSq ) munmap( _ptrSq, _sizeSq );
+    if( _ioRing != -1 ) close( _ioRing );
+}
+
+/*!
+ * Place all the requests on the submission queue, then tell
+ * the kernel about them with a single io_uring_enter()
+ */
+void UringAsyncEngine::mSubmit( AsyncRequest** arrRequests, int intCount ) {
+    unsigned intTail = *_ptrSqTail;
+    unsigned intMask = *_ptrSqMask;
+
+    for( int i = 0 ; i < intCount ; ++i ) {
+        AsyncRequest* req = arrRequests[i];
+        unsigned intIndex = intTail & intMask;
+        struct io_uring_sqe* sqe = &_ptrSqes[ intIndex ];
+
+        req->iov.iov_base = req->arrData;
+        req->iov.iov_len = req->offSize;
+
+        memset( sqe, 0, sizeof(*sqe) );
+        sqe->opcode     = IORING_OP_READV;
+        sqe->fd         = req->intFile;
+        sqe->addr       = reinterpret_cast<unsigned long>( &req->iov );
+        sqe->len        = 1;
+        sqe->off        = req->offOffSet;
+        sqe->user_data  = reinterpret_cast<unsigned long>( req );
+
+        _ptrSqArray[ intIndex ] = intIndex;
+        ++intTail;
+    }
+    __atomic_store_n( _ptrSqTail, intTail, __ATOMIC_RELEASE );
+
+    // The kernel may consume only part of the batch, submit the rest
+    int intSubmitted = 0;
+    int intErr = 0;
+    while( intSubmitted < intCount ) {
+        int intVal = syscall( __NR_io_uring_enter, _ioRing, intCount - intSubmitted, 0, 0, 0, 0 );
+        if( intVal == -1 and errno == EINTR ) continue;
+        if( intVal == -1 ) intErr = errno;
+        if( intVal == 0 ) intErr = EAGAIN;
+        if( intVal <= 0 ) break;
+        intSubmitted += intVal;
+    }
+
+    // The kernel refused the rest of the batch, fail those requests so the caller sees the error
+    if( intSubmitted < intCount ) {
+        for( int i = intSubmitted ; i < intCount ; ++i ) {
+            arrRequests[i]->offResult = -intErr;
+            arrRequests[i]->boolDone = true;
+        }
+        // Take back the entries the kernel did not consume, they are the last ones queued
+        __atomic_store_n( _ptrSqTail, intTail - ( intCount - intSubmitted ), __ATOMIC_RELEASE );
+    }
+}
+
+/*!
+ * Collect all the completed requests from the completion queue
+ */
+void UringAsyncEngine::mReap( void ) {
+    unsigned intHead = *_ptrCqHead;
+    unsigned intTail = __atomic_load_n( _ptrCqTail, __ATOMIC_ACQUIRE );
+
+    while( intHead != intTail ) {
+        struct io_uring_cqe* cqe = &_ptrCqes[ intHead & *_ptrCqMask ];
+        AsyncRequest* req = reinterpret_cast<AsyncRequest*>( cqe->user_data );
+        req->offResult = cqe->res;
+        req->boolDone = true;
+        ++intHead;
+    }
+    __atomic_store_n( _ptrCqHead, intHead, __ATOMIC_RELEASE );
+}
+
+void UringAsyncEngine::mWait( AsyncRequest* req ) {
+    struct pollfd pollRing;
+
+    mReap();
+    while( ! req->boolDone ) {
+        // The kernel owns the buffer until the completion is reaped, so 
+        // if we can not wait in io_uring_enter() wait on the ring instead
+        if( syscall( __NR_io_uring_enter, _ioRing, 0, 1, IORING_ENTER_GETEVENTS, 0, 0 ) == -1 and errno != EINTR ) {
+            pollRing.fd = _ioRing;
+            pollRing.events = POLLIN;
+            pollRing.revents = 0;
+            poll( &pollRing, 1, 10 );
+        }
+        mReap();
+    }
+}
+
+// --- End uringengine.cpp ---
+
+#endif // OLLIE_IO_URING
+
+/*!
+ * AsyncIOHandle Constructor
+ */
+AsyncIOHandle::AsyncIOHandle( int intQueueDepth, OffSet offBlockSize, bool boolAllowIOUring )
+                : _vecRequests( intQueueDepth ), _asyncEngine(0), _offBlockSize( offBlockSize ),
+                  _offPosition(0), _boolAllowIOUring( boolAllowIOUring ), _boolOpen(false) {
+
+    assert( intQueueDepth > 0 );
+
+    // One contiguous allocation for all the request buffers
+    _arrData = new char[ intQueueDepth * offBlockSize ];
+    for( int i = 0 ; i < intQueueDepth ; ++i ) {
+        _vecRequests[i].arrData = _arrData + ( i * offBlockSize );
+    }
+}
+
+/*!
+ * AsyncIOHandle Destructor
+ */
+AsyncIOHandle::~AsyncIOHandle() {
+
+    // Must wait for the reads before freeing their buffers
+    mClose();
+    delete[] _arrData;
+
+}
+
+/*!
+ * Open the file and start the engine that performs our reads
+ */
+bool AsyncIOHandle::mOpen( const char* strFileName, OpenMode mode ) {
+
+    if( _boolOpen ) { mClose(); }
+
+    if( ! PosixIOHandle::mOpen( strFileName, mode ) ) return false;
+
+    _offPosition = 0;
+    _boolOpen = true;
+
+#ifdef OLLIE_IO_URING
+    if( _boolAllowIOUring ) {
+        UringAsyncEngine* engine = new UringAsyncEngine();
+        if( engine->mSetup( _vecRequests.size() ) ) {
+            _asyncEngine = engine;
+        } else {
+            delete engine;
+        }
+    }
+#endif
+
+    // Fall back to a pool of threads, more threads than reads in flight would sit idle
+    if( ! _asyncEngine ) {
+        int intThreads = WorkerPool::mThreadsFor( DEFAULT_ASYNC_THREADS );
+        if( intThreads > int( _vecRequests.size() ) ) intThreads = _vecRequests.size();
+        _asyncEngine = new ThreadAsyncEngine( intThreads );
+    }
+
+    return true;
+}
+
+/*!
+ * Wait for any reads in flight, then close the file
+ */
+bool AsyncIOHandle::mClose( void ) {
+
+    if( _asyncEngine ) {
+        mDrain();
+        delete _asyncEngine;
+        _asyncEngine = 0;
+    }
+
+    _boolOpen = false;
+    return PosixIOHandle::mClose();
+}
+
+bool AsyncIOHandle::mUsingIOUring( void ) {
+    if( _asyncEngine ) return _asyncEngine->mIsIOUring();
+    return false;
+}
+
+/*!
+ * Wait for the request to complete and mark it ready for reading
+ */
+void AsyncIOHandle::mWait( AsyncRequest* req ) {
+    if( req->intState != AsyncRequest::Queued ) return;
+
+    _asyncEngine->mWait( req );
+    req->intState = AsyncRequest::Ready;
+}
+
+/*!
+ * Wait for all the reads in flight and discard everything queued
+ */
+void AsyncIOHandle::mDrain( void ) {
+    for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+        mWait( &_vecRequests[i] );
+        _vecRequests[i].intState = AsyncRequest::Free;
+    }
+}
+
+/*!
+ * Return the offset just past the data the request covers,
+ * until a request completes we assume it will read everything
+ */
+static OffSet asyncEnd( const AsyncRequest* req ) {
+    if( req->intState == AsyncRequest::Ready and req->offResult > 0 ) {
+        return req->offOffSet + req->offResult;
+    }
+    return req->offOffSet + req->offSize;
+}
+
+/*!
+ * Return the request that will hold the data at offset
+ */
+AsyncRequest* AsyncIOHandle::mFindRequest( OffSet offset ) {
+    for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+        AsyncRequest* req = &_vecRequests[i];
+        if( req->intState == AsyncRequest::Free ) continue;
+        if( req->offOffSet <= offset and offset < asyncEnd( req ) ) return req;
+    }
+    return 0;
+}
+
+/*!
+ * Free the requests that are behind the current position, or
+ * too far ahead of it to be useful
+ */
+void AsyncIOHandle::mRecycle( void ) {
+    OffSet offWindow = _offPosition + ( _vecRequests.size() * _offBlockSize );
+
+    for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+        AsyncRequest* req = &_vecRequests[i];
+        if( req->intState == AsyncRequest::Free ) continue;
+
+        if( asyncEnd( req ) <= _offPosition or req->offOffSet >= offWindow ) {
+            mWait( req );
+            req->intState = AsyncRequest::Free;
+        }
+    }
+}
+
+/*!
+ * Queue reads for every block from the current position
+ * forward until we run out of free requests
+ */
+void AsyncIOHandle::mQueueReads( void ) {
+    std::vector<AsyncRequest*> vecSubmit;
+    size_t intFree = 0;
+
+    mRecycle();
+
+    OffSet offNext = _offPosition;
+    for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+        if( _vecRequests[i].intState == AsyncRequest::Free ) ++intFree;
+    }
+
+    // Wait until half the queue is free so we submit in batches,
+    // unless nothing is queued for the current position
+    if( intFree < ( _vecRequests.size() + 1 ) / 2 and mFindRequest( _offPosition ) ) return;
+
+    while( intFree and offNext < _offFileSize ) {
+
+        // Skip over the blocks already queued
+        AsyncRequest* req = mFindRequest( offNext );
+        if( req ) {
+            offNext = asyncEnd( req );
+            continue;
+        }
+
+        // Figure out how much to read, without overlapping a queued request
+        OffSet offSize = _offBlockSize;
+        if( offNext + offSize > _offFileSize ) offSize = _offFileSize - offNext;
+        for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+            AsyncRequest* queued = &_vecRequests[i];
+            if( queued->intState == AsyncRequest::Free ) continue;
+            if( queued->offOffSet > offNext and queued->offOffSet < offNext + offSize ) {
+                offSize = queued->offOffSet - offNext;
+            }
+        }
+
+        // Find a free request
+        for( size_t i = 0 ; i < _vecRequests.size() ; ++i ) {
+            if( _vecRequests[i].intState == AsyncRequest::Free ) {
+                req = &_vecRequests[i];
+                break;
+            }
+        }
+
+        req->offOffSet  = offNext;
+        req->offSize    = offSize;
+        req->offResult  = 0;
+        req->intFile    = _ioFile;
+        req->boolDone   = false;
+        req->intState   = AsyncRequest::Queued;
+
+        vecSubmit.push_back( req );
+        offNext += offSize;
+        --intFree;
+    }
+
+    if( ! vecSubmit.empty() ) {
+        _asyncEngine->mSubmit( &vecSubmit[0], vecSubmit.size() );
+    }
+}
+
+/*!
+ * Seek to a location in the file, reads already queued
+ * for that location are kept
+ */
+OffSet AsyncIOHandle::mSeek( OffSet offset ) {
+    IOStatsTimer timer( _stats, IOStats::Seek );
+
+    if( offset < 0 ) {
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    _offPosition = offset;
+    return _offPosition;
+}
+
+/*!
+ * Copy data out of the queued reads, queuing
+ * more reads as the requests are consumed
+ */
+OffSet AsyncIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offTotal = 0;
+    IOStatsTimer timer( _stats, IOStats::Read );
+
+    assert( _asyncEngine != 0 );
+
+    while( offTotal < offSize and _offPosition < _offFileSize ) {
+
+        mQueueReads();
+
+        AsyncRequest* req = mFindRequest( _offPosition );
+
+        // All the requests are queued ahead of a gap, start over
+        if( ! req ) {
+            mDrain();
+            continue;
+        }
+
+        mWait( req );
+
+        if( req->offResult < 0 ) {
+            mSetError() << "IO Error: Unable to read " << offSize << " bytes from '" << _strName << "' - " <<  strerror( -req->offResult );
+            req->intState = AsyncRequest::Free;
+            return -1;
+        }
+
+        // The file shrank underneath us
+        if( req->offResult == 0 ) {
+            req->intState = AsyncRequest::Free;
+            break;
+        }
+
+        OffSet offLen = ( req->offOffSet + req->offResult ) - _offPosition;
+        if( offLen > offSize - offTotal ) offLen = offSize - offTotal;
+
+        memcpy( cstrBuffer + offTotal, req->arrData + ( _offPosition - req->offOffSet ), offLen );
+        offTotal += offLen;
+        _offPosition += offLen;
+    }
+
+    timer.mSetBytes( offTotal );
+    return offTotal;
+}
+
+/*!
+ * Write at the current position, any queued reads are discarded
+ */
+OffSet AsyncIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
+    OffSet offVal = 0;
+    IOStatsTimer timer( _stats, IOStats::Write );
+
+    mDrain();
+
+    if( ( offVal = pwrite( _ioFile, cstrBuffer, offSize, _offPosition ) ) == -1 ) {
+        mSetError() << "IO Error: Unable to write " << offSize << " bytes to '" << _strName << "' - " <<  strerror( errno );
+        return -1;
+    }
+
+    _offPosition += offVal;
+    if( _offPosition > _offFileSize ) _offFileSize = _offPosition;
+
+    timer.mSetBytes( offVal );
+    return offVal;
+}
+
+/*!
+ * Write all the buffers at the current position with pwritev()
+ */
+OffSet AsyncIOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+    OffSet offVal = 0;
+    IOStatsTimer timer( _stats, IOStats::Write );
+
+    mDrain();
+
+    if( ( offVal = mWriteAllV( _ioFile, arrIov, intCount, _offPosition ) ) == -1 ) {
+        mSetError() << "IO Error: Unable to write " << intCount << " buffers to '" << _strName << "' - " <<  strerror( errno );
+        return -1;
+    }
+
+    _offPosition += offVal;
+    if( _offPosition > _offFileSize ) _offFileSize = _offPosition;
+
+    timer.mSetBytes( offVal );
+    return offVal;
+}
+
+/**
+ * Truncates a file to the specified offset
+ */
+bool AsyncIOHandle::mTruncate( OffSet offset ) {
+
+    mDrain();
+
+    if( ! PosixIOHandle::mTruncate( offset ) ) return false;
+
+    _offFileSize = offset;
+    return true;
+}
@@ -0,0 +1,100 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef ASYNCIOHANDLE_INCLUDE_H
+#define ASYNCIOHANDLE_INCLUDE_H
+
+#include <IOHandle.h>
+#include <WorkerPool.h>
+#include <sys/uio.h>
+#include <vector>
+
+class AsyncEngine;
+
+/*!
+ * A single block read queued with an AsyncEngine, the thread 
+ * engine runs it as a job on a WorkerPool
+ */
+struct AsyncRequest : public WorkerJob {
+
+    // States the AsyncIOHandle tracks for each request
+    enum State { Free, Queued, Ready };
+
+    AsyncRequest( void ) : offOffSet(0), offSize(0), offResult(0), arrData(0),
+                           intFile(0), intState(Free) { }
+
+    virtual void    mRun( void );
+
+    OffSet          offOffSet;
+    OffSet          offSize;
+    // Bytes read, or -errno if the read failed
+    OffSet          offResult;
+    char*           arrData;
+    int             intFile;
+    struct iovec    iov;
+    // Only touched by the AsyncIOHandle
+    int             intState;
+};
+
+/*!
+ *  A Class that keeps several block reads in flight ahead of the
+ *  current position. Reads are submitted in batches through io_uring,
+ *  or through a pool of pread() threads if io_uring is unavailable.
+ */
+class AsyncIOHandle : public PosixIOHandle {
+    public:
+        AsyncIOHandle( int intQueueDepth = DEFAULT_QUEUE_DEPTH,
+                       OffSet offBlockSize = DEFAULT_BLOCK_SIZE, bool boolAllowIOUring = true );
+        virtual ~AsyncIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual int     mWaitForClearToRead( int ) { return 0; }
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual OffSet  mWriteV( const struct iovec*, int );
+        // We track our own position, so copy through mWrite()
+        virtual OffSet  mCopyRange( IOHandle* ioSource, OffSet offSource, OffSet offSize ) {
+            return IOHandle::mCopyRange( ioSource, offSource, offSize );
+        }
+
+        //! Returns true if the reads are submitted through io_uring
+        bool            mUsingIOUring( void );
+
+        void            mQueueReads( void );
+        void            mRecycle( void );
+        void            mDrain( void );
+        void            mWait( AsyncRequest* );
+        AsyncRequest*   mFindRequest( OffSet );
+
+        std::vector<AsyncRequest>   _vecRequests;
+        AsyncEngine*                _asyncEngine;
+        char*                       _arrData;
+        OffSet                      _offBlockSize;
+        OffSet                      _offPosition;
+        bool                        _boolAllowIOUring;
+        // The file is open, the descriptor can be 0 when stdin was closed
+        bool                        _boolOpen;
+};
+
+#endif // ASYNCIOHANDLE_INCLUDE_H
@@ -35,6 +35,11 @@ namespace Ollie {
                     return pageBuffer.mByteArray( it.itPage, intCount );
                 }
 
+                OffSet Buffer::exportBytes( Buffer::Iterator& itStart, Buffer::Iterator& itEnd, int ioFile, 
+                                            bool boolSplice ) {
+                    return pageBuffer.mExport( ioFile, itStart.itPage, itEnd.itPage, boolSplice );
+                }
+
                 int Buffer::insertBytes( Buffer::Iterator& it, const ByteArray& arrBytes ) {
 
                     // Preform the insert
@@ -75,5 +80,82 @@ namespace Ollie {
 
                     return changeSet->mSize();
                 }
+
+                bool Buffer::saveFile( File* file, bool boolInPlace ) {
+
+                    // Only the file we last saved to has our pages in it
+                    if( file->mGetFileName() != strSavedFile ) boolInPlace = false;
+
+                    // Write out the blocks in the buffer
+                    if( pageBuffer.mSave( file, boolInPlace ) < 0 ) return false;
+
+                    // The file now matches the buffer
+                    boolModified = false;
+                    strSavedFile = file->mGetFileName();
+
+                    return true;
+                }
+
+                bool Buffer::saveFileAs( File* file ) {
+
+                    // Saving to the same file, write only what changed
+                    if( file->mGetFileName() == strSavedFile ) return saveFile( file, true );
+
+                    IOHandle* ioOriginal = 0;
+
+                    // Open the last file we saved to, so the pages that 
+                    // did not change can be copied from it
+                    if( ! strSavedFile.empty() ) {
+                        ioOriginal = IOHandle::mGetDefaultIOHandler();
+                        if( ! ioOriginal->mOpen( strSavedFile, IOHandle::ReadOnly ) ) {
+                            delete ioOriginal;
+                            ioOriginal = 0;
+                        }
+                    }
+
+                    OffSet offLen = pageBuffer.mSaveAs( file, ioOriginal );
+                    delete ioOriginal;
+
+                    if( offLen < 0 ) return false;
+
+                    // The new file now matches the buffer
+                    boolModified = false;
+                    strSavedFile = file->mGetFileName();
+
+                    return true;
+                }
+
+                void Buffer::setDefaultPageSize( OffSet offSize ) {
+                    pageBuffer.mSetTargetPageSize( offSize );
+                }
+
+                OffSet Buffer::defaultPageSize( void ) {
+                    return pageBuffer._offTargetPageSize;
+                }
+
+                OffSet Buffer::followFile( File* file, int intSeconds ) {
+
+                    if( ! file->mIsFollowing() and ! file->mFollow() ) return -1;
+
+                    // Read anything appended since the last call
+                    OffSet offLen = pageBuffer.mAppendFile( file );
+
+                    // Nothing new, wait for the file to grow
+                    if( offLen == 0 ) {
+                        int intVal = file->mWaitForAppend( intSeconds );
+                        if( intVal == -1 ) return -1;
+                        if( intVal == 0 ) offLen = pageBuffer.mAppendFile( file );
+                    }
+
+                    if( offLen < 0 ) return -1;
+                    offSize += offLen;
+
+                    // The buffer holds exactly what the file does, save in place from now on
+                    if( strSavedFile.empty() and pageBuffer._offSavedSize == file->mGetOffSet() ) {
+                        strSavedFile = file->mGetFileName();
+                    }
+
+                    return offLen;
+                }
     };
 };
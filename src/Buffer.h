@@ -78,6 +78,10 @@ namespace Ollie {
                 Iterator redo( void );
                 // Get some text from the buffer starting at the iterator and ending at int
                 const ByteArray& getText( Buffer::Iterator&, int );
+                // Write the bytes between the iterators to a file descriptor ( pipe, socket or file )
+                // without copying them, returns the bytes written or -1 with errno set. If boolSplice 
+                // is true pipes share the buffer memory, the buffer must not change until the reader is done
+                OffSet exportBytes( Buffer::Iterator&, Buffer::Iterator&, int, bool boolSplice = false );
 
                 // Buffer Control Methods
                 // -------------------------
@@ -97,12 +101,25 @@ namespace Ollie {
                 bool isModified( void ) { return boolModified; }
                 // Prints the contents of the buffer to stdout ( for debug )
                 void printBuffer( void );
+                // Save the contents of the buffer to the file, returns false on error
+                // the error message is available from the file. If boolInPlace is true
+                // and the file was the last file saved, only the changed pages are written
+                bool saveFile( File*, bool boolInPlace = false );
+                // Save the contents of the buffer to a new file, the pages that have not
+                // changed since the last save are copied from the last file saved
+                bool saveFileAs( File* );
+                // Append the bytes added to the end of the file since the last call, waiting up to
+                // intSeconds for the file to grow. The first call starts following the file and reads
+                // from the files current offset. Returns the bytes appended, or -1 on error
+                OffSet followFile( File*, int intSeconds );
                
             protected:
                 PageBuffer        pageBuffer; 
                 OffSet            offSize;
                 bool              boolModified;
                 Attributes        defaultAttributes;
+                // The name of the last file we saved to
+                std::string       strSavedFile;
         };
 
         class BufferIterator { 
@@ -0,0 +1,328 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#include <BufferedIOHandle.h>
+
+#include <errno.h>
+#include <string.h>
+
+/*!
+ * BufferedIOHandle Constructor
+ */
+BufferedIOHandle::BufferedIOHandle( IOHandle* ioHandle, OffSet offBufferSize )
+                : _ioHandle( ioHandle ), _offBufferSize( offBufferSize ), _offBufferStart(0),
+                  _offBufferLen(0), _boolDirty(false), _offPosition(0), _offWrapped(0), _boolOpen(false) {
+
+    assert( ioHandle != 0 );
+    assert( offBufferSize > 0 );
+
+    _arrBuffer = new char[ offBufferSize ];
+}
+
+/*!
+ * BufferedIOHandle Destructor
+ */
+BufferedIOHandle::~BufferedIOHandle() {
+
+    // Write out anything still in the buffer
+    mClose();
+    delete _ioHandle;
+    delete[] _arrBuffer;
+
+}
+
+/*!
+ * Open the wrapped handle
+ */
+bool BufferedIOHandle::mOpen( const char* strFileName, OpenMode mode ) {
+
+    if( _boolOpen ) { mClose(); }
+
+    if( ! _ioHandle->mOpen( strFileName, mode ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _boolOpen = true;
+
+    _strName        = _ioHandle->mGetName();
+    _offFileSize    = _ioHandle->mGetFileSize();
+    _offDeviceBlock = _ioHandle->mGetDeviceBlockSize();
+    _ioFile         = _ioHandle->_ioFile;
+    _offBufferStart = 0;
+    _offBufferLen   = 0;
+    _boolDirty      = false;
+    _offPosition    = 0;
+    _offWrapped     = 0;
+
+    return true;
+}
+
+/*!
+ * Flush the buffer, then close the wrapped handle
+ */
+bool BufferedIOHandle::mClose( void ) {
+    bool boolResult = true;
+
+    if( _boolOpen ) boolResult = mFlush();
+    _offBufferLen = 0;
+    _ioFile = 0;
+    _boolOpen = false;
+
+    if( ! _ioHandle->mClose() ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    return boolResult;
+}
+
+/*!
+ * Position the wrapped handle at offset, only seeking if it is not already there
+ */
+bool BufferedIOHandle::mSeekWrapped( OffSet offset ) {
+
+    if( _offWrapped == offset ) return true;
+
+    if( _ioHandle->mSeek( offset ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _offWrapped = offset;
+    return true;
+}
+
+/*!
+ * Read from the wrapped handle at the current position
+ */
+OffSet BufferedIOHandle::mReadWrapped( char* cstrBuffer, OffSet offSize ) {
+    OffSet offLen = 0;
+
+    if( ! mSeekWrapped( _offPosition ) ) return -1;
+
+    if( ( offLen = _ioHandle->mRead( cstrBuffer, offSize ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+    _offWrapped += offLen;
+    return offLen;
+}
+
+/*!
+ * Write all the bytes to the wrapped handle at its current position
+ */
+OffSet BufferedIOHandle::mWriteWrapped( const char* cstrBuffer, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize ) {
+        OffSet offLen = _ioHandle->mWrite( cstrBuffer + offTotal, offSize - offTotal );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return -1;
+        }
+        offTotal += offLen;
+        _offWrapped += offLen;
+    }
+    return offTotal;
+}
+
+/*!
+ * Write out the data waiting in the buffer with a single write
+ */
+bool BufferedIOHandle::mFlush( void ) {
+
+    if( ! _boolDirty ) return true;
+
+    if( ! mSeekWrapped( _offBufferStart ) ) return false;
+    if( mWriteWrapped( _arrBuffer, _offBufferLen ) < 0 ) return false;
+
+    _boolDirty = false;
+    _offBufferLen = 0;
+    return true;
+}
+
+/*!
+ * Return 0 if the read will not block
+ */
+int BufferedIOHandle::mWaitForClearToRead( int intSeconds ) {
+
+    // The data is already in the buffer
+    if( ! _boolDirty and _offPosition >= _offBufferStart and _offPosition < _offBufferStart + _offBufferLen ) {
+        return 0;
+    }
+
+    int intVal = _ioHandle->mWaitForClearToRead( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    return intVal;
+}
+
+/*!
+ * Return 0 if the write will not block
+ */
+int BufferedIOHandle::mWaitForClearToWrite( int intSeconds ) {
+
+    // There is room left in the buffer
+    if( _boolDirty and _offBufferLen < _offBufferSize ) return 0;
+
+    int intVal = _ioHandle->mWaitForClearToWrite( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    return intVal;
+}
+
+/*!
+ * Record the new position, the wrapped handle
+ * only seeks when the next read or write needs it
+ */
+OffSet BufferedIOHandle::mSeek( OffSet offset ) {
+
+    if( offset < 0 ) {
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    // Streams can not seek, let the wrapped handle report the error
+    if( ! _ioHandle->mOffersSeek() ) {
+        if( ! mFlush() ) return -1;
+        _offBufferLen = 0;
+        _offWrapped = -1;
+        if( ! mSeekWrapped( offset ) ) return -1;
+    }
+
+    _offPosition = offset;
+    return _offPosition;
+}
+
+/*!
+ * Copy data out of the buffer, refilling the buffer with a
+ * single large read when the position moves past it
+ */
+OffSet BufferedIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    // Write out any data waiting, so we read what was written
+    if( ! mFlush() ) return -1;
+
+    while( offTotal < offSize ) {
+
+        // Copy what the buffer holds at our position
+        if( _offPosition >= _offBufferStart and _offPosition < _offBufferStart + _offBufferLen ) {
+            OffSet offLen = ( _offBufferStart + _offBufferLen ) - _offPosition;
+            if( offLen > offSize - offTotal ) offLen = offSize - offTotal;
+
+            memcpy( cstrBuffer + offTotal, _arrBuffer + ( _offPosition - _offBufferStart ), offLen );
+            _offPosition += offLen;
+            offTotal += offLen;
+            continue;
+        }
+
+        // Already have some data, a stream may not have more ready yet
+        if( offTotal and ! _ioHandle->mOffersSeek() ) break;
+
+        // Reads as large as the buffer skip the copy
+        if( offSize - offTotal >= _offBufferSize ) {
+            OffSet offLen = mReadWrapped( cstrBuffer + offTotal, offSize - offTotal );
+            if( offLen < 0 ) return -1;
+            _offPosition += offLen;
+            offTotal += offLen;
+            break;
+        }
+
+        // Refill the buffer from our position
+        _offBufferLen = 0;
+        _offBufferStart = _offPosition;
+        OffSet offLen = mReadWrapped( _arrBuffer, _offBufferSize );
+        if( offLen < 0 ) return -1;
+
+        // End of the file
+        if( offLen == 0 ) break;
+        _offBufferLen = offLen;
+    }
+
+    return offTotal;
+}
+
+/*!
+ * Copy the data into the buffer, the buffer is written out
+ * when it fills or the next write is not contiguous
+ */
+OffSet BufferedIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
+
+    // Throw away any data we read ahead, the write may change it
+    if( ! _boolDirty ) {
+        _offBufferLen = 0;
+    }
+
+    // Not contiguous with the data waiting, or it will not fit
+    if( _boolDirty and ( _offPosition != _offBufferStart + _offBufferLen 
+                         or _offBufferLen + offSize > _offBufferSize ) ) {
+        if( ! mFlush() ) return -1;
+    }
+
+    // Writes as large as the buffer skip the copy
+    if( offSize >= _offBufferSize ) {
+        if( ! mSeekWrapped( _offPosition ) ) return -1;
+        if( mWriteWrapped( cstrBuffer, offSize ) < 0 ) return -1;
+    } else {
+        if( ! _boolDirty ) {
+            _offBufferStart = _offPosition;
+            _offBufferLen = 0;
+            _boolDirty = true;
+        }
+        memcpy( _arrBuffer + _offBufferLen, cstrBuffer, offSize );
+        _offBufferLen += offSize;
+    }
+
+    _offPosition += offSize;
+    if( _offPosition > _offFileSize ) _offFileSize = _offPosition;
+
+    return offSize;
+}
+
+/*!
+ * Copy each of the buffers into the staging buffer
+ */
+OffSet BufferedIOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+    OffSet offTotal = 0;
+
+    for( int i = 0 ; i < intCount ; ++i ) {
+        OffSet offLen = mWrite( static_cast<const char*>( arrIov[i].iov_base ), arrIov[i].iov_len );
+        if( offLen < 0 ) return -1;
+        offTotal += offLen;
+    }
+    return offTotal;
+}
+
+/*!
+ * Flush the buffer, then truncate the wrapped handle
+ */
+bool BufferedIOHandle::mTruncate( OffSet offset ) {
+
+    if( ! mFlush() ) return false;
+
+    // The data we read ahead might be past the new end of the file
+    _offBufferLen = 0;
+
+    if( ! _ioHandle->mTruncate( offset ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    _offFileSize = offset;
+    return true;
+}
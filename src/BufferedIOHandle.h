@@ -0,0 +1,80 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#ifndef BUFFEREDIOHANDLE_INCLUDE_H
+#define BUFFEREDIOHANDLE_INCLUDE_H
+
+#include <IOHandle.h>
+
+/*!
+ *  A Class that wraps another IOHandle and stages reads and writes
+ *  through a large buffer, so many small block sized calls become
+ *  a few large calls on the wrapped handle. Seeks are only passed
+ *  on when the next read or write needs them.
+ *
+ *  The buffer holds either read ahead data or unwritten data, never
+ *  both. Unwritten data is flushed before reads, truncates and close.
+ *
+ *  The wrapped handle is owned and deleted by this handle
+ */
+class BufferedIOHandle : public IOHandle {
+    public:
+        BufferedIOHandle( IOHandle*, OffSet offBufferSize = DEFAULT_STAGING_SIZE );
+        virtual ~BufferedIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return _ioHandle->mOffersLargeFileSupport(); }
+        virtual bool    mOffersSeek( void ) { return _ioHandle->mOffersSeek(); }
+        virtual int     mWaitForClearToRead( int );
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual IOStats& mGetStats( void ) { return _ioHandle->mGetStats(); }
+        virtual OffSet  mWriteV( const struct iovec*, int );
+
+        //! Write out any data waiting in the buffer
+        bool            mFlush( void );
+
+        bool            mSeekWrapped( OffSet );
+        OffSet          mReadWrapped( char*, OffSet );
+        OffSet          mWriteWrapped( const char*, OffSet );
+
+        IOHandle*       _ioHandle;
+        char*           _arrBuffer;
+        OffSet          _offBufferSize;
+        // The file offset of the first byte in the buffer
+        OffSet          _offBufferStart;
+        // The number of bytes in the buffer
+        OffSet          _offBufferLen;
+        // The buffer holds data not yet written
+        bool            _boolDirty;
+        OffSet          _offPosition;
+        // Where the wrapped handle is positioned
+        OffSet          _offWrapped;
+        // The wrapped handle is open, _ioFile is 0 for handles without a descriptor
+        bool            _boolOpen;
+};
+
+#endif // BUFFEREDIOHANDLE_INCLUDE_H
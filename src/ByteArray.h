@@ -21,39 +21,122 @@
 #ifndef BYTEARRAY_INCLUDE_H
 #define BYTEARRAY_INCLUDE_H
 
+#include <string>
+#include <cstring>
+#include <ostream>
+#include <boost/shared_ptr.hpp>
+
 namespace Ollie {
     namespace OllieBuffer {
 
         static const size_t nPos = std::string::npos;
 
+        /*!
+         * A slice of a reference counted chunk of bytes. Copies and sub strings
+         * share the chunk, so splitting blocks and moving deleted bytes into a
+         * ChangeSet does not copy. The chunk is only written when this slice
+         * is the only one using it, otherwise the slice is copied first.
+         *
+         * A slice keeps the whole chunk alive, even if it only uses part of it
+         */
         class ByteArray {
 
             public: 
-                ByteArray( void ) {}
-                ByteArray( const char* array ) : _strData( array ) {}
-                ByteArray( const char* array, int intLen ) : _strData( array, intLen ) {}
-                ByteArray( const std::string &strData ) : _strData( strData ) {}
-                void mAppend( const ByteArray& b ) { _strData.append( b.str() ); }
-                void mInsert( int p, const ByteArray& b ) { _strData.insert( p, b.str() ); }
-                void mErase( int p, int l ) { _strData.erase( p, l ); }
-                void mClear( void ) { _strData.clear(); }
-                bool mIsEmpty( void ) const { _strData.empty(); }
-                ByteArray mSubStr( int p, int l ) { return ByteArray( _strData.substr( p, l ) ); }
-                size_t mSize( void ) const { return _strData.size(); }
+                ByteArray( void ) : _sizeOffSet(0), _sizeLen(0) {}
+                ByteArray( const char* array ) : _ptrChunk( new std::string( array ) ), _sizeOffSet(0) { 
+                    _sizeLen = _ptrChunk->size(); 
+                }
+                ByteArray( const char* array, int intLen ) : _ptrChunk( new std::string( array, intLen ) ), 
+                                                             _sizeOffSet(0), _sizeLen( intLen ) {}
+                ByteArray( const std::string &strData ) : _ptrChunk( new std::string( strData ) ), 
+                                                          _sizeOffSet(0), _sizeLen( strData.size() ) {}
+
+                void mAppend( const ByteArray& b ) { 
+                    if( b._sizeLen == 0 ) return;
+                    // Nothing here yet, share their chunk
+                    if( _sizeLen == 0 ) { *this = b; return; }
+                    mDetach( b._sizeLen );
+                    _ptrChunk->append( b.mData(), b._sizeLen );
+                    _sizeLen += b._sizeLen;
+                }
+                void mInsert( size_t p, const ByteArray& b ) { 
+                    if( p >= _sizeLen ) { mAppend( b ); return; }
+                    if( b._sizeLen == 0 ) return;
+                    mDetach( b._sizeLen );
+                    _ptrChunk->insert( p, b.mData(), b._sizeLen );
+                    _sizeLen += b._sizeLen;
+                }
+                void mErase( size_t p, size_t l ) { 
+                    if( p >= _sizeLen ) return;
+                    if( l > _sizeLen - p ) l = _sizeLen - p;
+                    // Erasing the start or the end only moves the slice
+                    if( p == 0 ) { 
+                        _sizeOffSet += l; 
+                        _sizeLen -= l; 
+                    } else if( p + l == _sizeLen ) {
+                        _sizeLen -= l;
+                    } else {
+                        mDetach( 0 );
+                        _ptrChunk->erase( p, l );
+                        _sizeLen -= l;
+                    }
+                    if( _sizeLen == 0 ) mClear();
+                }
+                void mClear( void ) { _ptrChunk.reset(); _sizeOffSet = 0; _sizeLen = 0; }
+                bool mIsEmpty( void ) const { return _sizeLen == 0; }
+                ByteArray mSubStr( size_t p, size_t l ) const { 
+                    ByteArray arrSlice;
+                    if( p >= _sizeLen ) return arrSlice;
+                    if( l > _sizeLen - p ) l = _sizeLen - p;
+                    arrSlice._ptrChunk = _ptrChunk;
+                    arrSlice._sizeOffSet = _sizeOffSet + p;
+                    arrSlice._sizeLen = l;
+                    return arrSlice;
+                }
+                size_t mSize( void ) const { return _sizeLen; }
+                const char* mData( void ) const { 
+                    if( ! _ptrChunk ) return "";
+                    return _ptrChunk->data() + _sizeOffSet; 
+                }
 
                 // Implementation Specific ( Users should not rely on these methods existing )
-                friend std::ostream& operator<<( std::ostream& os, const ByteArray& byteArray ) { os << byteArray._strData; }
-                int operator==( const ByteArray& right ) {
-                    if( this->_strData == right._strData ) return 1;
+                friend std::ostream& operator<<( std::ostream& os, const ByteArray& byteArray ) { 
+                    return os.write( byteArray.mData(), byteArray.mSize() ); 
+                }
+                int operator==( const ByteArray& right ) const {
+                    if( _sizeLen != right._sizeLen ) return 0;
+                    if( memcmp( mData(), right.mData(), _sizeLen ) == 0 ) return 1;
                     return 0;
                 }
-                int operator==( const char *right ) {
-                    if( this->_strData == right ) return 1;
+                int operator==( const char *right ) const {
+                    if( _sizeLen != strlen( right ) ) return 0;
+                    if( memcmp( mData(), right, _sizeLen ) == 0 ) return 1;
                     return 0;
                 }
-                const std::string& str() const { return _strData; }
+                std::string str() const { return std::string( mData(), _sizeLen ); }
+
+            protected:
+                // Make the slice the only user of a chunk that starts with the slice,
+                // leaving room to grow by sizeGrow bytes
+                void mDetach( size_t sizeGrow ) {
+                    if( _ptrChunk and _ptrChunk.unique() ) {
+                        // Drop the bytes outside the slice
+                        if( _sizeOffSet + _sizeLen != _ptrChunk->size() ) _ptrChunk->resize( _sizeOffSet + _sizeLen );
+                        if( _sizeOffSet == 0 ) return;
+                        _ptrChunk->erase( 0, _sizeOffSet );
+                        _sizeOffSet = 0;
+                        return;
+                    }
+                    boost::shared_ptr<std::string> ptrChunk( new std::string() );
+                    ptrChunk->reserve( _sizeLen + sizeGrow );
+                    ptrChunk->append( mData(), _sizeLen );
+                    _ptrChunk = ptrChunk;
+                    _sizeOffSet = 0;
+                }
 
-                std::string _strData;
+                boost::shared_ptr<std::string> _ptrChunk;
+                size_t _sizeOffSet;
+                size_t _sizeLen;
         };
 
         // Mostly for tests
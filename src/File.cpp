@@ -19,21 +19,109 @@
  **/
 
 #include <File.h>
+#include <Utf8Validator.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*!
+ * Return the offset of the first chr at or after offPos, offLen if there is none
+ */
+static OffSet findByte( const char* arrData, OffSet offPos, OffSet offLen, char chr ) {
+#ifdef __SSE2__
+    const __m128i vecChr = _mm_set1_epi8( chr );
+
+    for( ; offPos + 16 <= offLen ; offPos += 16 ) {
+        __m128i vecData = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrData + offPos ) );
+        unsigned int intMask = _mm_movemask_epi8( _mm_cmpeq_epi8( vecData, vecChr ) );
+        if( intMask ) return offPos + __builtin_ctz( intMask );
+    }
+#endif
+    for( ; offPos < offLen ; ++offPos ) {
+        if( arrData[ offPos ] == chr ) return offPos;
+    }
+    return offLen;
+}
+
+/*!
+ * Take the CR out of every CRLF in place, returns the new length
+ */
+static OffSet stripCrlf( char* arrData, OffSet offLen ) {
+    OffSet offOut = 0;
+    OffSet offRun = 0;
+    OffSet offPos = 0;
+
+    // Move each run of bytes between the CRs we drop down to the output
+    while( ( offPos = findByte( arrData, offPos, offLen, '\r' ) ) < offLen - 1 ) {
+        if( arrData[ offPos + 1 ] == '\n' ) {
+            if( offOut != offRun ) memmove( arrData + offOut, arrData + offRun, offPos - offRun );
+            offOut += offPos - offRun;
+            offRun = offPos + 1;
+        }
+        ++offPos;
+    }
+
+    if( offOut != offRun ) memmove( arrData + offOut, arrData + offRun, offLen - offRun );
+    return offOut + ( offLen - offRun );
+}
+
+/*!
+ * Append the data to the vector with a CR before every LF
+ */
+static void expandLf( const char* arrData, OffSet offLen, std::vector<char>& vecOut ) {
+    OffSet offRun = 0;
+    OffSet offPos = 0;
+
+    while( ( offPos = findByte( arrData, offRun, offLen, '\n' ) ) < offLen ) {
+        vecOut.insert( vecOut.end(), arrData + offRun, arrData + offPos );
+        vecOut.push_back( '\r' );
+        vecOut.push_back( '\n' );
+        offRun = offPos + 1;
+    }
+    vecOut.insert( vecOut.end(), arrData + offRun, arrData + offLen );
+}
 
 /*!
  * File Constructor
  */
 File::File( IOHandle* const ioHandle ) {
     _ioHandle       = ioHandle;
-    _offBlockSize   = DEFAULT_BLOCK_SIZE;
     _offCurrent     = 0;
     _intTimeout     = 0;
+    _ioNotify       = -1;
+    mSetBlockSize( DEFAULT_BLOCK_SIZE );
+}
+
+/*!
+ * Set the size of the blocks we read, if the IOHandle reads whole 
+ * device blocks ( direct IO ) the size is rounded up to the alignment
+ */
+void File::mSetBlockSize( OffSet offSize ) {
+    OffSet offAlignment = 1;
+
+    if( _ioHandle ) offAlignment = _ioHandle->mGetAlignment();
+    if( offAlignment > 1 and offSize % offAlignment ) {
+        offSize = ( ( offSize / offAlignment ) + 1 ) * offAlignment;
+    }
+    _offBlockSize = offSize;
 }
 
 /*!
  * File Destructor
  */
 File::~File() {
+    if( _ioNotify != -1 ) {
+        close( _ioNotify );
+    }
     if( _ioHandle ) {
         delete _ioHandle;
     }
@@ -57,6 +145,80 @@ IOHandle* File::mGetIOHandler( void ) {
     return 0;
 }
 
+/*!
+ * Point the caller at the next block of data without copying it,
+ * only Files that read directly from a mapped IOHandle can do this
+ */
+OffSet File::mMapNextBlock( const char**, Attributes& ) {
+    mSetError("Current File type does not support mapped blocks");
+    return -1;
+}
+
+/*!
+ * Read the next intCount blocks into arrBuffer, which must hold 
+ * intCount * mGetBlockSize() bytes, and point arrIov at each block.
+ * Returns the number of blocks read, 0 at the end of the file or -1 on
+ * error. Files that can read many blocks at once should override this
+ */
+int File::mReadBlocks( int intCount, char* arrBuffer, struct iovec* arrIov, Attributes* arrAttr ) {
+    int intBlocks = 0;
+
+    for( ; intBlocks < intCount ; ++intBlocks ) {
+        char* arrBlockData = arrBuffer + ( intBlocks * _offBlockSize );
+
+        OffSet offLen = mReadNextBlock( arrBlockData, arrAttr[ intBlocks ] );
+        if( offLen < 0 ) return -1;
+        if( offLen == 0 ) break;
+
+        arrIov[ intBlocks ].iov_base = arrBlockData;
+        arrIov[ intBlocks ].iov_len = offLen;
+    }
+    return intBlocks;
+}
+
+/*!
+ * Write out several blocks starting at the current offset, Files
+ * that can hand the blocks to the IO in one call should override this
+ */
+OffSet File::mWriteBlocks( const struct iovec* arrIov, const Attributes* arrAttr, int intCount ) {
+    OffSet offTotal = 0;
+
+    for( int i = 0 ; i < intCount ; ++i ) {
+        Attributes attr( arrAttr[i] );
+        OffSet offLen = mWriteNextBlock( static_cast<const char*>( arrIov[i].iov_base ), arrIov[i].iov_len, attr );
+        if( offLen < 0 ) return -1;
+        offTotal += offLen;
+    }
+    return offTotal;
+}
+
+/*!
+ * Copy blocks another IOHandle holds to the current offset, only Files 
+ * that store the blocks unchanged ( see mOffersInPlaceSave() ) can do this
+ */
+OffSet File::mCopyBlocks( IOHandle*, OffSet, OffSet ) {
+    mSetError("Current File type does not support copying blocks");
+    return -1;
+}
+
+/*!
+ * Watch the file for appended bytes, only Files that map 
+ * file offsets directly to buffer offsets can follow a file
+ */
+bool File::mFollow( void ) {
+    mSetError("Current File type does not support following appends");
+    return false;
+}
+
+/*!
+ * Wait for bytes to be appended to the file we are following
+ * Return 0 if the file changed, 1 if we timed out, -1 on error
+ */
+int File::mWaitForAppend( int ) {
+    mSetError("Current File type does not support following appends");
+    return -1;
+}
+
 /*
  * Write out a block of text at a specific offset
  */
@@ -82,6 +244,17 @@ OffSet Utf8File::mWriteBlock( OffSet offset, const char* arrBlockData, OffSet of
 OffSet Utf8File::mWriteNextBlock( const char* arrBlockData, OffSet offBlockSize, Attributes &attr ) {
     assert( _ioHandle != 0 );
 
+    // The block needs the CR put back
+    if( _intLineEnding == FileIdentity::CRLF or attr.mHasFlag( Attributes::Crlf ) ) {
+        struct iovec iov;
+        iov.iov_base = const_cast<char*>( arrBlockData );
+        iov.iov_len = offBlockSize;
+        return mWriteExpanded( &iov, &attr, 1 );
+    }
+
+    // Write where the caller thinks we are
+    if( ! mDropCarry() ) return -1;
+
     // If we timeout waiting on clear to read
     if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
         mSetError( _ioHandle->mGetError() );
@@ -104,11 +277,213 @@ OffSet Utf8File::mWriteNextBlock( const char* arrBlockData, OffSet offBlockSize,
 
 }
 
+/*
+ * Write out several blocks of text starting at the last write offset
+ * with a single vectored write
+ *
+ * Since utf8 files have no additional attributes, we ignore the 
+ * attributes passed
+ */
+OffSet Utf8File::mWriteBlocks( const struct iovec* arrIov, const Attributes* arrAttr, int intCount ) {
+    assert( _ioHandle != 0 );
+
+    // Some of the blocks need the CR put back
+    for( int i = 0 ; i < intCount ; ++i ) {
+        if( _intLineEnding == FileIdentity::CRLF or arrAttr[i].mHasFlag( Attributes::Crlf ) ) {
+            return mWriteExpanded( arrIov, arrAttr, intCount );
+        }
+    }
+
+    // Write where the caller thinks we are
+    if( ! mDropCarry() ) return -1;
+
+    // If we timeout waiting on clear to write
+    if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    OffSet offLen = 0;
+
+    // Write out all the blocks
+    if( ( offLen = _ioHandle->mWriteV( arrIov, intCount ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    // Keep track of where in the file we are
+    _offCurrent += offLen;
+
+    // Tell the caller how many bytes we wrote
+    return offLen;
+
+}
+
+/*
+ * Write the blocks with a CR before each LF of the blocks from a CRLF 
+ * file, returns the number of bytes of the blocks written ( without the CRs )
+ */
+OffSet Utf8File::mWriteExpanded( const struct iovec* arrIov, const Attributes* arrAttr, int intCount ) {
+    OffSet offTotal = 0;
+
+    // Write where the caller thinks we are
+    if( ! mDropCarry() ) return -1;
+
+    _vecExpand.clear();
+    for( int i = 0 ; i < intCount ; ++i ) {
+        const char* arrData = static_cast<const char*>( arrIov[i].iov_base );
+
+        if( _intLineEnding == FileIdentity::CRLF or arrAttr[i].mHasFlag( Attributes::Crlf ) ) {
+            expandLf( arrData, arrIov[i].iov_len, _vecExpand );
+        } else {
+            _vecExpand.insert( _vecExpand.end(), arrData, arrData + arrIov[i].iov_len );
+        }
+        offTotal += arrIov[i].iov_len;
+    }
+
+    // The caller can not resume a short write in the middle of a CRLF, so write it all
+    OffSet offDone = 0;
+    while( offDone < OffSet( _vecExpand.size() ) ) {
+        // If we timeout waiting on clear to write
+        if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+            mSetError( _ioHandle->mGetError() );
+            return -1;
+        }
+
+        OffSet offLen = _ioHandle->mWrite( &_vecExpand[ offDone ], _vecExpand.size() - offDone );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return -1;
+        }
+        offDone += offLen;
+    }
+
+    // Keep track of where in the file we are
+    _offCurrent += offDone;
+
+    return offTotal;
+}
+
+/*
+ * Copy offSize bytes of text from the source IO to the last write offset, 
+ * the IO will avoid copying the data through memory if it can
+ */
+OffSet Utf8File::mCopyBlocks( IOHandle* ioSource, OffSet offSource, OffSet offSize ) {
+    assert( _ioHandle != 0 );
+
+    // Write where the caller thinks we are
+    if( ! mDropCarry() ) return -1;
+
+    // If we timeout waiting on clear to write
+    if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    OffSet offLen = 0;
+
+    // Copy the range
+    if( ( offLen = _ioHandle->mCopyRange( ioSource, offSource, offSize ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    // Keep track of where in the file we are
+    _offCurrent += offLen;
+
+    // Tell the caller how many bytes we copied
+    return offLen;
+
+}
+
+/*!
+ * Watch the file with inotify, the bytes appended after 
+ * the current offset can then be read with mReadNextBlock()
+ */
+bool Utf8File::mFollow( void ) {
+    assert( _ioHandle != 0 );
+
+    if( _ioNotify != -1 ) return true;
+
+#ifdef __linux__
+    if( ( _ioNotify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) ) == -1 ) {
+        mSetError() << "IO Error: Unable to create inotify instance - " << strerror( errno );
+        return false;
+    }
+
+    if( inotify_add_watch( _ioNotify, mGetFileName().c_str(), IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF ) == -1 ) {
+        mSetError() << "IO Error: Unable to watch '" << mGetFileName() << "' - " << strerror( errno );
+        close( _ioNotify );
+        _ioNotify = -1;
+        return false;
+    }
+    return true;
+#else
+    mSetError("Following appends is not supported on this platform");
+    return false;
+#endif
+}
+
+/*!
+ * Wait for the file to be written to, the caller reads from the 
+ * current offset to the end of the file when we return 0
+ * Return 0 if the file changed, 1 if we timed out, -1 on error
+ * The file being truncated, moved or deleted is an error, 
+ * the caller should reload the file
+ */
+int Utf8File::mWaitForAppend( int intSeconds ) {
+#ifdef __linux__
+    char arrEvents[ 4096 ] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+    struct pollfd pfd;
+    struct stat sb;
+    int intMask = 0;
+
+    if( _ioNotify == -1 and ! mFollow() ) return -1;
+
+    pfd.fd = _ioNotify;
+    pfd.events = POLLIN;
+
+    int intVal = 0;
+    while( ( intVal = poll( &pfd, 1, intSeconds * 1000 ) ) == -1 and errno == EINTR );
+
+    if( intVal == -1 ) {
+        mSetError() << "IO Error: Unable to wait for '" << mGetFileName() << "' - " << strerror( errno );
+        return -1;
+    }
+    if( intVal == 0 ) return 1;
+
+    // Collect all the events waiting, many writes only need one read
+    ssize_t intLen = 0;
+    while( ( intLen = read( _ioNotify, arrEvents, sizeof( arrEvents ) ) ) > 0 ) {
+        for( char* ptr = arrEvents ; ptr < arrEvents + intLen ; ) {
+            struct inotify_event* event = reinterpret_cast<struct inotify_event*>( ptr );
+            intMask |= event->mask;
+            ptr += sizeof( struct inotify_event ) + event->len;
+        }
+    }
+
+    if( intMask & ( IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED ) ) {
+        mSetError() << "IO Error: '" << mGetFileName() << "' was moved or deleted";
+        return -1;
+    }
+
+    // The file shrank underneath us, the bytes we have are no longer valid
+    if( stat( mGetFileName().c_str(), &sb ) == 0 and sb.st_size < _offCurrent ) {
+        mSetError() << "IO Error: '" << mGetFileName() << "' was truncated";
+        return -1;
+    }
+
+    return 0;
+#else
+    return File::mWaitForAppend( intSeconds );
+#endif
+}
+
 /*!
  *  Return the size of the next block read will return
- *  Utf8File will always return the max block size because
- *  Utf8File does not assign attributes so all the block sizes 
- *  are the same, unless it is the end of the file ( Last block read )
+ *  Utf8File will always return the max block size unless 
+ *  it is the end of the file ( Last block read ), the block 
+ *  read may be up to 3 bytes shorter so it ends on a code point
  */
 OffSet Utf8File::mPeekNextBlock( void ) {
 
@@ -139,12 +514,256 @@ OffSet Utf8File::mReadNextBlock( char* arrBlockData, Attributes &attr ) {
 
     OffSet offLen = 0;
 
+    // The block starts with the bytes the last block held back
+    memcpy( arrBlockData, _arrCarry, _intCarry );
+
     // Read in the block from the IO
-    if( ( offLen = _ioHandle->mRead( arrBlockData, _offBlockSize ) ) < 0 ) {
+    if( ( offLen = _ioHandle->mRead( arrBlockData + _intCarry, _offBlockSize - _intCarry ) ) < 0 ) {
         mSetError( _ioHandle->mGetError() );
         return -1;
     }
 
+    offLen += _intCarry;
+    _intCarry = 0;
+
+    OffSet offRead = offLen;
+
+    offLen = mTrimBlock( arrBlockData, offLen, attr );
+    if( _boolNormalize ) {
+        offLen = mNormalizeBlock( arrBlockData, offLen, attr );
+    } else {
+        attr.mSetFlag( Attributes::Crlf, false );
+    }
+
+    // Keep track of where in the file we are, the bytes held back are read again
+    _offCurrent += offRead - _intCarry;
+
+    // Tell the caller how many bytes are in the block of data
+    return offLen;
+
+}
+
+/*
+ * Read the next intCount blocks with a single read and split it 
+ * into blocks that end on code points. See File::mReadBlocks()
+ */
+int Utf8File::mReadBlocks( int intCount, char* arrBuffer, struct iovec* arrIov, Attributes* arrAttr ) {
+    assert( _ioHandle != 0 );
+
+    if( intCount < 1 ) return 0;
+
+    // If we timeout waiting on clear to read
+    if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    // Each block may end up to 3 bytes short of the block size so it ends
+    // on a code point, read no more than what is sure to fit in intCount blocks
+    OffSet offRead = ( intCount * _offBlockSize ) - ( ( intCount - 1 ) * 3 );
+    if( offRead < _offBlockSize ) offRead = _offBlockSize;
+
+    OffSet offLen = 0;
+
+    // The data starts with the bytes the last block held back
+    memcpy( arrBuffer, _arrCarry, _intCarry );
+
+    if( ( offLen = _ioHandle->mRead( arrBuffer + _intCarry, offRead - _intCarry ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    offLen += _intCarry;
+    _intCarry = 0;
+    offRead = offLen;
+
+    // Trim and normalize it all at once, the blocks share the attributes
+    Attributes attr;
+    offLen = mTrimBlock( arrBuffer, offLen, attr );
+    bool boolValid = attr.mHasFlag( Attributes::Utf8Validated );
+    if( _boolNormalize ) offLen = mNormalizeBlock( arrBuffer, offLen, attr );
+
+    // Keep track of where in the file we are, the bytes held back are read again
+    _offCurrent += offRead - _intCarry;
+
+    int intBlocks = 0;
+    OffSet offPos = 0;
+    while( offPos < offLen and intBlocks < intCount ) {
+        OffSet offSize = offLen - offPos;
+        if( offSize > _offBlockSize ) {
+            offSize = _offBlockSize;
+
+            // Never cut the block to nothing ( IE: invalid UTF-8 )
+            OffSet offBoundary = Utf8Validator::mBoundary( arrBuffer + offPos, offSize );
+            if( offBoundary ) offSize = offBoundary;
+        }
+
+        arrIov[ intBlocks ].iov_base = arrBuffer + offPos;
+        arrIov[ intBlocks ].iov_len = offSize;
+        arrAttr[ intBlocks ] = attr;
+
+        // Valid data split on code points is valid, only check the blocks of invalid data
+        if( ! boolValid ) {
+            arrAttr[ intBlocks ].mSetFlag( Attributes::Utf8Validated, Utf8Validator::mValidate( arrBuffer + offPos, offSize ) );
+        }
+
+        offPos += offSize;
+        ++intBlocks;
+    }
+
+    return intBlocks;
+}
+
+/*
+ * Hold back a sequence cut off by the end of the block and 
+ * flag the block if it is valid UTF-8, returns the new length
+ */
+OffSet Utf8File::mTrimBlock( char* arrBlockData, OffSet offLen, Attributes &attr ) {
+
+    OffSet offBoundary = Utf8Validator::mBoundary( arrBlockData, offLen );
+
+    // Never trim the block to nothing ( IE: a cut off sequence at the end of the file ), 
+    // unless we follow the file, then the writer may not have appended the rest yet
+    if( offBoundary != offLen and ( offBoundary != 0 or mIsFollowing() ) ) {
+        _intCarry = offLen - offBoundary;
+        memcpy( _arrCarry, arrBlockData + offBoundary, _intCarry );
+        offLen = offBoundary;
+    }
+
+    attr.mSetFlag( Attributes::Utf8Validated, Utf8Validator::mValidate( arrBlockData, offLen ) );
+
+    return offLen;
+}
+
+/*
+ * Take the CR out of the CRLFs if every line ending in the block is a CRLF, 
+ * so the save can put back exactly what was read. Blocks that mix line endings
+ * are left alone. A CR at the end of the block is held back in case the LF 
+ * starts the next block. Returns the new length
+ */
+OffSet Utf8File::mNormalizeBlock( char* arrBlockData, OffSet offLen, Attributes &attr ) {
+
+    // Never trim the block to nothing ( IE: a CR at the end of the file )
+    if( ! _intCarry and offLen > 1 and arrBlockData[ offLen - 1 ] == '\r' ) {
+        _arrCarry[ 0 ] = '\r';
+        _intCarry = 1;
+        --offLen;
+    }
+
+    // A CR held back by the last block is at the start of this one
+    int intLineEnding = FileIdentity::None;
+    OffSet offLF = 0;
+    while( ( offLF = findByte( arrBlockData, offLF, offLen, '\n' ) ) < offLen ) {
+        int intFound = FileIdentity::LF;
+        if( offLF and arrBlockData[ offLF - 1 ] == '\r' ) intFound = FileIdentity::CRLF;
+
+        if( intLineEnding == FileIdentity::None ) intLineEnding = intFound;
+        if( intLineEnding != intFound ) {
+            intLineEnding = FileIdentity::Mixed;
+            break;
+        }
+        ++offLF;
+    }
+
+    // The file is mixed once a block disagrees with the blocks before it
+    if( intLineEnding != FileIdentity::None ) {
+        if( _intLineEnding == FileIdentity::None ) _intLineEnding = intLineEnding;
+        if( _intLineEnding != intLineEnding ) _intLineEnding = FileIdentity::Mixed;
+    }
+
+    bool boolCrlf = ( intLineEnding == FileIdentity::CRLF );
+    if( boolCrlf ) offLen = stripCrlf( arrBlockData, offLen );
+
+    attr.mSetFlag( Attributes::Crlf, boolCrlf );
+    return offLen;
+}
+
+/*
+ * Put the handle back at the current offset if 
+ * the last read held back the end of the block
+ */
+bool Utf8File::mDropCarry( void ) {
+
+    if( ! _intCarry ) return true;
+    _intCarry = 0;
+
+    if( ! _ioHandle->mOffersSeek() ) return true;
+
+    if( _ioHandle->mSeek( _offCurrent ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Point arrBlockData at the next block of text in the IO without 
+ * copying it, the pointer is valid until the IOHandle is closed
+ *
+ * Since utf8 files have no additional attributes, we ignore the 
+ * attributes reference passed
+ */
+OffSet Utf8File::mMapNextBlock( const char** arrBlockData, Attributes &attr ) {
+    assert( _ioHandle != 0 );
+
+    // If the IO handle can not hand out pointers to it's data
+    if( ! _ioHandle->mOffersMap() ) {
+        mSetError("Current IO Device does not support mapped reads");
+        return -1;
+    }
+
+    // If we timeout waiting on clear to read
+    if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    // The block points at the file, there is no taking the CR out
+    if( _boolNormalize and _intLineEnding == FileIdentity::CRLF ) {
+        mSetError("Mapped reads can not normalize CRLF line endings");
+        return -1;
+    }
+
+    OffSet offLen = 0;
+
+    if( ! mDropCarry() ) return -1;
+
+    // Map the block from the IO
+    if( ( offLen = _ioHandle->mMap( arrBlockData, _offBlockSize ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    // End the block on a code point, the handle can seek as it offers maps
+    OffSet offBoundary = Utf8Validator::mBoundary( *arrBlockData, offLen );
+    if( offBoundary != offLen and offBoundary != 0 ) {
+        if( _ioHandle->mSeek( _offCurrent + offBoundary ) == -1 ) {
+            mSetError( _ioHandle->mGetError() );
+            return -1;
+        }
+        offLen = offBoundary;
+    }
+
+    // Find out if the file has CRLF line endings before handing out the block
+    if( _boolNormalize and _intLineEnding == FileIdentity::None ) {
+        OffSet offLF = findByte( *arrBlockData, 0, offLen, '\n' );
+        if( offLF < offLen ) {
+            _intLineEnding = FileIdentity::LF;
+            if( offLF and (*arrBlockData)[ offLF - 1 ] == '\r' ) {
+                _intLineEnding = FileIdentity::CRLF;
+                if( _ioHandle->mSeek( _offCurrent ) == -1 ) {
+                    mSetError( _ioHandle->mGetError() );
+                    return -1;
+                }
+                mSetError("Mapped reads can not normalize CRLF line endings");
+                return -1;
+            }
+        }
+    }
+
+    attr.mSetFlag( Attributes::Utf8Validated, Utf8Validator::mValidate( *arrBlockData, offLen ) );
+    attr.mSetFlag( Attributes::Crlf, false );
+
     // Keep track of where in the file we are
     _offCurrent += offLen;
 
@@ -190,6 +809,7 @@ OffSet Utf8File::mSetOffSet( OffSet offset ) {
 
     // Record our offset
     _offCurrent = offset;
+    _intCarry = 0;
 
     return _offCurrent;
 }
@@ -212,6 +832,9 @@ bool Utf8File::mPrepareLoad( void ) {
 
     // Set the file offset to the begining of the file
     if( mSetOffSet( 0 ) != 0 ) return false;
+
+    // Find the line endings again as we read
+    if( _boolNormalize ) _intLineEnding = FileIdentity::None;
     return true;
 
 }
@@ -23,6 +23,8 @@
 
 #include <IOHandle.h>
 #include <Ollie.h>
+#include <vector>
+#include <deque>
 
 /*! 
  * Class hold all the attributes associated with a block of data
@@ -30,10 +32,10 @@
 class Attributes {
 
     public:
-        Attributes( void ) : _intValue(0) { }
-        Attributes( int intValue ) : _intValue(intValue) { }
+        Attributes( void ) : _intValue(0), _intFlags(0) { }
+        Attributes( int intValue ) : _intValue(intValue), _intFlags(0) { }
         ~Attributes() { }
-        Attributes( const Attributes &a ) : _intValue(a._intValue) { }
+        Attributes( const Attributes &a ) : _intValue(a._intValue), _intFlags(a._intFlags) { }
         int operator==( const Attributes &right ) const {
             if( _intValue == right._intValue ) return 1;
             return 0;
@@ -43,7 +45,43 @@ class Attributes {
             return 0;
         }
         inline int mTestValue( void ) const { return _intValue; }
+
+        //! Flags a File sets on the blocks it reads, Crlf blocks had 
+        //! CRLF line endings in the file and are saved with them again.
+        //! The flags are not part of the value and are not compared
+        enum Flags { Utf8Validated = 1, Crlf = 2 };
+        inline bool mHasFlag( int intFlag ) const { return ( _intFlags & intFlag ) != 0; }
+        inline void mSetFlag( int intFlag, bool boolSet ) { 
+            if( boolSet ) _intFlags |= intFlag;
+            else _intFlags &= ~intFlag;
+        }
+
         int _intValue;
+        int _intFlags;
+};
+
+/*!
+ * What File::mSniff() found in the first few KB of a file
+ */
+class FileIdentity {
+
+    public:
+        enum Format { Text, Gzip, Zstd, Binary };
+        enum Encoding { Utf8, Utf16LE, Utf16BE, Latin1 };
+        // Mixed files have blocks with both LF and CRLF line endings
+        enum LineEnding { None, LF, CRLF, CR, Mixed };
+
+        FileIdentity( void ) : _intFormat(Text), _intEncoding(Utf8), _intLineEnding(None), 
+                               _intBomSize(0), _offNulls(0), _offSize(0) { }
+
+        int         _intFormat;
+        int         _intEncoding;
+        int         _intLineEnding;
+        // The size of the byte order mark, 0 if there was none
+        int         _intBomSize;
+        OffSet      _offNulls;
+        // How many bytes were sniffed
+        OffSet      _offSize;
 };
 
 /*! 
@@ -54,7 +92,8 @@ class File : public OllieCommon {
     public: 
        File( IOHandle* const );
        virtual ~File();
-       static File* mIdentifyFile( IOHandle* );
+       static File* mIdentifyFile( IOHandle*, FileIdentity* identity = 0 );
+       static void  mSniff( const char*, OffSet, FileIdentity& );
 
        // Virtual Methods
        virtual OffSet       mPeekNextBlock( void ) = 0;
@@ -67,58 +106,357 @@ class File : public OllieCommon {
        virtual bool         mPrepareLoad( void ) = 0;
        virtual bool         mFinalizeSave( void ) = 0;
        virtual bool         mFinalizeLoad( void ) = 0;
+       virtual OffSet       mMapNextBlock( const char**, Attributes &attr );
+       //! Can mMapNextBlock() hand out the blocks of this file?
+       virtual bool         mOffersMap( void ) { return false; }
+       //! Read up to intCount blocks into a buffer of intCount * mGetBlockSize() bytes
+       virtual int          mReadBlocks( int intCount, char*, struct iovec*, Attributes* );
+       virtual OffSet       mWriteBlocks( const struct iovec*, const Attributes*, int );
+       //! Do buffer offsets map directly to file offsets, so blocks can be rewritten in place?
+       virtual bool         mOffersInPlaceSave( void ) { return false; }
+       virtual OffSet       mCopyBlocks( IOHandle*, OffSet, OffSet );
+       //! Start watching the file for bytes appended after the current offset
+       virtual bool         mFollow( void );
+       virtual int          mWaitForAppend( int );
 
        // Methods
-       void          mSetBlockSize( OffSet offSize ) { _offBlockSize = offSize; }
+       void          mSetBlockSize( OffSet );
        OffSet        mGetBlockSize( void ) { return _offBlockSize; }
        void          mSetTimeOut( int seconds ) { _intTimeout = seconds; }
        IOHandle*     mGetIOHandler( void );
        std::string&  mGetFileName( void );
        OffSet        mGetFileSize( void ) { return _ioHandle->mGetFileSize(); }
        OffSet        mGetOffSet( void ) const { return _offCurrent; }
+       bool          mIsFollowing( void ) const { return _ioNotify != -1; }
+       //! The IO counters for the handle this file reads and writes through
+       IOStats&      mGetStats( void ) { return _ioHandle->mGetStats(); }
 
        // Members
        IOHandle*    _ioHandle;
        OffSet       _offBlockSize;
        OffSet       _offCurrent;
        int          _intTimeout;
+       // The inotify instance watching the file in follow mode
+       int          _ioNotify;
 
 };
 
 
+struct z_stream_s;
+class GzipCheckpoint;
+class GzipJob;
+class WorkerPool;
+
 /*!
  * This class reads and writes gzip files. 
+ *
+ * While reading, the inflater records a checkpoint ( the last 32K of 
+ * output and the bit position in the compressed data ) every offSpan 
+ * bytes, so mSetOffSet() can resume inflating from the nearest checkpoint
+ * instead of from the start of the file. Files made of several gzip
+ * members ( IE: concatenated logs ) are read as one file. 
+ *
+ * Offsets are always in uncompressed bytes, files are written in order.
+ * When more than one thread is available, saving splits the data into
+ * DEFAULT_GZIP_CHUNK sized chunks and deflates them on a pool of threads,
+ * each chunk primed with the last 32K of the chunk before it. The
+ * chunks are written in order as a single gzip member
  */
 class GzipFile : public File {
     
     public:
-       GzipFile( IOHandle* const ioHandle ) : File( ioHandle ) { }
-       ~GzipFile() { }
-        // All the virtual methods implemented
+       GzipFile( IOHandle* const ioHandle, OffSet offSpan = DEFAULT_GZIP_SPAN );
+       ~GzipFile();
+
+       virtual OffSet  mPeekNextBlock( void );
+       virtual OffSet  mReadBlock( OffSet, char*, Attributes& );
+       virtual OffSet  mReadNextBlock( char*, Attributes& );
+       virtual OffSet  mWriteBlock( OffSet, const char*, OffSet, Attributes& );
+       virtual OffSet  mWriteNextBlock( const char*, OffSet, Attributes& );
+       virtual OffSet  mSetOffSet( OffSet );
+       virtual bool    mPrepareSave( void );
+       virtual bool    mPrepareLoad( void );
+       virtual bool    mFinalizeSave( void );
+       virtual bool    mFinalizeLoad( void );
+
+       //! The number of checkpoints recorded so far
+       int             mGetCheckpoints( void ) { return _vecCheckpoints.size(); }
+       //! The threads used to compress on save, 0 uses one per CPU
+       void            mSetThreads( int intThreads ) { _intThreads = intThreads; }
+
+       bool            mResetInflate( GzipCheckpoint* );
+       OffSet          mFill( void );
+       OffSet          mInflate( char*, OffSet );
+       void            mAddCheckpoint( void );
+       void            mClearCheckpoints( void );
+       bool            mWriteAll( const char*, OffSet );
+       bool            mDeflate( int );
+       bool            mQueueChunk( bool );
+       bool            mCollectChunk( void );
+       void            mEnd( void );
+
+       z_stream_s*                      _zRead;
+       z_stream_s*                      _zWrite;
+       OffSet                           _offSpan;
+       std::vector<GzipCheckpoint*>     _vecCheckpoints;
+       // Compressed data read from the handle
+       char*                            _arrIn;
+       // Compressed data waiting to be written
+       char*                            _arrOut;
+       // The last 32K of output, the inflater writes straight into it
+       char*                            _arrWindow;
+       int                              _intWindowPos;
+       // The compressed offset of the end of the data in _arrIn
+       OffSet                           _offIn;
+       // The compressed bytes written so far
+       OffSet                           _offWritten;
+       // Inflating a raw deflate stream resumed from a checkpoint
+       bool                             _boolRaw;
+       // Between gzip members, the end of the data is the end of the file
+       bool                             _boolBetween;
+       // A member was inflated to it's end, what follows may be trailing garbage
+       bool                             _boolMember;
+       bool                             _boolEnd;
+       // Bytes of the gzip trailer left to skip after a raw stream ends
+       int                              _intSkip;
+       int                              _intThreads;
+       // The worker pool, only set while saving with more than one thread
+       WorkerPool*                      _ptrCompressor;
+       // Data waiting to fill a chunk
+       std::string                      _strChunk;
+       // The last 32K of data handed to the compressor
+       std::string                      _strDict;
+       // Chunks being compressed, in the order they are written
+       std::deque<GzipJob*>             _queJobs;
+       unsigned long                    _intCrc;
 
 };
 
 /*!
  * This class reads and writes UTF-8 Files
+ *
+ * Blocks read always end on a code point, a sequence cut off by the 
+ * end of the block is held back and starts the next block. Blocks that 
+ * are valid UTF-8 are marked with the Attributes::Utf8Validated flag
+ *
+ * The first line ending read decides the line endings of the file. If 
+ * they are CRLF the CR is taken out of each block as it is read and the 
+ * block is marked with Attributes::Crlf, writes put the CR back. Offsets
+ * are always file offsets, so in place saves are not offered for CRLF files
  */
 class Utf8File : public File {
     
     public:
-       Utf8File( IOHandle* const ioHandle ) : File( ioHandle ) { };
+       Utf8File( IOHandle* const ioHandle ) : File( ioHandle ), _intCarry(0), 
+                 _intLineEnding( FileIdentity::None ), _boolNormalize( DEFAULT_NORMALIZE_CRLF ) { };
        ~Utf8File() { };
 
        virtual OffSet  mPeekNextBlock( void );
        virtual OffSet  mReadBlock( OffSet, char*, Attributes& );
        virtual OffSet  mReadNextBlock( char*, Attributes& );
+       virtual OffSet  mMapNextBlock( const char**, Attributes& );
+       // Mapped blocks point at the file, there is no taking the CR out
+       virtual bool    mOffersMap( void ) { return _ioHandle->mOffersMap() and ! _boolNormalize; }
+       virtual int     mReadBlocks( int, char*, struct iovec*, Attributes* );
        virtual OffSet  mWriteBlock( OffSet, const char*, OffSet, Attributes& );
        virtual OffSet  mWriteNextBlock( const char*, OffSet, Attributes& );
+       virtual OffSet  mWriteBlocks( const struct iovec*, const Attributes*, int );
+       virtual bool    mOffersInPlaceSave( void ) { 
+           return _ioHandle->mOffersSeek() and _intLineEnding != FileIdentity::CRLF 
+                                           and _intLineEnding != FileIdentity::Mixed; 
+       }
+       virtual OffSet  mCopyBlocks( IOHandle*, OffSet, OffSet );
+       virtual bool    mFollow( void );
+       virtual int     mWaitForAppend( int );
        virtual OffSet  mSetOffSet( OffSet );
        virtual bool    mPrepareSave( void );
        virtual bool    mPrepareLoad( void );
        virtual bool    mFinalizeSave( void );
        virtual bool    mFinalizeLoad( void );
 
+       //! Take the CR out of CRLF line endings on load, mIdentifyFile() turns it on for CRLF text
+       void            mSetNormalize( bool boolNormalize ) { _boolNormalize = boolNormalize; }
+       //! The line endings found by the load, or the line endings to save with. 
+       //! Saving a Mixed file only puts the CR back in the blocks flagged Crlf
+       int             mGetLineEnding( void ) const { return _intLineEnding; }
+       void            mSetLineEnding( int intLineEnding ) { _intLineEnding = intLineEnding; }
+
+       OffSet          mTrimBlock( char*, OffSet, Attributes& );
+       OffSet          mNormalizeBlock( char*, OffSet, Attributes& );
+       OffSet          mWriteExpanded( const struct iovec*, const Attributes*, int );
+       bool            mDropCarry( void );
+
+       // The start of a sequence ( or a CR ) the last block cut off
+       char            _arrCarry[ 4 ];
+       int             _intCarry;
+       // A FileIdentity::LineEnding
+       int             _intLineEnding;
+       bool            _boolNormalize;
+       // The blocks with the CR put back
+       std::vector<char> _vecExpand;
+
 };
 
+struct ZSTD_DCtx_s;
+class ZstdJob;
+
+/*!
+ * Reads and writes zstd files in the seekable format, the data is split 
+ * into independent frames followed by a skippable frame holding the size 
+ * of each frame ( the seek table ). mSetOffSet() and mReadBlock() seek to 
+ * the frame that holds the offset and only decompress that frame. Saving
+ * compresses the frames in parallel on a WorkerPool
+ *
+ * Zstd files without a seek table are read from the start. If ollie was 
+ * built without libzstd every load and save fails
+ */
+class ZstdFile : public File {
+
+    public:
+       ZstdFile( IOHandle* const ioHandle, OffSet offFrameSize = DEFAULT_ZSTD_FRAME );
+       ~ZstdFile();
+
+       virtual OffSet  mPeekNextBlock( void );
+       virtual OffSet  mReadBlock( OffSet, char*, Attributes& );
+       virtual OffSet  mReadNextBlock( char*, Attributes& );
+       virtual OffSet  mWriteBlock( OffSet, const char*, OffSet, Attributes& );
+       virtual OffSet  mWriteNextBlock( const char*, OffSet, Attributes& );
+       virtual OffSet  mSetOffSet( OffSet );
+       virtual bool    mPrepareSave( void );
+       virtual bool    mPrepareLoad( void );
+       virtual bool    mFinalizeSave( void );
+       virtual bool    mFinalizeLoad( void );
+
+       //! The number of frames in the seek table, 0 if the file has none
+       int             mGetFrames( void ) { return _vecFrames.empty() ? 0 : _vecFrames.size() - 1; }
+       //! The threads used to compress on save, 0 uses one per CPU
+       void            mSetThreads( int intThreads ) { _intThreads = intThreads; }
+       void            mSetLevel( int intLevel ) { _intLevel = intLevel; }
+
+       bool            mLoadSeekTable( void );
+       bool            mResetDecompress( int );
+       OffSet          mDecompress( char*, OffSet );
+       bool            mReadAll( char*, OffSet );
+       bool            mWriteAll( const char*, OffSet );
+       bool            mQueueFrame( void );
+       bool            mCollectFrame( void );
+       void            mEnd( void );
+
+       ZSTD_DCtx_s*                     _zRead;
+       OffSet                           _offFrameSize;
+       int                              _intThreads;
+       int                              _intLevel;
+       // Where each frame starts, compressed and uncompressed, the last entry is the end of the data
+       std::vector<OffSet>              _vecFrames;
+       std::vector<OffSet>              _vecFrameOffSets;
+       // Compressed data read from the handle
+       std::vector<char>                _vecIn;
+       OffSet                           _offInPos;
+       OffSet                           _offInSize;
+       bool                             _boolBetween;
+       bool                             _boolEnd;
+       // The worker pool, only set while saving
+       WorkerPool*                      _ptrCompressor;
+       // Data waiting to fill a frame
+       std::string                      _strFrame;
+       // Frames being compressed, in the order they are written
+       std::deque<ZstdJob*>             _queJobs;
+       // The compressed and uncompressed size of each frame written
+       std::vector<unsigned int>        _vecSeekTable;
+       OffSet                           _offWritten;
+};
+
+/*!
+ * The base class for files stored in an encoding other than UTF-8, 
+ * the blocks read are converted to UTF-8 and the blocks written are
+ * converted back, so the buffer always holds UTF-8
+ *
+ * Offsets are in UTF-8 bytes, so the file can only seek to the 
+ * start or stay where it is. Files are written in order
+ */
+class TranscodedFile : public File {
+
+    public:
+       TranscodedFile( IOHandle* const ioHandle );
+       ~TranscodedFile() { }
+
+       virtual OffSet  mPeekNextBlock( void );
+       virtual OffSet  mReadBlock( OffSet, char*, Attributes& );
+       virtual OffSet  mReadNextBlock( char*, Attributes& );
+       virtual OffSet  mWriteBlock( OffSet, const char*, OffSet, Attributes& );
+       virtual OffSet  mWriteNextBlock( const char*, OffSet, Attributes& );
+       virtual OffSet  mSetOffSet( OffSet );
+       virtual bool    mPrepareSave( void );
+       virtual bool    mPrepareLoad( void );
+       virtual bool    mFinalizeSave( void );
+       virtual bool    mFinalizeLoad( void );
+
+       /*! 
+        * Convert offIn bytes of the file to UTF-8, returns the UTF-8 bytes written and sets 
+        * offUsed to the bytes converted. A character cut off by the end of arrIn is left for 
+        * the next call, unless boolEnd is set, then it becomes U+FFFD
+        */
+       virtual OffSet  mDecode( const char* arrIn, OffSet offIn, char* arrOut, OffSet& offUsed, bool boolEnd ) = 0;
+       //! Convert complete UTF-8 sequences to the file encoding, returns the bytes written or -1 on error
+       virtual OffSet  mEncode( const char* arrIn, OffSet offIn, char* arrOut ) = 0;
+       //! The most file bytes we can read without the UTF-8 outgrowing offSize
+       virtual OffSet  mDecodeSize( OffSet offSize ) = 0;
+       //! The most file bytes offSize UTF-8 bytes can become
+       virtual OffSet  mEncodeSize( OffSet offSize ) = 0;
+       //! The byte order mark, written when the file is saved if the file had one
+       virtual std::string mGetBom( void ) { return std::string(); }
+       //! Returns the size of the byte order mark at the start of the file, 0 if there is none
+       virtual int     mCheckBom( const char*, OffSet ) { return 0; }
+
+       void            mSetBom( bool boolBom ) { _boolBom = boolBom; }
+       bool            mHasBom( void ) const { return _boolBom; }
+
+       bool            mWriteAll( const char*, OffSet );
+
+       // File bytes read but not converted, or UTF-8 bytes not written yet
+       std::string                      _strCarry;
+       std::vector<char>                _vecRaw;
+       bool                             _boolBom;
+       // Nothing has been read since the start of the file, look for a byte order mark
+       bool                             _boolStart;
+       bool                             _boolEnd;
+       // The file bytes written so far
+       OffSet                           _offWritten;
+};
+
+/*!
+ * Reads and writes UTF-16 files, little endian unless told otherwise
+ */
+class Utf16File : public TranscodedFile {
+
+    public:
+       Utf16File( IOHandle* const ioHandle, bool boolBigEndian = false ) 
+           : TranscodedFile( ioHandle ), _boolBigEndian( boolBigEndian ) { _boolBom = true; }
+       ~Utf16File() { }
+
+       virtual OffSet  mDecode( const char*, OffSet, char*, OffSet&, bool );
+       virtual OffSet  mEncode( const char*, OffSet, char* );
+       virtual OffSet  mDecodeSize( OffSet offSize ) { return ( offSize / 3 ) * 2; }
+       virtual OffSet  mEncodeSize( OffSet offSize ) { return offSize * 2; }
+       virtual std::string mGetBom( void ) { return _boolBigEndian ? std::string( "\xfe\xff" ) : std::string( "\xff\xfe" ); }
+       virtual int     mCheckBom( const char*, OffSet );
+
+       bool            _boolBigEndian;
+};
+
+/*!
+ * Reads and writes Latin-1 ( ISO-8859-1 ) files
+ */
+class Latin1File : public TranscodedFile {
+
+    public:
+       Latin1File( IOHandle* const ioHandle ) : TranscodedFile( ioHandle ) { }
+       ~Latin1File() { }
+
+       virtual OffSet  mDecode( const char*, OffSet, char*, OffSet&, bool );
+       virtual OffSet  mEncode( const char*, OffSet, char* );
+       virtual OffSet  mDecodeSize( OffSet offSize ) { return offSize / 2; }
+       virtual OffSet  mEncodeSize( OffSet offSize ) { return offSize; }
+};
 
 #endif // FILE_INCLUDE_H
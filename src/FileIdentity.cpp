@@ -0,0 +1,249 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <File.h>
+#include <Utf8Validator.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*!
+ * Byte counts collected in a single pass over the sample
+ */
+struct SniffCounts {
+    OffSet offNulls;
+    // NULs at even and odd offsets, UTF-16 text has one or the other
+    OffSet offEvenNulls;
+    OffSet offOddNulls;
+    OffSet offLF;
+    OffSet offCR;
+    // CR directly followed by LF, and CR followed by LF two bytes later ( UTF-16 )
+    OffSet offCRLF;
+    OffSet offWideCRLF;
+    OffSet offHigh;
+};
+
+/*!
+ * Count the bytes we are interested in, one byte at a time
+ */
+static void countBytes( const unsigned char* arrData, OffSet offStart, OffSet offSize, SniffCounts& counts ) {
+
+    for( OffSet i = offStart ; i < offSize ; ++i ) {
+        unsigned char chByte = arrData[i];
+
+        if( chByte == 0 ) {
+            ++counts.offNulls;
+            if( i & 1 ) ++counts.offOddNulls;
+            else ++counts.offEvenNulls;
+        } else if( chByte == '\n' ) {
+            ++counts.offLF;
+            if( i >= 1 and arrData[i-1] == '\r' ) ++counts.offCRLF;
+            if( i >= 2 and arrData[i-2] == '\r' ) ++counts.offWideCRLF;
+        } else if( chByte == '\r' ) {
+            ++counts.offCR;
+        } else if( chByte & 0x80 ) {
+            ++counts.offHigh;
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+static inline int popCount( unsigned int intMask ) {
+    return __builtin_popcount( intMask );
+}
+
+/*!
+ * Count the bytes 16 at a time, CR masks are carried across 
+ * the chunks so pairs that straddle two chunks are counted
+ */
+static OffSet countBytesSSE2( const unsigned char* arrData, OffSet offSize, SniffCounts& counts ) {
+    const __m128i vecZero = _mm_setzero_si128();
+    const __m128i vecLF = _mm_set1_epi8( '\n' );
+    const __m128i vecCR = _mm_set1_epi8( '\r' );
+    unsigned int intCarry = 0;
+    OffSet i = 0;
+
+    for( ; i + 16 <= offSize ; i += 16 ) {
+        __m128i vecData = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrData + i ) );
+
+        unsigned int intNulls = _mm_movemask_epi8( _mm_cmpeq_epi8( vecData, vecZero ) );
+        unsigned int intLF = _mm_movemask_epi8( _mm_cmpeq_epi8( vecData, vecLF ) );
+        unsigned int intCR = _mm_movemask_epi8( _mm_cmpeq_epi8( vecData, vecCR ) );
+        unsigned int intHigh = _mm_movemask_epi8( vecData );
+
+        counts.offNulls += popCount( intNulls );
+        counts.offEvenNulls += popCount( intNulls & 0x5555 );
+        counts.offOddNulls += popCount( intNulls & 0xAAAA );
+        counts.offLF += popCount( intLF );
+        counts.offCR += popCount( intCR );
+        counts.offHigh += popCount( intHigh );
+
+        // The last two CR bits of the previous chunk sit below bit 0
+        unsigned int intShifted = ( intCR << 2 ) | intCarry;
+        counts.offCRLF += popCount( ( intShifted >> 1 ) & intLF );
+        counts.offWideCRLF += popCount( intShifted & intLF );
+        intCarry = ( intCR >> 14 ) & 3;
+    }
+
+    return i;
+}
+
+#endif
+
+/*!
+ * Guess the format, encoding and line ending of the sample
+ */
+void File::mSniff( const char* arrSample, OffSet offSize, FileIdentity& identity ) {
+    const unsigned char* arrData = reinterpret_cast<const unsigned char*>( arrSample );
+    SniffCounts counts;
+
+    identity = FileIdentity();
+    identity._offSize = offSize;
+
+    // Compressed files
+    if( offSize >= 2 and arrData[0] == 0x1f and arrData[1] == 0x8b ) {
+        identity._intFormat = FileIdentity::Gzip;
+        return;
+    }
+    if( offSize >= 4 and memcmp( arrData, "\x28\xb5\x2f\xfd", 4 ) == 0 ) {
+        identity._intFormat = FileIdentity::Zstd;
+        return;
+    }
+
+    // Byte order marks
+    if( offSize >= 3 and memcmp( arrData, "\xef\xbb\xbf", 3 ) == 0 ) {
+        identity._intBomSize = 3;
+    } else if( offSize >= 2 and arrData[0] == 0xff and arrData[1] == 0xfe ) {
+        identity._intEncoding = FileIdentity::Utf16LE;
+        identity._intBomSize = 2;
+    } else if( offSize >= 2 and arrData[0] == 0xfe and arrData[1] == 0xff ) {
+        identity._intEncoding = FileIdentity::Utf16BE;
+        identity._intBomSize = 2;
+    }
+
+    memset( &counts, 0, sizeof( counts ) );
+    OffSet offDone = 0;
+#ifdef __SSE2__
+    offDone = countBytesSSE2( arrData, offSize, counts );
+#endif
+    countBytes( arrData, offDone, offSize, counts );
+
+    identity._offNulls = counts.offNulls;
+    bool boolWide = identity._intEncoding != FileIdentity::Utf8;
+
+    // Mostly ASCII UTF-16 has a NUL in every other byte
+    if( ! identity._intBomSize and offSize >= 4 ) {
+        OffSet offPairs = offSize / 2;
+        if( counts.offOddNulls * 10 >= offPairs * 4 and counts.offEvenNulls * 20 < offPairs ) {
+            identity._intEncoding = FileIdentity::Utf16LE;
+            boolWide = true;
+        } else if( counts.offEvenNulls * 10 >= offPairs * 4 and counts.offOddNulls * 20 < offPairs ) {
+            identity._intEncoding = FileIdentity::Utf16BE;
+            boolWide = true;
+        }
+    }
+
+    if( ! boolWide ) {
+        // More than 1% NULs is not text
+        if( counts.offNulls * 100 > offSize ) {
+            identity._intFormat = FileIdentity::Binary;
+            return;
+        }
+        // A sequence cut off by the end of the sample is not an error
+        const char* arrText = arrSample + identity._intBomSize;
+        OffSet offText = Utf8Validator::mBoundary( arrText, offSize - identity._intBomSize );
+        if( counts.offHigh and ! Utf8Validator::mValidate( arrText, offText ) ) {
+            identity._intEncoding = FileIdentity::Latin1;
+        }
+    }
+
+    // The line ending used most
+    OffSet offCRLF = boolWide ? counts.offWideCRLF : counts.offCRLF;
+    OffSet offLF = counts.offLF - offCRLF;
+    OffSet offCR = counts.offCR - offCRLF;
+
+    if( offCRLF and offCRLF >= offLF and offCRLF >= offCR ) {
+        identity._intLineEnding = FileIdentity::CRLF;
+    } else if( offLF and offLF >= offCR ) {
+        identity._intLineEnding = FileIdentity::LF;
+    } else if( offCR ) {
+        identity._intLineEnding = FileIdentity::CR;
+    }
+}
+
+/*!
+ * Read the first DEFAULT_SNIFF_SIZE bytes of the handle and return the File 
+ * that reads the format found, the handle is rewound to the start of the file. 
+ * Returns 0 if the format is not supported, the error is set on the handle
+ */
+File* File::mIdentifyFile( IOHandle* ioHandle, FileIdentity* identity ) {
+    char arrSample[ DEFAULT_SNIFF_SIZE ];
+    FileIdentity sniffed;
+    OffSet offSize = 0;
+
+    // We can not rewind the handle after sniffing
+    if( ! ioHandle->mOffersSeek() ) {
+        if( identity ) *identity = sniffed;
+        return new Utf8File( ioHandle );
+    }
+
+    while( offSize < DEFAULT_SNIFF_SIZE ) {
+        OffSet offLen = ioHandle->mRead( arrSample + offSize, DEFAULT_SNIFF_SIZE - offSize );
+        if( offLen < 0 ) return 0;
+        if( offLen == 0 ) break;
+        offSize += offLen;
+    }
+
+    if( ioHandle->mSeek( 0 ) == -1 ) return 0;
+
+    mSniff( arrSample, offSize, sniffed );
+    if( identity ) *identity = sniffed;
+
+    switch( sniffed._intFormat ) {
+        case FileIdentity::Gzip: 
+            return new GzipFile( ioHandle );
+        case FileIdentity::Zstd:
+#ifdef HAVE_ZSTD
+            return new ZstdFile( ioHandle );
+#else
+            ioHandle->mSetError() << "IO Error: '" << ioHandle->mGetName() << "' is zstd compressed, ollie was built without zstd support";
+            return 0;
+#endif
+    }
+
+    if( sniffed._intFormat == FileIdentity::Text ) {
+        switch( sniffed._intEncoding ) {
+            case FileIdentity::Utf16LE: return new Utf16File( ioHandle, false );
+            case FileIdentity::Utf16BE: return new Utf16File( ioHandle, true );
+            case FileIdentity::Latin1:  return new Latin1File( ioHandle );
+        }
+    }
+
+    // Binary files pass through Utf8File byte for byte, text with CRLF line endings loads with LF
+    Utf8File* file = new Utf8File( ioHandle );
+    if( sniffed._intFormat == FileIdentity::Binary ) {
+        file->mSetNormalize( false );
+    } else if( sniffed._intLineEnding == FileIdentity::CRLF ) {
+        file->mSetNormalize( true );
+    }
+    return file;
+}
@@ -20,12 +20,15 @@
 
 #include "cxxtest/TestSuite.h"
 #include <File.h>
+#include <Utf8Validator.h>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <cstring>
+#include <unistd.h>
 
 using namespace std;
 
@@ -111,6 +114,56 @@ class FileTests : public CxxTest::TestSuite
             delete file;
         }
 
+        // --------------------------------
+        // --------------------------------
+        void testmMapNextBlock( void ) {
+            Attributes attr;
+            const char* arrBlockData = 0;
+
+            createTestFile(TEST_FILE);
+
+            IOHandle* ioHandle = new MmapIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+           
+            // Load the utf8 file handler
+            File* file = new Utf8File( ioHandle );
+            file->mSetBlockSize( 100 );
+
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+
+            // The first block should point at the first 100 bytes of the file
+            TS_ASSERT_EQUALS( file->mMapNextBlock( &arrBlockData, attr ), 100 );
+            TS_ASSERT_EQUALS( file->mGetOffSet() , 100 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 29 ), "AAAABBBBCCCCDDDDEEEE11223344\n" );
+
+            // The next block should be the rest of the file
+            TS_ASSERT_EQUALS( file->mMapNextBlock( &arrBlockData, attr ), 45 );
+            TS_ASSERT_EQUALS( file->mGetOffSet() , 145 );
+
+            // Seeking back should map the same data again
+            TS_ASSERT_EQUALS( file->mSetOffSet( 116 ), 116 );
+            TS_ASSERT_EQUALS( file->mMapNextBlock( &arrBlockData, attr ), 29 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 29 ), "AAAABBBBCCCCDDDDEEEE11223344\n" );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            TS_ASSERT_EQUALS( file->mFinalizeLoad(), true );
+
+            delete file;
+
+            // Posix IO does not offer mapped reads
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = new Utf8File( ioHandle );
+            TS_ASSERT_EQUALS( file->mMapNextBlock( &arrBlockData, attr ), -1 );
+            delete file;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+        }
+
         // --------------------------------
         // --------------------------------
         void testmWriteNextBlock( void ) {
@@ -187,4 +240,859 @@ class FileTests : public CxxTest::TestSuite
             delete file;
         }
 
+        // --------------------------------
+        // --------------------------------
+        void testGzipFile( void ) {
+            Attributes attr;
+            const OffSet offTotal = 4 * 1048576;
+            const OffSet offBlock = 65536;
+
+            // Something that compresses, but not to nothing
+            std::string strData;
+            unsigned int intSeed = 1;
+            for( OffSet i = 0 ; i < offTotal ; ++i ) {
+                if( i % 64 == 0 ) intSeed = intSeed * 1103515245 + 12345;
+                strData += char( 'A' + ( ( intSeed >> ( i % 16 ) ) + i / 7 ) % 26 );
+            }
+
+            createTestFile(TEST_FILE);
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+
+            // Record a checkpoint every 64k, compress on 4 threads
+            GzipFile* file = new GzipFile( ioHandle, 65536 );
+            file->mSetBlockSize( offBlock );
+            file->mSetThreads( 4 );
+
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            for( OffSet offset = 0 ; offset < offTotal ; offset += offBlock ) {
+                TS_ASSERT_EQUALS( file->mWriteNextBlock( strData.data() + offset, offBlock, attr ), offBlock );
+            }
+            TS_ASSERT_EQUALS( file->mGetOffSet(), offTotal );
+
+            // Only sequential writes are allowed
+            TS_ASSERT_EQUALS( file->mWriteBlock( 10, "AAAA", 4, attr ), -1 );
+            TS_ASSERT_EQUALS( file->mGetError(), "GzipFile can only write sequentially" );
+
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+
+            // The file should be compressed
+            struct stat sb;
+            TS_ASSERT_EQUALS( stat(TEST_FILE, &sb), 0 );
+            TS_ASSERT( sb.st_size < offTotal );
+
+            char* arrBlockData = new char[offBlock];
+
+            // Read the whole file back
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            std::string strRead;
+            OffSet offLen = 0;
+            while( ( offLen = file->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                strRead.append( arrBlockData, offLen );
+            }
+            TS_ASSERT_EQUALS( offLen, 0 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            TS_ASSERT_EQUALS( OffSet( strRead.size() ), offTotal );
+            TS_ASSERT( strRead == strData );
+            TS_ASSERT_EQUALS( file->mPeekNextBlock(), 0 );
+
+            // Checkpoints should have been recorded as we read
+            int intCheckpoints = file->mGetCheckpoints();
+            TS_ASSERT( intCheckpoints > 4 );
+
+            // Random reads resume from the checkpoints
+            OffSet arrOffsets[] = { 3000000, 17, 2500001, offTotal - 100, 1048576, 0 };
+            for( int i = 0 ; i < 6 ; ++i ) {
+                offLen = file->mReadBlock( arrOffsets[i], arrBlockData, attr );
+                OffSet offExpect = offTotal - arrOffsets[i];
+                if( offExpect > offBlock ) offExpect = offBlock;
+                TS_ASSERT_EQUALS( offLen, offExpect );
+                TS_ASSERT( string( arrBlockData, offLen ) == strData.substr( arrOffsets[i], offLen ) );
+            }
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            TS_ASSERT_EQUALS( file->mGetCheckpoints(), intCheckpoints );
+
+            // Past the end of the file
+            TS_ASSERT_EQUALS( file->mSetOffSet( offTotal + 1 ), -1 );
+            TS_ASSERT( file->mGetError().size() );
+
+            TS_ASSERT_EQUALS( file->mFinalizeLoad(), true );
+            delete file;
+
+            // Concatenated gzip members are read as one file
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            file = new GzipFile( ioHandle );
+            file->mSetThreads( 1 );
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( file->mWriteNextBlock( "AAAABBBB", 8, attr ), 8 );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            delete file;
+
+            std::string strMember;
+            std::ifstream ioIn( TEST_FILE, std::ios::binary );
+            strMember.assign( std::istreambuf_iterator<char>( ioIn ), std::istreambuf_iterator<char>() );
+            ioIn.close();
+            std::ofstream ioOut( TEST_FILE, std::ios::binary | std::ios::app );
+            ioOut << strMember;
+            ioOut.close();
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = new GzipFile( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 16 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 16 ), "AAAABBBBAAAABBBB" );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 0 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+
+            // Trailing garbage is ignored
+            ioOut.open( TEST_FILE, std::ios::binary | std::ios::app );
+            ioOut << "not gzip data";
+            ioOut.close();
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = new GzipFile( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 16 );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 0 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+
+            // A bad header on the first member is an error, not an empty file
+            ioOut.open( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << string( "\x1f\x8b\x99\x00\x00\x00\x00\x00\x00\x03" "ABCDE", 15 );
+            ioOut.close();
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = new GzipFile( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), -1 );
+            TS_ASSERT_EQUALS( file->mGetError().substr( 0, 31 ), "Gzip Error: Unable to inflate '" );
+            delete file;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+
+            delete[] arrBlockData;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testZstdFile( void ) {
+            Attributes attr;
+#ifdef HAVE_ZSTD
+            const OffSet offTotal = 1048576 + 12345;
+            const OffSet offBlock = 65536;
+            const OffSet offFrame = 131072;
+
+            std::string strData;
+            unsigned int intSeed = 1;
+            for( OffSet i = 0 ; i < offTotal ; ++i ) {
+                if( i % 64 == 0 ) intSeed = intSeed * 1103515245 + 12345;
+                strData += char( 'A' + ( ( intSeed >> ( i % 16 ) ) + i / 7 ) % 26 );
+            }
+
+            createTestFile(TEST_FILE);
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+
+            // 128k frames, compressed on 4 threads
+            ZstdFile* file = new ZstdFile( ioHandle, offFrame );
+            file->mSetBlockSize( offBlock );
+            file->mSetThreads( 4 );
+
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            for( OffSet offset = 0 ; offset < offTotal ; offset += offBlock ) {
+                OffSet offLen = offTotal - offset;
+                if( offLen > offBlock ) offLen = offBlock;
+                TS_ASSERT_EQUALS( file->mWriteNextBlock( strData.data() + offset, offLen, attr ), offLen );
+            }
+            TS_ASSERT_EQUALS( file->mWriteBlock( 10, "AAAA", 4, attr ), -1 );
+            TS_ASSERT_EQUALS( file->mGetError(), "ZstdFile can only write sequentially" );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            delete file;
+
+            struct stat sb;
+            TS_ASSERT_EQUALS( stat(TEST_FILE, &sb), 0 );
+            TS_ASSERT( sb.st_size < offTotal );
+
+            char* arrBlockData = new char[offBlock];
+
+            // The seek table is read on load
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = new ZstdFile( ioHandle );
+            file->mSetBlockSize( offBlock );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mGetFrames(), 9 );
+
+            std::string strRead;
+            OffSet offLen = 0;
+            while( ( offLen = file->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                strRead.append( arrBlockData, offLen );
+            }
+            TS_ASSERT_EQUALS( offLen, 0 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            TS_ASSERT( strRead == strData );
+            TS_ASSERT_EQUALS( file->mPeekNextBlock(), 0 );
+
+            // Random reads only decompress the frame that holds the offset
+            OffSet arrOffsets[] = { 700000, 17, offFrame, offTotal - 100, offFrame - 1, 0 };
+            for( int i = 0 ; i < 6 ; ++i ) {
+                offLen = file->mReadBlock( arrOffsets[i], arrBlockData, attr );
+                OffSet offExpect = offTotal - arrOffsets[i];
+                if( offExpect > offBlock ) offExpect = offBlock;
+                TS_ASSERT_EQUALS( offLen, offExpect );
+                TS_ASSERT( string( arrBlockData, offLen ) == strData.substr( arrOffsets[i], offLen ) );
+            }
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            TS_ASSERT_EQUALS( file->mPeekNextBlock(), offBlock );
+
+            TS_ASSERT_EQUALS( file->mSetOffSet( offTotal + 1 ), -1 );
+            TS_ASSERT( file->mGetError().size() );
+            delete file;
+
+            // mIdentifyFile() knows zstd files
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            File* ptrFile = File::mIdentifyFile( ioHandle );
+            TS_ASSERT( dynamic_cast<ZstdFile*>( ptrFile ) );
+            delete ptrFile;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+
+            delete[] arrBlockData;
+#else
+            // Without libzstd saving fails instead of writing something unreadable
+            createTestFile(TEST_FILE);
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            ZstdFile* file = new ZstdFile( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareSave(), false );
+            TS_ASSERT( file->mGetError().find( "without zstd support" ) != std::string::npos );
+            delete file;
+            unlink(TEST_FILE);
+#endif
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testIdentifyFile( void ) {
+            FileIdentity identity;
+            Attributes attr;
+
+            // Plain text, a CRLF straddles the first 16 byte chunk
+            string strText = "AAAABBBBCCCCDDD\r\nAAAABBBBCCCCDDDDEEEE\r\nAAAA\n";
+            File::mSniff( strText.data(), strText.size(), identity );
+            TS_ASSERT_EQUALS( identity._intFormat, FileIdentity::Text );
+            TS_ASSERT_EQUALS( identity._intEncoding, FileIdentity::Utf8 );
+            TS_ASSERT_EQUALS( identity._intLineEnding, FileIdentity::CRLF );
+            TS_ASSERT_EQUALS( identity._intBomSize, 0 );
+
+            // UTF-8 with a BOM, a multi-byte character cut off by the end of the sample is fine
+            string strUtf8 = "\xef\xbb\xbf" "caf\xc3\xa9 na\xc3\xafve\nr\xc3\xa9sum\xc3\xa9\n\xe2\x82";
+            File::mSniff( strUtf8.data(), strUtf8.size(), identity );
+            TS_ASSERT_EQUALS( identity._intEncoding, FileIdentity::Utf8 );
+            TS_ASSERT_EQUALS( identity._intBomSize, 3 );
+            TS_ASSERT_EQUALS( identity._intLineEnding, FileIdentity::LF );
+
+            // Latin-1 is not valid UTF-8
+            string strLatin1 = "caf\xe9 na\xefve r\xe9sum\xe9 and some more text\r";
+            File::mSniff( strLatin1.data(), strLatin1.size(), identity );
+            TS_ASSERT_EQUALS( identity._intEncoding, FileIdentity::Latin1 );
+            TS_ASSERT_EQUALS( identity._intLineEnding, FileIdentity::CR );
+
+            // UTF-16 with and without a BOM
+            string strWide;
+            const char* cstrWide = "AAAABBBB\r\nCCCCDDDD\r\nEEEE";
+            for( const char* c = cstrWide ; *c ; ++c ) { strWide += *c; strWide += '\0'; }
+            File::mSniff( strWide.data(), strWide.size(), identity );
+            TS_ASSERT_EQUALS( identity._intFormat, FileIdentity::Text );
+            TS_ASSERT_EQUALS( identity._intEncoding, FileIdentity::Utf16LE );
+            TS_ASSERT_EQUALS( identity._intLineEnding, FileIdentity::CRLF );
+
+            string strBigEndian = string( "\xfe\xff", 2 ) + '\0' + strWide.substr( 0, strWide.size() - 1 );
+            File::mSniff( strBigEndian.data(), strBigEndian.size(), identity );
+            TS_ASSERT_EQUALS( identity._intEncoding, FileIdentity::Utf16BE );
+            TS_ASSERT_EQUALS( identity._intBomSize, 2 );
+
+            // Lots of NULs that are not UTF-16
+            string strBinary( 64, '\0' );
+            for( int i = 0 ; i < 64 ; i += 3 ) strBinary[i] = 'A' + i;
+            File::mSniff( strBinary.data(), strBinary.size(), identity );
+            TS_ASSERT_EQUALS( identity._intFormat, FileIdentity::Binary );
+            TS_ASSERT_EQUALS( identity._offNulls, 42 );
+
+            // Binary files are never normalized, even with a CRLF up front
+            std::ofstream ioBinary( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioBinary << "AB\r\n" << strBinary;
+            ioBinary.close();
+            IOHandle* ioBinaryHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioBinaryHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            Utf8File* fileBinary = dynamic_cast<Utf8File*>( File::mIdentifyFile( ioBinaryHandle ) );
+            TS_ASSERT( fileBinary );
+            if( fileBinary ) TS_ASSERT( ! fileBinary->_boolNormalize );
+            delete fileBinary;
+
+            // CRLF text is normalized, the CR comes out on load
+            std::ofstream ioCrlf( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioCrlf << "AAAABBBBCCCCDDD\r\nAAAABBBBCCCCDDDDEEEE\r\n";
+            ioCrlf.close();
+            IOHandle* ioCrlfHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioCrlfHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            Utf8File* fileCrlf = dynamic_cast<Utf8File*>( File::mIdentifyFile( ioCrlfHandle ) );
+            TS_ASSERT( fileCrlf );
+            if( fileCrlf ) {
+                TS_ASSERT( fileCrlf->_boolNormalize );
+                char arrCrlf[ 128 ];
+                TS_ASSERT_EQUALS( fileCrlf->mPrepareLoad(), true );
+                TS_ASSERT_EQUALS( fileCrlf->mReadNextBlock( arrCrlf, attr ), 37 );
+                TS_ASSERT_EQUALS( string( arrCrlf, 15 ), "AAAABBBBCCCCDDD" );
+                TS_ASSERT_EQUALS( arrCrlf[ 15 ], '\n' );
+                TS_ASSERT_EQUALS( fileCrlf->mGetLineEnding(), FileIdentity::CRLF );
+            }
+            delete fileCrlf;
+
+            File::mSniff( "\x28\xb5\x2f\xfd\x00\x00", 6, identity );
+            TS_ASSERT_EQUALS( identity._intFormat, FileIdentity::Zstd );
+
+            // A text file
+            createTestFile(TEST_FILE);
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            File* file = File::mIdentifyFile( ioHandle, &identity );
+            TS_ASSERT( dynamic_cast<Utf8File*>( file ) );
+            TS_ASSERT_EQUALS( identity._intLineEnding, FileIdentity::LF );
+            TS_ASSERT_EQUALS( identity._offSize, 145 );
+
+            // Compress it
+            char* arrBlockData = new char[file->mGetBlockSize()];
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 145 );
+            string strData( arrBlockData, 145 );
+            delete file;
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            file = new GzipFile( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( file->mWriteNextBlock( strData.data(), 145, attr ), 145 );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            delete file;
+
+            // The gzip file is read through a GzipFile from the start
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            file = File::mIdentifyFile( ioHandle, &identity );
+            TS_ASSERT( dynamic_cast<GzipFile*>( file ) );
+            TS_ASSERT_EQUALS( identity._intFormat, FileIdentity::Gzip );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 145 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 145 ), strData );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+
+            delete[] arrBlockData;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testUtf8Validator( void ) {
+            const char* arrValid[] = { "", "AAAABBBB", "caf\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", 
+                                       "\xed\x9f\xbf", "\xf4\x8f\xbf\xbf", "\xef\xbf\xbf" };
+            const char* arrInvalid[] = { "\x80", "\xc3", "\xc3\x28", "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80",
+                                         "\xf0\x80\x80\xaf", "\xf4\x90\x80\x80", "\xf8\x88\x80\x80\x80", 
+                                         "\xe2\x82", "\xe2\x82\x28", "\xff" };
+
+            for( int intImpl = Utf8Validator::Scalar ; intImpl <= Utf8Validator::mBest() ; ++intImpl ) {
+                // Put each sequence at every position across a chunk boundary
+                for( int intPad = 0 ; intPad < 40 ; ++intPad ) {
+                    for( size_t i = 0 ; i < sizeof( arrValid ) / sizeof( char* ) ; ++i ) {
+                        string strData = string( intPad, 'A' ) + arrValid[i] + "BBBB";
+                        TS_ASSERT_EQUALS( Utf8Validator::mValidateWith( intImpl, strData.data(), strData.size() ), true );
+                    }
+                    for( size_t i = 0 ; i < sizeof( arrInvalid ) / sizeof( char* ) ; ++i ) {
+                        string strData = string( intPad, 'A' ) + arrInvalid[i] + "BBBB";
+                        TS_ASSERT_EQUALS( Utf8Validator::mValidateWith( intImpl, strData.data(), strData.size() ), false );
+                        // Cut off by the end
+                        strData = string( intPad, 'A' ) + arrInvalid[i];
+                        TS_ASSERT_EQUALS( Utf8Validator::mValidateWith( intImpl, strData.data(), strData.size() ), false );
+                    }
+                }
+
+                // Random mixes of sequences agree with the scalar check
+                unsigned int intSeed = 42;
+                for( int intRound = 0 ; intRound < 2000 ; ++intRound ) {
+                    string strData;
+                    int intParts = rand_r( &intSeed ) % 40;
+                    for( int i = 0 ; i < intParts ; ++i ) {
+                        int intPick = rand_r( &intSeed ) % 10;
+                        if( intPick < 6 ) strData += arrValid[ rand_r( &intSeed ) % ( sizeof( arrValid ) / sizeof( char* ) ) ];
+                        else if( intPick < 9 ) strData += string( rand_r( &intSeed ) % 20, 'C' );
+                        else strData += char( rand_r( &intSeed ) );
+                    }
+                    TS_ASSERT_EQUALS( Utf8Validator::mValidateWith( intImpl, strData.data(), strData.size() ),
+                                      Utf8Validator::mValidateWith( Utf8Validator::Scalar, strData.data(), strData.size() ) );
+                }
+            }
+
+            // Where the last complete sequence ends
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "AAAA", 4 ), 4 );
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "AA\xc3\xa9", 4 ), 4 );
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "AAA\xc3", 4 ), 3 );
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "A\xf0\x9f\x98", 4 ), 1 );
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "AAA\x80", 4 ), 4 );
+            TS_ASSERT_EQUALS( Utf8Validator::mBoundary( "", 0 ), 0 );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testUtf8FileBoundaries( void ) {
+            Attributes attr;
+            string strData;
+
+            // Two, three and four byte sequences, every block size cuts some of them
+            for( int i = 0 ; i < 50 ; ++i ) strData += "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\n";
+
+            std::ofstream ioOut( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << strData;
+            ioOut.close();
+
+            for( OffSet offBlock = 4 ; offBlock < 12 ; ++offBlock ) {
+                IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+                File* file = new Utf8File( ioHandle );
+                file->mSetBlockSize( offBlock );
+                TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+
+                char* arrBlockData = new char[ offBlock ];
+                string strRead;
+                OffSet offLen = 0;
+                while( ( offLen = file->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                    // Every block is whole code points
+                    TS_ASSERT( attr.mHasFlag( Attributes::Utf8Validated ) );
+                    TS_ASSERT_EQUALS( Utf8Validator::mBoundary( arrBlockData, offLen ), offLen );
+                    strRead.append( arrBlockData, offLen );
+                    TS_ASSERT_EQUALS( file->mGetOffSet(), OffSet( strRead.size() ) );
+                }
+                TS_ASSERT_EQUALS( offLen, 0 );
+                TS_ASSERT( strRead == strData );
+
+                // Seeking drops the bytes held back
+                OffSet offExpect = Utf8Validator::mBoundary( strData.data() + 1, offBlock );
+                TS_ASSERT_EQUALS( file->mReadBlock( 1, arrBlockData, attr ), offExpect );
+                TS_ASSERT( string( arrBlockData, offExpect ) == strData.substr( 1, offExpect ) );
+                OffSet offNext = Utf8Validator::mBoundary( strData.data() + 1 + offExpect, offBlock );
+                TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), offNext );
+                TS_ASSERT( string( arrBlockData, offNext ) == strData.substr( 1 + offExpect, offNext ) );
+
+                delete[] arrBlockData;
+                delete file;
+            }
+
+            // Invalid blocks are not flagged
+            ioOut.open( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << "AAAA\xff\xfe BBBB";
+            ioOut.close();
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            File* file = new Utf8File( ioHandle );
+            char* arrBlockData = new char[file->mGetBlockSize()];
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 11 );
+            TS_ASSERT( ! attr.mHasFlag( Attributes::Utf8Validated ) );
+            delete[] arrBlockData;
+            delete file;
+
+            // The flags are not the buffer's attribute value
+            Attributes attrValue( 2 );
+            TS_ASSERT( ! attrValue.mHasFlag( Attributes::Crlf ) );
+            attrValue.mSetFlag( Attributes::Utf8Validated, true );
+            TS_ASSERT( attrValue == Attributes( 2 ) );
+            TS_ASSERT_EQUALS( attrValue.mTestValue(), 2 );
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            file = new Utf8File( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( file->mWriteNextBlock( "a\nb\n", 4, attrValue ), 4 );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 4 );
+            delete file;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testmReadBlocks( void ) {
+            Attributes arrAttr[ 3 ];
+            struct iovec arrIov[ 3 ];
+            Attributes attr;
+            string strData;
+
+            for( int i = 0 ; i < 50 ; ++i ) strData += "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\n";
+
+            std::ofstream ioOut( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << strData;
+            ioOut.close();
+
+            for( OffSet offBlock = 4 ; offBlock < 12 ; ++offBlock ) {
+                IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+                File* file = new Utf8File( ioHandle );
+                file->mSetBlockSize( offBlock );
+                TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+
+                char* arrBuffer = new char[ offBlock * 3 ];
+                string strRead;
+                int intBlocks = 0;
+                while( ( intBlocks = file->mReadBlocks( 3, arrBuffer, arrIov, arrAttr ) ) > 0 ) {
+                    TS_ASSERT( intBlocks <= 3 );
+                    for( int i = 0 ; i < intBlocks ; ++i ) {
+                        const char* arrBlockData = static_cast<const char*>( arrIov[i].iov_base );
+                        OffSet offLen = arrIov[i].iov_len;
+
+                        // Every block fits the block size and is whole code points
+                        TS_ASSERT( offLen > 0 and offLen <= offBlock );
+                        TS_ASSERT_EQUALS( Utf8Validator::mBoundary( arrBlockData, offLen ), offLen );
+                        TS_ASSERT( arrAttr[i].mHasFlag( Attributes::Utf8Validated ) );
+                        strRead.append( arrBlockData, offLen );
+                    }
+                    TS_ASSERT_EQUALS( file->mGetOffSet(), OffSet( strRead.size() ) );
+
+                    // Single block reads carry on where the blocks left off
+                    OffSet offLen = file->mReadNextBlock( arrBuffer, attr );
+                    TS_ASSERT( offLen >= 0 );
+                    strRead.append( arrBuffer, offLen );
+                }
+                TS_ASSERT_EQUALS( intBlocks, 0 );
+                TS_ASSERT( strRead == strData );
+
+                delete[] arrBuffer;
+                delete file;
+            }
+
+            // Files without their own mReadBlocks() read one block at a time
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+            File* file = new Latin1File( ioHandle );
+            file->mSetBlockSize( 200 );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            char* arrBuffer = new char[ 200 * 3 ];
+            TS_ASSERT_EQUALS( file->mReadBlocks( 3, arrBuffer, arrIov, arrAttr ), 3 );
+            TS_ASSERT_EQUALS( arrIov[1].iov_base, arrBuffer + 200 );
+            TS_ASSERT_EQUALS( arrIov[2].iov_base, arrBuffer + 400 );
+            delete[] arrBuffer;
+            delete file;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testCrlfLineEndings( void ) {
+            Attributes attr;
+            string strData;
+
+            // A lone CR stays, the last line has no line ending
+            for( int i = 0 ; i < 30 ; ++i ) strData += "AAAABBBBCCCCDDDDEEEE caf\xc3\xa9\r\n";
+            strData += "A lone\rCR\r\n\r\nlast line";
+
+            string strExpect;
+            for( size_t i = 0 ; i < strData.size() ; ++i ) {
+                if( strData[i] == '\r' and i + 1 < strData.size() and strData[i + 1] == '\n' ) continue;
+                strExpect += strData[i];
+            }
+
+            std::ofstream ioOut( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << strData;
+            ioOut.close();
+
+            // Every block size splits some of the CRLFs
+            for( OffSet offBlock = 3 ; offBlock < 40 ; ++offBlock ) {
+                IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+                Utf8File* file = new Utf8File( ioHandle );
+                file->mSetNormalize( true );
+                file->mSetBlockSize( offBlock );
+                TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+
+                char* arrBlockData = new char[ offBlock ];
+                string strRead;
+                OffSet offLen = 0;
+                while( ( offLen = file->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                    // Blocks without a line ending have no LF to put the CR back on
+                    if( memchr( arrBlockData, '\n', offLen ) ) {
+                        TS_ASSERT( attr.mHasFlag( Attributes::Crlf ) );
+                    }
+                    strRead.append( arrBlockData, offLen );
+                }
+                TS_ASSERT_EQUALS( offLen, 0 );
+                TS_ASSERT( strRead == strExpect );
+                TS_ASSERT_EQUALS( file->mGetLineEnding(), FileIdentity::CRLF );
+                TS_ASSERT_EQUALS( file->mGetOffSet(), OffSet( strData.size() ) );
+                TS_ASSERT( ! file->mOffersInPlaceSave() );
+
+                delete[] arrBlockData;
+                delete file;
+            }
+
+            // Saving puts the CR back
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            Utf8File* file = new Utf8File( ioHandle );
+            file->mSetNormalize( true );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            char* arrBlockData = new char[ file->mGetBlockSize() ];
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), OffSet( strExpect.size() ) );
+            TS_ASSERT_EQUALS( file->mFinalizeLoad(), true );
+
+            struct iovec arrIov[ 2 ];
+            Attributes arrAttr[ 2 ];
+            arrIov[0].iov_base = const_cast<char*>( strExpect.data() );
+            arrIov[0].iov_len = 100;
+            arrIov[1].iov_base = const_cast<char*>( strExpect.data() + 100 );
+            arrIov[1].iov_len = strExpect.size() - 100;
+
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( file->mWriteBlocks( arrIov, arrAttr, 2 ), OffSet( strExpect.size() ) );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+
+            std::ifstream ioIn( TEST_FILE, std::ios::binary );
+            string strFile( ( std::istreambuf_iterator<char>( ioIn ) ), std::istreambuf_iterator<char>() );
+            ioIn.close();
+            TS_ASSERT( strFile == strData );
+
+            // A new file only gets CRLFs in the blocks flagged with them
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            file = new Utf8File( ioHandle );
+            TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+            Attributes attrCrlf;
+            attrCrlf.mSetFlag( Attributes::Crlf, true );
+            TS_ASSERT_EQUALS( file->mWriteNextBlock( "AAAA\nBBBB\n", 10, attrCrlf ), 10 );
+            TS_ASSERT_EQUALS( file->mWriteNextBlock( "CCCC\n", 5, arrAttr[0] ), 5 );
+            TS_ASSERT_EQUALS( file->mGetOffSet(), 17 );
+            TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+
+            file->mSetNormalize( false );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 17 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 17 ), "AAAA\r\nBBBB\r\nCCCC\n" );
+            TS_ASSERT( ! attr.mHasFlag( Attributes::Crlf ) );
+            delete file;
+
+            // Files with LF line endings are left alone
+            ioOut.open( TEST_FILE, std::ios::binary | std::ios::trunc );
+            ioOut << "AAAA\nBBBB\n";
+            ioOut.close();
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            file = new Utf8File( ioHandle );
+            file->mSetNormalize( true );
+            TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( file->mReadNextBlock( arrBlockData, attr ), 10 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 10 ), "AAAA\nBBBB\n" );
+            TS_ASSERT_EQUALS( file->mGetLineEnding(), FileIdentity::LF );
+            TS_ASSERT( ! attr.mHasFlag( Attributes::Crlf ) );
+            TS_ASSERT( file->mOffersInPlaceSave() );
+            delete file;
+
+            // Mixed line endings save exactly what was loaded, whatever the block size
+            strData = "x\r\ny\nz\r\nA lone\rCR\r\n";
+            for( OffSet offBlock = 2 ; offBlock < 30 ; ++offBlock ) {
+                ioOut.open( TEST_FILE, std::ios::binary | std::ios::trunc );
+                ioOut << strData;
+                ioOut.close();
+
+                ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+                file = new Utf8File( ioHandle );
+                file->mSetNormalize( true );
+                file->mSetBlockSize( offBlock );
+                TS_ASSERT_EQUALS( file->mPrepareLoad(), true );
+
+                std::vector<string> vecBlocks;
+                std::vector<Attributes> vecAttr;
+                OffSet offLen = 0;
+                while( ( offLen = file->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                    vecBlocks.push_back( string( arrBlockData, offLen ) );
+                    vecAttr.push_back( attr );
+                }
+                TS_ASSERT_EQUALS( offLen, 0 );
+                TS_ASSERT_EQUALS( file->mGetLineEnding(), FileIdentity::Mixed );
+                TS_ASSERT( ! file->mOffersInPlaceSave() );
+                TS_ASSERT_EQUALS( file->mFinalizeLoad(), true );
+
+                TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+                for( size_t i = 0 ; i < vecBlocks.size() ; ++i ) {
+                    TS_ASSERT_EQUALS( file->mWriteNextBlock( vecBlocks[i].data(), vecBlocks[i].size(), vecAttr[i] ), 
+                                      OffSet( vecBlocks[i].size() ) );
+                }
+                TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+                delete file;
+
+                std::ifstream ioMixed( TEST_FILE, std::ios::binary );
+                string strMixed( ( std::istreambuf_iterator<char>( ioMixed ) ), std::istreambuf_iterator<char>() );
+                TS_ASSERT( strMixed == strData );
+            }
+
+            delete[] arrBlockData;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testTranscodedFiles( void ) {
+            Attributes attr;
+            string strData;
+
+            // ASCII runs long enough for the vector paths, then two, three and four byte characters
+            for( int i = 0 ; i < 40 ; ++i ) strData += "AAAABBBBCCCCDDDDEEEE caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\r\n";
+
+            for( int intEndian = 0 ; intEndian < 2 ; ++intEndian ) {
+                bool boolBigEndian = intEndian;
+
+                createTestFile(TEST_FILE);
+                IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+                Utf16File* file = new Utf16File( ioHandle, boolBigEndian );
+
+                // Write blocks that split the multi-byte characters
+                TS_ASSERT_EQUALS( file->mPrepareSave(), true );
+                for( OffSet offset = 0 ; offset < OffSet( strData.size() ) ; offset += 7 ) {
+                    OffSet offLen = strData.size() - offset;
+                    if( offLen > 7 ) offLen = 7;
+                    TS_ASSERT_EQUALS( file->mWriteNextBlock( strData.data() + offset, offLen, attr ), offLen );
+                }
+                TS_ASSERT_EQUALS( file->mGetOffSet(), OffSet( strData.size() ) );
+                TS_ASSERT_EQUALS( file->mFinalizeSave(), true );
+                TS_ASSERT_EQUALS( file->mGetError(), "" );
+                delete file;
+
+                // The file starts with a byte order mark then "AA"
+                std::ifstream ioIn( TEST_FILE, std::ios::binary );
+                string strFile( ( std::istreambuf_iterator<char>( ioIn ) ), std::istreambuf_iterator<char>() );
+                ioIn.close();
+                if( boolBigEndian ) {
+                    TS_ASSERT_EQUALS( strFile.substr( 0, 6 ), string( "\xfe\xff\0A\0A", 6 ) );
+                } else {
+                    TS_ASSERT_EQUALS( strFile.substr( 0, 6 ), string( "\xff\xfe" "A\0A\0", 6 ) );
+                }
+                // 30 single units and a surrogate pair each line
+                TS_ASSERT_EQUALS( strFile.size(), 2 + 40 * ( 30 * 2 + 4 ) );
+
+                // Identify it and read it back in small blocks
+                ioHandle = IOHandle::mGetDefaultIOHandler();
+                TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+                FileIdentity identity;
+                File* fileRead = File::mIdentifyFile( ioHandle, &identity );
+                TS_ASSERT_EQUALS( identity._intEncoding, boolBigEndian ? FileIdentity::Utf16BE : FileIdentity::Utf16LE );
+                TS_ASSERT( dynamic_cast<Utf16File*>( fileRead ) );
+                fileRead->mSetBlockSize( 11 );
+
+                char arrBlockData[ 11 ];
+                string strRead;
+                OffSet offLen = 0;
+                TS_ASSERT_EQUALS( fileRead->mPrepareLoad(), true );
+                while( ( offLen = fileRead->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+                    TS_ASSERT( attr.mHasFlag( Attributes::Utf8Validated ) );
+                    TS_ASSERT( Utf8Validator::mValidate( arrBlockData, offLen ) );
+                    strRead.append( arrBlockData, offLen );
+                }
+                TS_ASSERT_EQUALS( offLen, 0 );
+                TS_ASSERT( strRead == strData );
+                TS_ASSERT_EQUALS( fileRead->mPeekNextBlock(), 0 );
+                TS_ASSERT( dynamic_cast<Utf16File*>( fileRead )->mHasBom() );
+
+                // Only the start of the file can be sought
+                TS_ASSERT_EQUALS( fileRead->mSetOffSet( 10 ), -1 );
+                offLen = fileRead->mReadBlock( 0, arrBlockData, attr );
+                TS_ASSERT( offLen > 0 );
+                TS_ASSERT_EQUALS( string( arrBlockData, offLen ), strData.substr( 0, offLen ) );
+                delete fileRead;
+            }
+
+            // A lone surrogate and an odd byte at the end become U+FFFD
+            createTestFile(TEST_FILE);
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            Utf16File* fileWide = new Utf16File( ioHandle );
+            char arrOut[ 64 ];
+            OffSet offUsed = 0;
+            TS_ASSERT_EQUALS( fileWide->mDecode( "A\0\x00\xd8" "B\0C", 7, arrOut, offUsed, true ), 8 );
+            TS_ASSERT_EQUALS( string( arrOut, 8 ), "A\xef\xbf\xbd" "B\xef\xbf\xbd" );
+            TS_ASSERT_EQUALS( offUsed, 7 );
+
+            // A high surrogate at the end waits for the rest of the pair
+            TS_ASSERT_EQUALS( fileWide->mDecode( "A\0\x3d\xd8", 4, arrOut, offUsed, false ), 1 );
+            TS_ASSERT_EQUALS( offUsed, 2 );
+            delete fileWide;
+
+            // Latin-1
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+            Latin1File* fileLatin1 = new Latin1File( ioHandle );
+            TS_ASSERT_EQUALS( fileLatin1->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( fileLatin1->mWriteNextBlock( "AAAABBBBCCCCDDDDEEEE caf\xc3", 25, attr ), 25 );
+            TS_ASSERT_EQUALS( fileLatin1->mWriteNextBlock( "\xa9 na\xc3\xafve\n", 9, attr ), 9 );
+            TS_ASSERT_EQUALS( fileLatin1->mFinalizeSave(), true );
+
+            struct stat sb;
+            TS_ASSERT_EQUALS( stat(TEST_FILE, &sb), 0 );
+            TS_ASSERT_EQUALS( sb.st_size, 32 );
+
+            // Reads half a block of Latin-1 so the UTF-8 always fits
+            char arrBlockData[ 40 ];
+            fileLatin1->mSetBlockSize( 40 );
+            TS_ASSERT_EQUALS( fileLatin1->mPrepareLoad(), true );
+            TS_ASSERT_EQUALS( fileLatin1->mReadNextBlock( arrBlockData, attr ), 20 );
+            TS_ASSERT_EQUALS( fileLatin1->mReadNextBlock( arrBlockData, attr ), 14 );
+            TS_ASSERT_EQUALS( string( arrBlockData, 14 ), " caf\xc3\xa9 na\xc3\xafve\n" );
+            TS_ASSERT_EQUALS( fileLatin1->mReadNextBlock( arrBlockData, attr ), 0 );
+
+            // Characters Latin-1 can not hold
+            TS_ASSERT_EQUALS( fileLatin1->mPrepareSave(), true );
+            TS_ASSERT_EQUALS( fileLatin1->mWriteNextBlock( "\xe2\x82\xac", 3, attr ), -1 );
+            TS_ASSERT_EQUALS( fileLatin1->mGetError(), "Transcode Error: U+20ac can not be written to the Latin-1 file '" TEST_FILE "'" );
+            delete fileLatin1;
+
+            // Delete the test file
+            if ( unlink(TEST_FILE) ) {
+                TS_FAIL( string("Unable to delete test file '" TEST_FILE  "' ") + strerror( errno ) );
+            }
+        }
+
 };
@@ -0,0 +1,723 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <File.h>
+#include <zlib.h>
+#include <string.h>
+#include <WorkerPool.h>
+
+// The most history a deflate stream can refer back to
+#define GZIP_WINDOW_SIZE    32768
+// The size of the compressed reads and writes
+#define GZIP_CHUNK_SIZE     65536
+
+/*!
+ * Where an inflater can resume reading without starting over
+ */
+class GzipCheckpoint {
+
+    public:
+        // The uncompressed offset
+        OffSet      offOut;
+        // The compressed offset of the first complete byte
+        OffSet      offIn;
+        // The bits of the byte before offIn that belong to the checkpoint
+        int         intBits;
+        // The output that came before the checkpoint, up to 32K
+        std::string strWindow;
+};
+
+/*!
+ * A chunk of data deflated on the WorkerPool
+ */
+class GzipJob : public WorkerJob {
+
+    public:
+        virtual void mRun( void );
+
+        std::string     strIn;
+        // The data before the chunk the deflater may refer back to
+        std::string     strDict;
+        std::string     strOut;
+        // The last chunk finishes the deflate stream
+        bool            boolLast;
+        bool            boolFailed;
+        unsigned long   intCrc;
+};
+
+/*!
+ * Deflate the chunk as raw deflate data that ends on a byte boundary,
+ * so the chunks can be written one after the other as a single stream
+ */
+void GzipJob::mRun( void ) {
+    z_stream zStream;
+
+    intCrc = crc32( crc32( 0, 0, 0 ), reinterpret_cast<const Bytef*>( strIn.data() ), strIn.size() );
+
+    memset( &zStream, 0, sizeof( z_stream ) );
+    if( deflateInit2( &zStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+        boolFailed = true;
+        return;
+    }
+
+    if( strDict.size() ) {
+        deflateSetDictionary( &zStream, reinterpret_cast<const Bytef*>( strDict.data() ), strDict.size() );
+    }
+
+    // Room for the worst case plus the empty block the sync flush adds
+    strOut.resize( deflateBound( &zStream, strIn.size() ) + 16 );
+
+    zStream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( strIn.data() ) );
+    zStream.avail_in = strIn.size();
+    zStream.next_out = reinterpret_cast<Bytef*>( &strOut[0] );
+    zStream.avail_out = strOut.size();
+
+    int intRet = deflate( &zStream, boolLast ? Z_FINISH : Z_SYNC_FLUSH );
+    if( ( boolLast and intRet != Z_STREAM_END ) or ( ! boolLast and intRet != Z_OK ) 
+        or zStream.avail_in != 0 ) {
+        boolFailed = true;
+    }
+
+    strOut.resize( strOut.size() - zStream.avail_out );
+    deflateEnd( &zStream );
+}
+
+/*!
+ * GzipFile Constructor
+ */
+GzipFile::GzipFile( IOHandle* const ioHandle, OffSet offSpan ) : File( ioHandle ), _zRead(0), _zWrite(0),
+                    _offSpan( offSpan ), _intWindowPos(0), _offIn(0), _offWritten(0), _boolRaw(false), 
+                    _boolBetween(true), _boolMember(false), _boolEnd(false), _intSkip(0),
+                    _intThreads( DEFAULT_GZIP_THREADS ), _ptrCompressor(0), _intCrc(0) {
+
+    _arrIn = new char[ GZIP_CHUNK_SIZE ];
+    _arrOut = new char[ GZIP_CHUNK_SIZE ];
+    _arrWindow = new char[ GZIP_WINDOW_SIZE ];
+}
+
+/*!
+ * GzipFile Destructor
+ */
+GzipFile::~GzipFile() {
+    mEnd();
+    mClearCheckpoints();
+    delete[] _arrIn;
+    delete[] _arrOut;
+    delete[] _arrWindow;
+}
+
+/*!
+ * Release the zlib streams
+ */
+void GzipFile::mEnd( void ) {
+    if( _zRead ) {
+        inflateEnd( _zRead );
+        delete _zRead;
+        _zRead = 0;
+    }
+    if( _zWrite ) {
+        deflateEnd( _zWrite );
+        delete _zWrite;
+        _zWrite = 0;
+    }
+    if( _ptrCompressor ) {
+        // Let the workers finish with any chunk they still hold
+        for( std::deque<GzipJob*>::iterator it = _queJobs.begin() ; it != _queJobs.end() ; ++it ) {
+            _ptrCompressor->mWait( *it );
+            delete *it;
+        }
+        _queJobs.clear();
+        delete _ptrCompressor;
+        _ptrCompressor = 0;
+    }
+    _strChunk.clear();
+    _strDict.clear();
+}
+
+void GzipFile::mClearCheckpoints( void ) {
+    for( std::vector<GzipCheckpoint*>::iterator it = _vecCheckpoints.begin() ; it != _vecCheckpoints.end() ; ++it ) {
+        delete *it;
+    }
+    _vecCheckpoints.clear();
+}
+
+/*!
+ * Read the next chunk of compressed data
+ * Returns the number of bytes read, 0 at the end of the file or -1 on error
+ */
+OffSet GzipFile::mFill( void ) {
+    OffSet offLen = 0;
+
+    // If we timeout waiting on clear to read
+    if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    if( ( offLen = _ioHandle->mRead( _arrIn, GZIP_CHUNK_SIZE ) ) < 0 ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    _zRead->next_in = reinterpret_cast<Bytef*>( _arrIn );
+    _zRead->avail_in = offLen;
+    _offIn += offLen;
+
+    return offLen;
+}
+
+/*!
+ * Start inflating again from the checkpoint, or from 
+ * the start of the file if no checkpoint is given
+ */
+bool GzipFile::mResetInflate( GzipCheckpoint* checkpoint ) {
+    int intRet = Z_OK;
+
+    if( ! _zRead ) {
+        _zRead = new z_stream;
+        memset( _zRead, 0, sizeof( z_stream ) );
+        if( inflateInit2( _zRead, 15 + 16 ) != Z_OK ) {
+            mSetError() << "Gzip Error: Unable to start inflating '" << mGetFileName() << "' - " << _zRead->msg;
+            delete _zRead;
+            _zRead = 0;
+            return false;
+        }
+    }
+
+    _zRead->avail_in = 0;
+    _intWindowPos = 0;
+    _intSkip = 0;
+    _boolEnd = false;
+
+    if( ! checkpoint ) {
+        if( _ioHandle->mSeek( 0 ) == -1 ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+        _offIn = 0;
+        _offCurrent = 0;
+        _boolRaw = false;
+        _boolBetween = true;
+        _boolMember = false;
+        inflateReset2( _zRead, 15 + 16 );
+        return true;
+    }
+
+    // Inflate the raw deflate data that follows the checkpoint
+    OffSet offSeek = checkpoint->offIn - ( checkpoint->intBits ? 1 : 0 );
+    if( _ioHandle->mSeek( offSeek ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _offIn = offSeek;
+    _boolRaw = true;
+    _boolBetween = false;
+    inflateReset2( _zRead, -15 );
+
+    // Feed the bits of the partial byte the checkpoint starts in
+    if( checkpoint->intBits ) {
+        if( mFill() <= 0 ) {
+            if( ! mGetError().size() ) mSetError() << "Gzip Error: '" << mGetFileName() << "' is shorter than the checkpoint";
+            return false;
+        }
+        int intByte = *_zRead->next_in;
+        ++_zRead->next_in;
+        --_zRead->avail_in;
+        intRet = inflatePrime( _zRead, checkpoint->intBits, intByte >> ( 8 - checkpoint->intBits ) );
+    }
+
+    if( intRet == Z_OK ) {
+        intRet = inflateSetDictionary( _zRead, reinterpret_cast<const Bytef*>( checkpoint->strWindow.data() ), 
+                                       checkpoint->strWindow.size() );
+    }
+
+    if( intRet != Z_OK ) {
+        mSetError() << "Gzip Error: Unable to resume inflating '" << mGetFileName() << "' at offset " << checkpoint->offOut;
+        return false;
+    }
+
+    // The window holds the output that came before the checkpoint
+    memcpy( _arrWindow, checkpoint->strWindow.data(), checkpoint->strWindow.size() );
+    _intWindowPos = checkpoint->strWindow.size() % GZIP_WINDOW_SIZE;
+    _offCurrent = checkpoint->offOut;
+
+    return true;
+}
+
+/*!
+ * Record a checkpoint at the current position, the inflater
+ * must be stopped at the start of a deflate block
+ */
+void GzipFile::mAddCheckpoint( void ) {
+    GzipCheckpoint* checkpoint = new GzipCheckpoint();
+
+    checkpoint->offOut = _offCurrent;
+    checkpoint->offIn = _offIn - _zRead->avail_in;
+    checkpoint->intBits = _zRead->data_type & 7;
+
+    // Save the window oldest bytes first
+    if( _offCurrent >= GZIP_WINDOW_SIZE ) {
+        checkpoint->strWindow.assign( _arrWindow + _intWindowPos, GZIP_WINDOW_SIZE - _intWindowPos );
+        checkpoint->strWindow.append( _arrWindow, _intWindowPos );
+    } else {
+        checkpoint->strWindow.assign( _arrWindow, _intWindowPos );
+    }
+
+    _vecCheckpoints.push_back( checkpoint );
+}
+
+/*!
+ * Inflate up to offSize bytes into the buffer, or discard 
+ * them if the buffer is 0. Returns the bytes inflated, 
+ * 0 at the end of the file or -1 on error
+ */
+OffSet GzipFile::mInflate( char* arrBuffer, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize and ! _boolEnd ) {
+
+        if( _zRead->avail_in == 0 ) {
+            OffSet offLen = mFill();
+            if( offLen < 0 ) return -1;
+            if( offLen == 0 ) {
+                if( _boolBetween ) {
+                    _boolEnd = true;
+                    break;
+                }
+                mSetError() << "Gzip Error: Unexpected end of compressed data in '" << mGetFileName() << "'";
+                return -1;
+            }
+        }
+
+        // Skip the trailer of the member we inflated raw
+        if( _intSkip ) {
+            int intLen = _intSkip;
+            if( (unsigned int)intLen > _zRead->avail_in ) intLen = _zRead->avail_in;
+            _zRead->next_in += intLen;
+            _zRead->avail_in -= intLen;
+            _intSkip -= intLen;
+            continue;
+        }
+
+        OffSet offWant = GZIP_WINDOW_SIZE - _intWindowPos;
+        if( offWant > offSize - offTotal ) offWant = offSize - offTotal;
+
+        _zRead->next_out = reinterpret_cast<Bytef*>( _arrWindow + _intWindowPos );
+        _zRead->avail_out = offWant;
+
+        // Stop at the end of each deflate block, so we can record checkpoints
+        int intRet = inflate( _zRead, Z_BLOCK );
+
+        OffSet offLen = offWant - _zRead->avail_out;
+        if( offLen ) {
+            if( arrBuffer ) memcpy( arrBuffer + offTotal, _arrWindow + _intWindowPos, offLen );
+            _intWindowPos = ( _intWindowPos + offLen ) % GZIP_WINDOW_SIZE;
+            offTotal += offLen;
+            _offCurrent += offLen;
+            _boolBetween = false;
+        }
+
+        if( intRet == Z_STREAM_END ) {
+            // The trailer is still in the input, the next member is a gzip stream again
+            if( _boolRaw ) {
+                _intSkip = 8;
+                _boolRaw = false;
+                inflateReset2( _zRead, 15 + 16 );
+            } else {
+                inflateReset( _zRead );
+            }
+            _boolBetween = true;
+            _boolMember = true;
+            continue;
+        }
+
+        if( intRet != Z_OK and intRet != Z_BUF_ERROR ) {
+            // Ignore anything after the last member that is not gzip, a bad first member is an error
+            if( _boolBetween and _boolMember and intRet == Z_DATA_ERROR ) {
+                _boolEnd = true;
+                break;
+            }
+            mSetError() << "Gzip Error: Unable to inflate '" << mGetFileName() << "' - " << ( _zRead->msg ? _zRead->msg : "corrupt data" );
+            return -1;
+        }
+
+        // At the start of a deflate block and far enough past the last checkpoint
+        if( ( _zRead->data_type & 128 ) and ! ( _zRead->data_type & 64 ) ) {
+            OffSet offLast = 0;
+            if( _vecCheckpoints.size() ) offLast = _vecCheckpoints.back()->offOut;
+            if( _offCurrent - offLast >= _offSpan ) mAddCheckpoint();
+        }
+    }
+
+    return offTotal;
+}
+
+/*!
+ * We do not know how much data is left until we inflate it
+ */
+OffSet GzipFile::mPeekNextBlock( void ) {
+    if( _boolEnd ) return 0;
+    return _offBlockSize;
+}
+
+/*
+ * Inflate the next block of text starting at the last read offset
+ *
+ * Gzip files have no additional attributes, we ignore the 
+ * attributes reference passed
+ */
+OffSet GzipFile::mReadNextBlock( char* arrBlockData, Attributes& ) {
+    assert( _ioHandle != 0 );
+
+    if( ! _zRead and ! mResetInflate( 0 ) ) return -1;
+
+    return mInflate( arrBlockData, _offBlockSize );
+}
+
+/*
+ * Inflate a block of text at specific offset
+ */
+OffSet GzipFile::mReadBlock( OffSet offset, char* arrBlockData, Attributes& attr ) {
+
+    // Set the current offset
+    if( mSetOffSet( offset ) == -1 ) {
+        return -1;
+    }
+
+    return mReadNextBlock( arrBlockData, attr );
+}
+
+/*
+ * Move to an uncompressed offset, resuming from the nearest checkpoint
+ * before the offset unless continuing from where we are is closer
+ */
+OffSet GzipFile::mSetOffSet( OffSet offset ) {
+    assert( _ioHandle != 0 ); 
+
+    if( _zWrite or _ptrCompressor ) {
+        if( offset == _offCurrent ) return _offCurrent;
+        mSetError("GzipFile can only write sequentially");
+        return -1;
+    }
+
+    if( ! _zRead and ! mResetInflate( 0 ) ) return -1;
+
+    // Return if the requested location is the same
+    if( _offCurrent == offset ) return _offCurrent;
+
+    if( offset < 0 ) {
+        mSetError() << "Gzip Error: Invalid offset " << offset;
+        return -1;
+    }
+
+    // Find the last checkpoint at or before the offset
+    GzipCheckpoint* checkpoint = 0;
+    for( std::vector<GzipCheckpoint*>::iterator it = _vecCheckpoints.begin() ; it != _vecCheckpoints.end() ; ++it ) {
+        if( (*it)->offOut > offset ) break;
+        checkpoint = *it;
+    }
+
+    // Start over unless we can get there by reading forward
+    if( offset < _offCurrent or ( checkpoint and checkpoint->offOut > _offCurrent ) ) {
+
+        // Resuming needs to seek the compressed data
+        if( ! _ioHandle->mOffersSeek() ) {
+            mSetError("Current IO Device does not support file seeks");
+            return -1;
+        }
+
+        if( ! mResetInflate( checkpoint ) ) return -1;
+    }
+
+    // Inflate up to the offset, recording checkpoints as we go
+    while( _offCurrent < offset ) {
+        OffSet offSkip = offset - _offCurrent;
+        if( offSkip > GZIP_CHUNK_SIZE ) offSkip = GZIP_CHUNK_SIZE;
+
+        OffSet offLen = mInflate( 0, offSkip );
+        if( offLen < 0 ) return -1;
+        if( offLen == 0 ) {
+            mSetError() << "Gzip Error: Offset " << offset << " is past the end of '" << mGetFileName() << "'";
+            return -1;
+        }
+    }
+
+    return _offCurrent;
+}
+
+/**
+ * Prepare to load a file
+ */
+bool GzipFile::mPrepareLoad( void ) {
+    return mResetInflate( 0 );
+}
+
+/**
+ * Finalize the load
+ */
+bool GzipFile::mFinalizeLoad( void ) {
+    return true;
+}
+
+/*!
+ * Write all the bytes to the handle
+ */
+bool GzipFile::mWriteAll( const char* arrData, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize ) {
+        // If we timeout waiting on clear to write
+        if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+
+        OffSet offLen = _ioHandle->mWrite( arrData + offTotal, offSize - offTotal );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+        offTotal += offLen;
+    }
+
+    _offWritten += offTotal;
+    return true;
+}
+
+/*!
+ * Run the deflater over the pending input, writing the output as it fills
+ */
+bool GzipFile::mDeflate( int intFlush ) {
+    int intRet = Z_OK;
+
+    do {
+        _zWrite->next_out = reinterpret_cast<Bytef*>( _arrOut );
+        _zWrite->avail_out = GZIP_CHUNK_SIZE;
+
+        intRet = deflate( _zWrite, intFlush );
+        if( intRet == Z_STREAM_ERROR ) {
+            mSetError() << "Gzip Error: Unable to deflate '" << mGetFileName() << "'";
+            return false;
+        }
+
+        if( ! mWriteAll( _arrOut, GZIP_CHUNK_SIZE - _zWrite->avail_out ) ) return false;
+
+    } while( _zWrite->avail_out == 0 );
+
+    return true;
+}
+
+/**
+ * Prepare to save a file, we always write the whole file from the start
+ */
+bool GzipFile::mPrepareSave( void ) {
+
+    // What we read before is about to change
+    mEnd();
+    mClearCheckpoints();
+
+    if( _ioHandle->mSeek( 0 ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    _offCurrent = 0;
+    _offWritten = 0;
+
+    int intThreads = WorkerPool::mThreadsFor( _intThreads );
+
+    // Compress the chunks on a pool of threads
+    if( intThreads > 1 ) {
+        static const char arrHeader[] = { 0x1f, char(0x8b), Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
+
+        _ptrCompressor = new WorkerPool( intThreads );
+        _intCrc = crc32( 0, 0, 0 );
+        return mWriteAll( arrHeader, sizeof( arrHeader ) );
+    }
+
+    _zWrite = new z_stream;
+    memset( _zWrite, 0, sizeof( z_stream ) );
+    if( deflateInit2( _zWrite, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+        mSetError() << "Gzip Error: Unable to start deflating '" << mGetFileName() << "'";
+        delete _zWrite;
+        _zWrite = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * Hand the chunk to the compressor, waiting for the oldest 
+ * chunk to be written if too many are in flight
+ */
+bool GzipFile::mQueueChunk( bool boolLast ) {
+    GzipJob* job = new GzipJob();
+
+    job->strIn.swap( _strChunk );
+    job->strDict = _strDict;
+    job->boolLast = boolLast;
+    job->boolFailed = false;
+    job->intCrc = 0;
+
+    // The next chunk may refer back to the last 32K of data
+    if( job->strIn.size() >= GZIP_WINDOW_SIZE ) {
+        _strDict.assign( job->strIn, job->strIn.size() - GZIP_WINDOW_SIZE, GZIP_WINDOW_SIZE );
+    } else {
+        _strDict.append( job->strIn );
+        if( _strDict.size() > GZIP_WINDOW_SIZE ) _strDict.erase( 0, _strDict.size() - GZIP_WINDOW_SIZE );
+    }
+
+    _queJobs.push_back( job );
+    _ptrCompressor->mSubmit( job );
+
+    while( _queJobs.size() > size_t( _ptrCompressor->mGetThreads() * 2 ) ) {
+        if( ! mCollectChunk() ) return false;
+    }
+    return true;
+}
+
+/*!
+ * Wait for the oldest chunk to be compressed and write it
+ */
+bool GzipFile::mCollectChunk( void ) {
+    GzipJob* job = _queJobs.front();
+    _queJobs.pop_front();
+
+    _ptrCompressor->mWait( job );
+
+    if( job->boolFailed ) {
+        mSetError() << "Gzip Error: Unable to deflate '" << mGetFileName() << "'";
+        delete job;
+        return false;
+    }
+
+    _intCrc = crc32_combine( _intCrc, job->intCrc, job->strIn.size() );
+    bool boolResult = mWriteAll( job->strOut.data(), job->strOut.size() );
+
+    delete job;
+    return boolResult;
+}
+
+/*
+ * Compress a block of text at a specific offset, the 
+ * offset must be where the last block ended
+ */
+OffSet GzipFile::mWriteBlock( OffSet offset, const char* arrBlockData, OffSet offBlockSize, Attributes& attr ) {
+
+    if( offset != _offCurrent ) {
+        mSetError("GzipFile can only write sequentially");
+        return -1;
+    }
+
+    return mWriteNextBlock( arrBlockData, offBlockSize, attr );
+}
+
+/*
+ * Compress the next block of text
+ */
+OffSet GzipFile::mWriteNextBlock( const char* arrBlockData, OffSet offBlockSize, Attributes& ) {
+    assert( _ioHandle != 0 );
+
+    if( _ptrCompressor ) {
+        OffSet offDone = 0;
+
+        // Fill the chunk, queue it once it is full
+        while( offDone < offBlockSize ) {
+            OffSet offLen = DEFAULT_GZIP_CHUNK - _strChunk.size();
+            if( offLen > offBlockSize - offDone ) offLen = offBlockSize - offDone;
+
+            _strChunk.append( arrBlockData + offDone, offLen );
+            offDone += offLen;
+
+            if( _strChunk.size() == DEFAULT_GZIP_CHUNK and ! mQueueChunk( false ) ) return -1;
+        }
+
+        // Keep track of where in the file we are
+        _offCurrent += offBlockSize;
+        return offBlockSize;
+    }
+
+    if( ! _zWrite ) {
+        mSetError("GzipFile::mPrepareSave() must be called before writing");
+        return -1;
+    }
+
+    _zWrite->next_in = reinterpret_cast<Bytef*>( const_cast<char*>( arrBlockData ) );
+    _zWrite->avail_in = offBlockSize;
+
+    if( ! mDeflate( Z_NO_FLUSH ) ) return -1;
+
+    // Keep track of where in the file we are
+    _offCurrent += offBlockSize;
+
+    return offBlockSize;
+}
+
+/**
+ * Finish the gzip stream and truncate anything 
+ * left over from a larger file
+ */
+bool GzipFile::mFinalizeSave( void ) {
+    bool boolResult = true;
+
+    if( _ptrCompressor ) {
+        boolResult = mQueueChunk( true );
+        while( boolResult and _queJobs.size() ) {
+            boolResult = mCollectChunk();
+        }
+
+        // The gzip trailer is the crc and the size, least significant byte first
+        if( boolResult ) {
+            char arrTrailer[ 8 ];
+            unsigned long intSize = _offCurrent;
+            for( int i = 0 ; i < 4 ; ++i ) {
+                arrTrailer[ i ] = ( _intCrc >> ( i * 8 ) ) & 0xff;
+                arrTrailer[ i + 4 ] = ( intSize >> ( i * 8 ) ) & 0xff;
+            }
+            boolResult = mWriteAll( arrTrailer, 8 );
+        }
+
+        mEnd();
+
+    } else {
+
+        if( ! _zWrite ) {
+            mSetError("GzipFile::mPrepareSave() must be called before writing");
+            return false;
+        }
+
+        _zWrite->avail_in = 0;
+        boolResult = mDeflate( Z_FINISH );
+
+        deflateEnd( _zWrite );
+        delete _zWrite;
+        _zWrite = 0;
+    }
+
+    if( ! boolResult ) return false;
+
+    if( _ioHandle->mTruncate( _offWritten ) == false ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    return true;
+}
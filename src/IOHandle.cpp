@@ -19,6 +19,7 @@
  **/
 
 #include <IOHandle.h>
+#include <IOReadiness.h>
 
 // --- Begin posixfile.cpp ---
 
@@ -26,11 +27,70 @@
 #include <string.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+#include <pthread.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+static pthread_mutex_t mutexPool = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<char*> vecPool;
+
+/*!
+ * Return a DEFAULT_DIRECT_SIZE buffer aligned to offAlignment, 
+ * the buffer must be returned with mRelease()
+ */
+char* AlignedBufferPool::mAcquire( OffSet offAlignment ) {
+    void* ptrBuffer = 0;
+
+    // Page aligned buffers satisfy any device we are likely to see
+    if( offAlignment < 4096 ) offAlignment = 4096;
+
+    pthread_mutex_lock( &mutexPool );
+    for( std::vector<char*>::iterator it = vecPool.begin() ; it != vecPool.end() ; ++it ) {
+        if( ( (unsigned long)*it % offAlignment ) == 0 ) {
+            char* arrBuffer = *it;
+            vecPool.erase( it );
+            pthread_mutex_unlock( &mutexPool );
+            return arrBuffer;
+        }
+    }
+    pthread_mutex_unlock( &mutexPool );
+
+    if( posix_memalign( &ptrBuffer, offAlignment, DEFAULT_DIRECT_SIZE ) != 0 ) return 0;
+    return static_cast<char*>( ptrBuffer );
+}
+
+/*!
+ * Keep the buffer for the next handle, unless the pool is full
+ */
+void AlignedBufferPool::mRelease( char* arrBuffer ) {
+
+    if( ! arrBuffer ) return;
+
+    pthread_mutex_lock( &mutexPool );
+    if( vecPool.size() < DEFAULT_DIRECT_POOL ) {
+        vecPool.push_back( arrBuffer );
+        arrBuffer = 0;
+    }
+    pthread_mutex_unlock( &mutexPool );
+
+    free( arrBuffer );
+}
 
 /*!
  * IOHandle Constructor
  */
-PosixIOHandle::PosixIOHandle() { }
+PosixIOHandle::PosixIOHandle( bool boolDirect ) : _boolStream(false), _boolDirect( boolDirect ), _offAlignment(1), 
+                                                  _arrDirect(0), _offDirectStart(0), _offDirectLen(0), _offDirectPosition(0),
+                                                  _boolRegistered(false), _intWatchEvents(0), _intReadyEvents(0), 
+                                                  _intDeadline(0), _boolInEpoll(false) { }
 
 /*!
  * IOHandle Destructor
@@ -47,7 +107,18 @@ PosixIOHandle::~PosixIOHandle() {
  */
 bool PosixIOHandle::mClose( void ) {
    
-    close(_ioFile); 
+    // Stop waiting on the file before closing it
+    if( _boolRegistered ) { 
+        IOReadiness::mShared()->mRemove( this );
+        _boolRegistered = false;
+    }
+
+    if( _arrDirect ) {
+        AlignedBufferPool::mRelease( _arrDirect );
+        _arrDirect = 0;
+    }
+
+    if( _ioFile > 0 ) { close(_ioFile); }
     _ioFile = 0;
     return true;
 }
@@ -71,23 +142,112 @@ bool PosixIOHandle::mOpen( const char* strFileName , OpenMode mode ) {
         return false;
     }
 
-    // Record the total size of the file
-    if( ( _offFileSize = lseek(_ioFile, 0, SEEK_END) ) == -1 ) { 
-        mSetError() << "IO Error: Unable to seek the EOF '" << strFileName << "' - " <<  strerror( errno );
+    struct stat sb;
+    if( fstat( _ioFile, &sb ) == -1 ) {
+        mSetError() << "IO Error: Unable to stat '" << strFileName << "' - " <<  strerror( errno );
         return false;
     }
 
-    // Return to the begining of the file
-    if( lseek(_ioFile, 0, SEEK_SET)  == -1 ) { 
-        mSetError() << "IO Error: Unable to seek to offset 0 '" << strFileName << "' - " <<  strerror( errno );
-        return false;
+    _offDeviceBlock = sb.st_blksize;
+
+    // Pipes, FIFOs and sockets have no size and can not seek, 
+    // they are the only files that need to wait before a read or write
+    _boolStream = ! ( S_ISREG( sb.st_mode ) or S_ISBLK( sb.st_mode ) );
+
+    if( _boolStream ) {
+        _offFileSize = 0;
+        _boolRegistered = IOReadiness::mShared()->mAdd( this );
+    } else {
+        // Record the total size of the file
+        if( ( _offFileSize = lseek(_ioFile, 0, SEEK_END) ) == -1 ) { 
+            mSetError() << "IO Error: Unable to seek the EOF '" << strFileName << "' - " <<  strerror( errno );
+            return false;
+        }
+
+        // Return to the begining of the file
+        if( lseek(_ioFile, 0, SEEK_SET)  == -1 ) { 
+            mSetError() << "IO Error: Unable to seek to offset 0 '" << strFileName << "' - " <<  strerror( errno );
+            return false;
+        }
     }
 
     // TODO: Record the last time this file was modified
     
     _strName = strFileName;
 
+    // Writes would need every block padded to the alignment, only reads go direct.
+    // If the filesystem refuses direct IO ( IE: tmpfs ) we read through the cache
+    if( _boolDirect and mode == ReadOnly and S_ISREG( sb.st_mode ) ) mOpenDirect();
+
+    return true;
+}
+
+/*!
+ * Switch the open file to direct IO, reads then bypass the page cache
+ * Returns false if the file system does not support direct IO
+ */
+bool PosixIOHandle::mOpenDirect( void ) {
+    // Buffered IO needs no alignment, only a successful switch changes it
+    _offAlignment = 1;
+
+#ifdef O_DIRECT
+    OffSet offAlignment = 4096;
+
+#if defined( STATX_DIOALIGN )
+    // Ask the file system for the alignment it needs
+    struct statx stx;
+    if( statx( _ioFile, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx ) == 0 and ( stx.stx_mask & STATX_DIOALIGN ) ) {
+        if( stx.stx_dio_offset_align == 0 ) return false;
+        offAlignment = stx.stx_dio_offset_align;
+        if( stx.stx_dio_mem_align > offAlignment ) offAlignment = stx.stx_dio_mem_align;
+    }
+#endif
+
+    int intFlags = fcntl( _ioFile, F_GETFL );
+    if( intFlags == -1 or fcntl( _ioFile, F_SETFL, intFlags | O_DIRECT ) == -1 ) return false;
+
+    if( ! ( _arrDirect = AlignedBufferPool::mAcquire( offAlignment ) ) ) {
+        fcntl( _ioFile, F_SETFL, intFlags );
+        return false;
+    }
+
+    _offAlignment = offAlignment;
+    _offDirectStart = 0;
+    _offDirectLen = 0;
+    _offDirectPosition = 0;
     return true;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * Wait for the stream to become ready for intEvents
+ * Return 0 if ready, 1 if we timed out, -1 if there was an error
+ */
+int PosixIOHandle::mWaitFor( int intEvents, int intSeconds ) {
+
+    // The shared epoll instance can wait on this stream
+    if( _boolRegistered ) {
+        return IOReadiness::mShared()->mWait( this, intEvents, intSeconds );
+    }
+
+    // No epoll, poll() still handles file descriptors above FD_SETSIZE
+    struct pollfd pfd;
+    pfd.fd = _ioFile;
+    pfd.events = 0;
+    pfd.revents = 0;
+    if( intEvents & IOReadiness::Read ) pfd.events |= POLLIN;
+    if( intEvents & IOReadiness::Write ) pfd.events |= POLLOUT;
+
+    int intVal = 0;
+    while( ( intVal = poll( &pfd, 1, intSeconds * 1000 ) ) == -1 and errno == EINTR );
+
+    if( intVal == -1 ) return -1;
+    if( intVal == 0 ) return 1;
+
+    // Descriptors that do not support polling ( IE: /dev/null ) are always ready
+    return 0;
 }
 
 /*! 
@@ -95,31 +255,27 @@ bool PosixIOHandle::mOpen( const char* strFileName , OpenMode mode ) {
  * Return -1 if there was an error
  * Return 1 if we timed out
  *
- * This should never be an issue on local filesystems, However there 
- * is no way of knowing if the filesystem is a remote mount, in which case 
- * the read might block in case of network outage. 
- * However this check creates a penalty when reading very large files. If performance 
- * becomes an issue this method could always return true and ignore the block check.
+ * Regular files and block devices never wait, select() or epoll would 
+ * always report them as ready anyway. Remote mounts that block during 
+ * an outage block inside read() where no readiness check can help.
  *
+ * Pipes, FIFOs and sockets wait using the IOReadiness epoll instance
+ * shared by all handles.
  */
 int PosixIOHandle::mWaitForClearToRead( int intSeconds ) {
-    struct timeval tv;
-    fd_set readfds;
-    int intVal = 0;
 
-    tv.tv_sec   = intSeconds;
-    tv.tv_usec  = 0;
+    if( ! _boolStream ) return 0;
+
+    IOStatsTimer timer( _stats, IOStats::Wait );
 
-    FD_ZERO(&readfds);
-    FD_SET(_ioFile, &readfds);
+    int intVal = mWaitFor( IOReadiness::Read, intSeconds );
 
-    if( ( intVal = select(_ioFile+1, &readfds, NULL, NULL, &tv) ) == -1 ) {
-        mSetError() << "IO Error: select error while waiting to read '" << _strName << "' - " <<  strerror( errno );
+    if( intVal == -1 ) {
+        mSetError() << "IO Error: epoll error while waiting to read '" << _strName << "' - " <<  IOReadiness::mShared()->mGetError();
         return -1; 
     }
 
-    // select timed out TODO: Should we check FD_ISSET instead?
-    if( intVal == 0 ) { 
+    if( intVal == 1 ) { 
         mSetError() << "IO Error: Timeout waiting to read '" << _strName << "'";
         return 1; 
     }
@@ -128,28 +284,27 @@ int PosixIOHandle::mWaitForClearToRead( int intSeconds ) {
 }
 
 /*! 
- * Return 0 if the read will not block
+ * Return 0 if the write will not block
  * Return -1 if there was an error
  * Return 1 if we timed out
  */
 int PosixIOHandle::mWaitForClearToWrite( int intSeconds ) {
-    struct timeval tv;
-    fd_set writefds;
-    int intVal = 0;
 
-    tv.tv_sec   = intSeconds;
-    tv.tv_usec  = 0;
+    if( ! _boolStream ) return 0;
+
+    IOStatsTimer timer( _stats, IOStats::Wait );
 
-    FD_ZERO(&writefds);
-    FD_SET(_ioFile, &writefds);
+    int intVal = mWaitFor( IOReadiness::Write, intSeconds );
 
-    if( ( intVal = select(_ioFile+1, NULL, &writefds, NULL, &tv) ) == -1 ) {
-        mSetError() << "IO Error: select error while waiting to write '" << _strName << "' - " <<  strerror( errno );
+    if( intVal == -1 ) {
+        mSetError() << "IO Error: epoll error while waiting to write '" << _strName << "' - " <<  IOReadiness::mShared()->mGetError();
         return -1; 
     }
 
-    // select timed out TODO: Should we check FD_ISSET instead?
-    if( intVal == 0 ) { return 1; }
+    if( intVal == 1 ) { 
+        mSetError() << "IO Error: Timeout waiting to write '" << _strName << "'";
+        return 1; 
+    }
 
     return 0;
 }
@@ -159,6 +314,17 @@ int PosixIOHandle::mWaitForClearToWrite( int intSeconds ) {
  */
 OffSet PosixIOHandle::mSeek( OffSet offset ) {
     OffSet offVal = 0; 
+    IOStatsTimer timer( _stats, IOStats::Seek );
+
+    // Direct reads use pread(), just remember where we are
+    if( _arrDirect ) {
+        if( offset < 0 ) {
+            mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+            return -1;
+        }
+        _offDirectPosition = offset;
+        return offset;
+    }
 
     // Seek to the required offset in the file
     if( ( offVal = lseek(_ioFile, offset, SEEK_SET) )  == -1 ) { 
@@ -175,46 +341,577 @@ OffSet PosixIOHandle::mSeek( OffSet offset ) {
 OffSet PosixIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
     OffSet offVal = 0;
 
+    if( _arrDirect ) return mReadDirect( cstrBuffer, offSize );
+
+    IOStatsTimer timer( _stats, IOStats::Read );
+
     // Read the data 
     if( ( offVal = read( _ioFile, cstrBuffer, offSize ) ) == -1 ) { 
         mSetError() << "IO Error: Unable to read " << offSize << " bytes from '" << _strName << "' - " <<  strerror( errno );
         return -1;
     }
+    timer.mSetBytes( offVal );
     return offVal;
 
 }
 
+/*!
+ * Read with direct IO, the file is read in aligned chunks into the aligned
+ * buffer and copied out. When the callers buffer, size and position are all
+ * aligned the data is read straight into the callers buffer
+ */
+OffSet PosixIOHandle::mReadDirect( char* cstrBuffer, OffSet offSize ) {
+    OffSet offVal = 0;
+
+    // Serve the read from what we already have
+    if( _offDirectPosition < _offDirectStart or _offDirectPosition >= _offDirectStart + _offDirectLen ) {
+        OffSet offMask = _offAlignment - 1;
+
+        // Read straight into the callers buffer
+        if( ( _offDirectPosition & offMask ) == 0 and ( (unsigned long)cstrBuffer & offMask ) == 0 
+                and offSize >= _offAlignment ) {
+            IOStatsTimer timer( _stats, IOStats::Read );
+
+            while( ( offVal = pread( _ioFile, cstrBuffer, offSize & ~offMask, _offDirectPosition ) ) == -1 
+                    and errno == EINTR );
+            if( offVal == -1 ) {
+                mSetError() << "IO Error: Unable to read " << offSize << " bytes from '" << _strName << "' - " <<  strerror( errno );
+                return -1;
+            }
+            timer.mSetBytes( offVal );
+            _offDirectPosition += offVal;
+            return offVal;
+        }
+
+        IOStatsTimer timer( _stats, IOStats::Read );
+
+        _offDirectStart = _offDirectPosition & ~offMask;
+        _offDirectLen = 0;
+        while( ( offVal = pread( _ioFile, _arrDirect, DEFAULT_DIRECT_SIZE, _offDirectStart ) ) == -1 and errno == EINTR );
+        if( offVal == -1 ) {
+            mSetError() << "IO Error: Unable to read " << offSize << " bytes from '" << _strName << "' - " <<  strerror( errno );
+            return -1;
+        }
+        timer.mSetBytes( offVal );
+        _offDirectLen = offVal;
+
+        // End of the file
+        if( _offDirectPosition >= _offDirectStart + _offDirectLen ) return 0;
+    }
+
+    OffSet offLen = ( _offDirectStart + _offDirectLen ) - _offDirectPosition;
+    if( offLen > offSize ) offLen = offSize;
+
+    memcpy( cstrBuffer, _arrDirect + ( _offDirectPosition - _offDirectStart ), offLen );
+    _offDirectPosition += offLen;
+
+    return offLen;
+}
+
 /*!
  * Writes in the file to the file handle
  *
  */
 OffSet PosixIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
     OffSet offVal = 0;
+    IOStatsTimer timer( _stats, IOStats::Write );
 
     // Write the data 
     if( ( offVal = write( _ioFile, cstrBuffer, offSize ) ) == -1 ) { 
         mSetError() << "IO Error: Unable to write " << offSize << " bytes to '" << _strName << "' - " <<  strerror( errno );
         return -1;
     }
+    timer.mSetBytes( offVal );
+    return offVal;
+
+}
+
+/*!
+ * Writes all the buffers to the file handle with as few syscalls as possible
+ */
+OffSet PosixIOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+    OffSet offVal = 0;
+    IOStatsTimer timer( _stats, IOStats::Write );
+
+    if( ( offVal = mWriteAllV( _ioFile, arrIov, intCount, -1 ) ) == -1 ) { 
+        mSetError() << "IO Error: Unable to write " << intCount << " buffers to '" << _strName << "' - " <<  strerror( errno );
+        return -1;
+    }
+    timer.mSetBytes( offVal );
     return offVal;
 
 }
 
+/*!
+ * Writes the buffers IOV_MAX at a time with writev(), pwritev() if an 
+ * offset is given, or vmsplice() if boolSplice is true, resuming after 
+ * any partial writes. Returns the number of bytes written or -1 with errno set
+ */
+static OffSet writeAllV( int ioFile, const struct iovec* arrIov, int intCount, OffSet offset, bool boolSplice ) {
+    struct iovec arrBatch[ IOV_MAX ];
+    OffSet offTotal = 0;
+    int intDone = 0;
+
+    while( intDone < intCount ) {
+        int intBatch = intCount - intDone;
+        if( intBatch > IOV_MAX ) intBatch = IOV_MAX;
+
+        // Copy the batch so we can adjust it after a partial write
+        memcpy( arrBatch, arrIov + intDone, intBatch * sizeof(struct iovec) );
+        struct iovec* ptrIov = arrBatch;
+
+        while( intBatch ) {
+            ssize_t intLen = 0;
+#ifdef __linux__
+            if( boolSplice ) {
+                intLen = vmsplice( ioFile, ptrIov, intBatch, 0 );
+            } else
+#endif
+            if( offset == -1 ) { 
+                intLen = writev( ioFile, ptrIov, intBatch );
+            } else {
+                intLen = pwritev( ioFile, ptrIov, intBatch, offset + offTotal );
+            }
+
+            if( intLen == -1 ) { 
+                if( errno == EINTR ) continue;
+                return -1;
+            }
+            offTotal += intLen;
+
+            // Skip the buffers that were written completely
+            while( intBatch and (size_t)intLen >= ptrIov->iov_len ) {
+                intLen -= ptrIov->iov_len;
+                ++ptrIov;
+                --intBatch;
+                ++intDone;
+            }
+
+            // Continue where the partial write left off
+            if( intBatch ) {
+                ptrIov->iov_base = static_cast<char*>( ptrIov->iov_base ) + intLen;
+                ptrIov->iov_len -= intLen;
+            }
+        }
+    }
+
+    return offTotal;
+}
+
+/*!
+ * Writes the buffers IOV_MAX at a time with writev(), or pwritev() 
+ * if an offset is given, resuming after any partial writes.
+ * Returns the number of bytes written or -1 with errno set
+ */
+OffSet PosixIOHandle::mWriteAllV( int ioFile, const struct iovec* arrIov, int intCount, OffSet offset ) {
+    return writeAllV( ioFile, arrIov, intCount, offset, false );
+}
+
+/*!
+ * Maps the buffers into a pipe with vmsplice() so the data is never copied,
+ * the pipe holds references to the pages until the reader consumes them. 
+ * Anything other than a pipe is written with writev()
+ * Returns the number of bytes written or -1 with errno set
+ */
+OffSet PosixIOHandle::mSpliceAllV( int ioFile, const struct iovec* arrIov, int intCount ) {
+#ifdef __linux__
+    struct stat sb;
+
+    if( fstat( ioFile, &sb ) == 0 and S_ISFIFO( sb.st_mode ) ) {
+        return writeAllV( ioFile, arrIov, intCount, -1, true );
+    }
+#endif
+    return writeAllV( ioFile, arrIov, intCount, -1, false );
+}
+
 /**
  * Truncates a file to the specified offset
  */
 bool PosixIOHandle::mTruncate( OffSet offset ) {
+    IOStatsTimer timer( _stats, IOStats::Truncate );
     
     if( ftruncate( _ioFile, offset ) == -1 ) { 
         mSetError() << "IO Error: Unable to truncate '" << _strName << "' to offset '" << offset << "' - " <<  strerror( errno );
         return false;
     }
+
+    // The file is now exactly this size
+    _offFileSize = offset;
     
     return true;
 }
 
+/*!
+ * Ask the filesystem to share the source extents with our file ( btrfs, XFS )
+ * Returns the bytes cloned, or -1 if the range could not be cloned
+ */
+OffSet PosixIOHandle::mCloneRange( int ioSource, OffSet offSource, OffSet offSize ) {
+#ifdef FICLONERANGE
+    struct stat sb;
+    OffSet offDest = 0;
+
+    if( fstat( _ioFile, &sb ) == -1 or ( offDest = lseek( _ioFile, 0, SEEK_CUR ) ) == -1 ) return -1;
+
+    // Clones must start and end on filesystem block boundaries
+    OffSet offBlock = sb.st_blksize;
+    if( offBlock <= 0 or offSource % offBlock or offDest % offBlock or offSize % offBlock ) return -1;
+
+    struct file_clone_range range;
+    range.src_fd        = ioSource;
+    range.src_offset    = offSource;
+    range.src_length    = offSize;
+    range.dest_offset   = offDest;
+
+    if( ioctl( _ioFile, FICLONERANGE, &range ) == -1 ) return -1;
+
+    if( lseek( _ioFile, offDest + offSize, SEEK_SET ) == -1 ) return -1;
+
+    return offSize;
+#else
+    return -1;
+#endif
+}
+
+/*!
+ * Copy offSize bytes at offSource in the source handle to our current 
+ * position without passing the data through user space if we can.
+ * Tries a reflink clone, then copy_file_range(), then read()/write()
+ */
+OffSet PosixIOHandle::mCopyRange( IOHandle* ioSource, OffSet offSource, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    if( ioSource->_ioFile <= 0 or _boolStream ) {
+        return IOHandle::mCopyRange( ioSource, offSource, offSize );
+    }
+
+    if( mCloneRange( ioSource->_ioFile, offSource, offSize ) == offSize ) return offSize;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    while( offTotal < offSize ) {
+        loff_t offIn = offSource + offTotal;
+        ssize_t intLen = copy_file_range( ioSource->_ioFile, &offIn, _ioFile, 0, offSize - offTotal, 0 );
+
+        if( intLen == -1 ) {
+            if( errno == EINTR ) continue;
+            // Not supported between these files, copy the rest the slow way
+            if( errno == ENOSYS or errno == EXDEV or errno == EINVAL or errno == EOPNOTSUPP ) break;
+            mSetError() << "IO Error: Unable to copy " << offSize << " bytes to '" << _strName << "' - " <<  strerror( errno );
+            return -1;
+        }
+
+        // The source is shorter than we were told
+        if( intLen == 0 ) {
+            mSetError() << "IO Error: Unable to copy " << offSize << " bytes to '" << _strName 
+                        << "' - source ended at offset " << offSource + offTotal;
+            return -1;
+        }
+        offTotal += intLen;
+    }
+#endif
+
+    if( offTotal == offSize ) return offTotal;
+
+    OffSet offLen = IOHandle::mCopyRange( ioSource, offSource + offTotal, offSize - offTotal );
+    if( offLen < 0 ) return -1;
+
+    return offTotal + offLen;
+}
+
 // --- End posixfile.cpp ---
 
+// --- Begin mmapfile.cpp ---
+
+/*!
+ * MmapIOHandle Constructor
+ */
+MmapIOHandle::MmapIOHandle() : _ptrMap(0), _offPosition(0) { }
+
+/*!
+ * MmapIOHandle Destructor
+ */
+MmapIOHandle::~MmapIOHandle() { 
+
+    // Unmap and close the file
+    mClose(); 
+
+}
+
+/*!
+ * Unmap and close the file
+ */
+bool MmapIOHandle::mClose( void ) {
+
+    if( _ptrMap ) { 
+        munmap( _ptrMap, _offFileSize );
+        _ptrMap = 0;
+    }
+
+    if( _ioFile ) { 
+        close(_ioFile); 
+        _ioFile = 0;
+    }
+
+    _offPosition = 0;
+    return true;
+}
+
+/*!
+ * Open and map the file, only ReadOnly is supported
+ */
+bool MmapIOHandle::mOpen( const char* strFileName , OpenMode mode ) {
+    struct stat sb;
+
+    if( mode != ReadOnly ) {
+        mSetError() << "IO Error: Unable to open '" << strFileName << "' - MmapIOHandle only supports ReadOnly";
+        return false;
+    }
+
+    // if a file is already open, close it 
+    if( _ioFile ) { mClose(); }
+
+    if( ( _ioFile = open(strFileName, O_RDONLY, 0 ) ) == -1 ) {
+        _ioFile = 0;
+        mSetError() << "IO Error: Unable to open '" << strFileName << "' - " <<  strerror( errno );
+        return false;
+    }
+
+    // Record the total size of the file
+    if( fstat( _ioFile, &sb ) == -1 ) {
+        mSetError() << "IO Error: Unable to stat '" << strFileName << "' - " <<  strerror( errno );
+        mClose();
+        return false;
+    }
+    _offFileSize = sb.st_size;
+    _offDeviceBlock = sb.st_blksize;
+
+    // mmap() refuses to map zero bytes, an empty file is simply never mapped
+    if( _offFileSize ) {
+        void* ptrMap = mmap( 0, _offFileSize, PROT_READ, MAP_PRIVATE, _ioFile, 0 );
+        if( ptrMap == MAP_FAILED ) {
+            mSetError() << "IO Error: Unable to mmap '" << strFileName << "' - " <<  strerror( errno );
+            mClose();
+            return false;
+        }
+        _ptrMap = static_cast<char*>( ptrMap );
+
+        // Files are almost always loaded front to back
+        madvise( _ptrMap, _offFileSize, MADV_SEQUENTIAL );
+    }
+
+    _offPosition = 0;
+    _strName = strFileName;
+
+    return true;
+}
+
+/*! 
+ * The mapping is read only, writes will never be clear
+ */
+int MmapIOHandle::mWaitForClearToWrite( int ) {
+    mSetError() << "IO Error: '" << _strName << "' is mapped read only";
+    return -1;
+}
+
+/*!
+ * Seeks to a location in the mapping specified by offset
+ */
+OffSet MmapIOHandle::mSeek( OffSet offset ) {
+    IOStatsTimer timer( _stats, IOStats::Seek );
+
+    if( offset < 0 or offset > _offFileSize ) { 
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    _offPosition = offset;
+    return _offPosition;
+}
+
+/*!
+ * Points the caller at the next offSize bytes of the mapping and 
+ * advances the position, returns the number of bytes available
+ */
+OffSet MmapIOHandle::mMap( const char** ptrData, OffSet offSize ) {
+    OffSet offLen = _offFileSize - _offPosition;
+    IOStatsTimer timer( _stats, IOStats::Read );
+
+    if( offLen > offSize ) offLen = offSize;
+
+    *ptrData = _ptrMap + _offPosition;
+    _offPosition += offLen;
+
+    timer.mSetBytes( offLen );
+    return offLen;
+}
+
+/*!
+ * Copies data out of the mapping
+ */
+OffSet MmapIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offLen = _offFileSize - _offPosition;
+    IOStatsTimer timer( _stats, IOStats::Read );
+
+    if( offLen > offSize ) offLen = offSize;
+
+    memcpy( cstrBuffer, _ptrMap + _offPosition, offLen );
+    _offPosition += offLen;
+
+    timer.mSetBytes( offLen );
+    return offLen;
+}
+
+/*!
+ * The mapping is read only
+ */
+OffSet MmapIOHandle::mWrite( const char*, OffSet offSize ) {
+    mSetError() << "IO Error: Unable to write " << offSize << " bytes to '" << _strName << "' - mapped read only";
+    return -1;
+}
+
+/**
+ * The mapping is read only
+ */
+bool MmapIOHandle::mTruncate( OffSet offset ) {
+    mSetError() << "IO Error: Unable to truncate '" << _strName << "' to offset '" << offset << "' - mapped read only";
+    return false;
+}
+
+// --- End mmapfile.cpp ---
+
+// --- Begin memoryfile.cpp ---
+
+/*!
+ * MemoryIOHandle Constructor
+ */
+MemoryIOHandle::MemoryIOHandle() : _offPosition(0), _mode(ReadWrite) { }
+
+/*!
+ * MemoryIOHandle Destructor
+ */
+MemoryIOHandle::~MemoryIOHandle() { }
+
+/*!
+ * Open the file, the contents are kept from the last time it was open
+ */
+bool MemoryIOHandle::mOpen( const char* strFileName , OpenMode mode ) {
+    _strName = strFileName;
+    _mode = mode;
+    _offPosition = 0;
+    _offFileSize = _vecData.size();
+    return true;
+}
+
+/*!
+ * Close the file, the contents are not released
+ */
+bool MemoryIOHandle::mClose( void ) {
+    _offPosition = 0;
+    return true;
+}
+
+/*! 
+ * Writes are always clear unless the file was opened ReadOnly
+ */
+int MemoryIOHandle::mWaitForClearToWrite( int ) {
+    if( _mode == ReadOnly ) {
+        mSetError() << "IO Error: '" << _strName << "' was opened ReadOnly";
+        return -1;
+    }
+    return 0;
+}
+
+/*!
+ * Seeks to a location in the file specified by offset, seeking 
+ * past the end is allowed, the next write fills the gap with zeros
+ */
+OffSet MemoryIOHandle::mSeek( OffSet offset ) {
+    IOStatsTimer timer( _stats, IOStats::Seek );
+
+    if( offset < 0 ) { 
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    _offPosition = offset;
+    return _offPosition;
+}
+
+/*!
+ * Points the caller at the next offSize bytes of the file and 
+ * advances the position, returns the number of bytes available
+ */
+OffSet MemoryIOHandle::mMap( const char** ptrData, OffSet offSize ) {
+    OffSet offLen = _offFileSize - _offPosition;
+    IOStatsTimer timer( _stats, IOStats::Read );
+
+    if( offLen <= 0 ) return 0;
+    if( offLen > offSize ) offLen = offSize;
+
+    *ptrData = &_vecData[ _offPosition ];
+    _offPosition += offLen;
+
+    timer.mSetBytes( offLen );
+    return offLen;
+}
+
+/*!
+ * Copies data out of the file
+ */
+OffSet MemoryIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offLen = _offFileSize - _offPosition;
+    IOStatsTimer timer( _stats, IOStats::Read );
+
+    if( offLen <= 0 ) return 0;
+    if( offLen > offSize ) offLen = offSize;
+
+    memcpy( cstrBuffer, &_vecData[ _offPosition ], offLen );
+    _offPosition += offLen;
+
+    timer.mSetBytes( offLen );
+    return offLen;
+}
+
+/*!
+ * Copies data into the file, growing it if needed
+ */
+OffSet MemoryIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
+    IOStatsTimer timer( _stats, IOStats::Write );
+
+    if( _mode == ReadOnly ) {
+        mSetError() << "IO Error: Unable to write " << offSize << " bytes to '" << _strName << "' - opened ReadOnly";
+        return -1;
+    }
+
+    if( _offPosition + offSize > _offFileSize ) {
+        _vecData.resize( _offPosition + offSize );
+        _offFileSize = _vecData.size();
+    }
+
+    if( offSize ) memcpy( &_vecData[ _offPosition ], cstrBuffer, offSize );
+    _offPosition += offSize;
+
+    timer.mSetBytes( offSize );
+    return offSize;
+}
+
+/**
+ * Truncate or extend the file to offset bytes
+ */
+bool MemoryIOHandle::mTruncate( OffSet offset ) {
+    IOStatsTimer timer( _stats, IOStats::Truncate );
+
+    if( _mode == ReadOnly ) {
+        mSetError() << "IO Error: Unable to truncate '" << _strName << "' to offset '" << offset << "' - opened ReadOnly";
+        return false;
+    }
+
+    _vecData.resize( offset );
+    _offFileSize = offset;
+    return true;
+}
+
+// --- End memoryfile.cpp ---
+
 /*!
  * Return the default IOHandle handler for the current operating system
  */
@@ -230,6 +927,77 @@ bool IOHandle::mOpen( std::string &strFileName , OpenMode mode ) {
     return mOpen(strFileName.c_str(), mode );
 }
 
+/*!
+ * Hand out a pointer to the next offSize bytes of the IO, the 
+ * default IOHandle can not do this, check mOffersMap() first
+ */
+OffSet IOHandle::mMap( const char**, OffSet ) {
+    mSetError() << "IO Error: '" << _strName << "' does not offer mMap()";
+    return -1;
+}
+
+/*!
+ * Write a list of buffers, IOHandles that can write them all 
+ * in one call should override this
+ */
+OffSet IOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+    OffSet offTotal = 0;
+
+    for( int i = 0 ; i < intCount ; ++i ) {
+        OffSet offLen = mWrite( static_cast<const char*>( arrIov[i].iov_base ), arrIov[i].iov_len );
+        if( offLen < 0 ) return -1;
+        offTotal += offLen;
+    }
+    return offTotal;
+}
+
+/*!
+ * Copy offSize bytes at offSource in the source handle to our current position
+ * by reading and writing, IOHandles that can copy without the 
+ * data passing through user space should override this
+ */
+OffSet IOHandle::mCopyRange( IOHandle* ioSource, OffSet offSource, OffSet offSize ) {
+    const OffSet offChunk = 65536;
+    OffSet offTotal = 0;
+
+    if( ioSource->mSeek( offSource ) == -1 ) {
+        mSetError( ioSource->mGetError() );
+        return -1;
+    }
+
+    char* arrChunk = new char[ offChunk ];
+
+    while( offTotal < offSize ) {
+        OffSet offLen = offSize - offTotal;
+        if( offLen > offChunk ) offLen = offChunk;
+
+        if( ( offLen = ioSource->mRead( arrChunk, offLen ) ) <= 0 ) {
+            if( offLen == 0 ) {
+                mSetError() << "IO Error: Unable to copy " << offSize << " bytes to '" << _strName 
+                            << "' - source ended at offset " << offSource + offTotal;
+            } else {
+                mSetError( ioSource->mGetError() );
+            }
+            delete[] arrChunk;
+            return -1;
+        }
+
+        // mWrite() may write less than we asked
+        for( OffSet offDone = 0 ; offDone < offLen ; ) {
+            OffSet offVal = mWrite( arrChunk + offDone, offLen - offDone );
+            if( offVal < 0 ) {
+                delete[] arrChunk;
+                return -1;
+            }
+            offDone += offVal;
+        }
+        offTotal += offLen;
+    }
+
+    delete[] arrChunk;
+    return offTotal;
+}
+
 /*!
  * Convenience function 
  */
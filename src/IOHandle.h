@@ -22,6 +22,15 @@
 #define IOHANDLE_INCLUDE_H
 
 #include <Ollie.h>
+#include <IOStats.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <vector>
+
+// The most buffers a single writev() will accept
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 /*!
  *  An Abstract class used to 
@@ -31,7 +40,7 @@ class IOHandle : public OllieCommon {
 
     public:
         // Constructor / Destructor
-        IOHandle() : _ioFile(0), _offFileSize(0) { }
+        IOHandle() : _ioFile(0), _offFileSize(0), _offDeviceBlock(0) { }
         virtual ~IOHandle() { }
         static IOHandle* mGetDefaultIOHandler( void );
 
@@ -49,6 +58,12 @@ class IOHandle : public OllieCommon {
         //! Does the IO offer seek()?
         virtual bool mOffersSeek( void )  = 0;
 
+        //! Can the IO hand out pointers to it's data with mMap()?
+        virtual bool mOffersMap( void ) { return false; }
+
+        //! The alignment reads should use for offsets and sizes ( 1 = any )
+        virtual OffSet mGetAlignment( void ) { return 1; }
+
         // Read/Write Methods
         virtual int mWaitForClearToRead( int ) = 0;
         virtual int mWaitForClearToWrite( int )  = 0;
@@ -56,17 +71,38 @@ class IOHandle : public OllieCommon {
         virtual OffSet mRead( char*, OffSet ) = 0;
         virtual OffSet mWrite( const char*, OffSet  ) = 0;
         virtual bool mTruncate( OffSet offset ) = 0;
+        virtual OffSet mMap( const char**, OffSet );
+        virtual OffSet mWriteV( const struct iovec*, int );
+        virtual OffSet mCopyRange( IOHandle*, OffSet, OffSet );
         OffSet mRead( std::string&, OffSet );
         OffSet mWrite( std::string&, OffSet );
         
         //! Return the name of the iohandle ( IE: filename, network address )
         std::string& mGetName( void ) { return _strName; }
         OffSet mGetFileSize( void ) { return _offFileSize; }
+        //! The preferred IO size of the device the file is on ( st_blksize ), 0 if unknown
+        OffSet mGetDeviceBlockSize( void ) { return _offDeviceBlock; }
+
+        //! Return the counters for the calls that reached the OS
+        virtual IOStats& mGetStats( void ) { return _stats; }
 
         // Private IOHandleName
         std::string _strName;
         OffSet _offFileSize;
+        OffSet _offDeviceBlock;
         int _ioFile;
+        IOStats _stats;
+};
+
+/*!
+ *  A pool of buffers aligned for direct IO, so handles that 
+ *  are opened and closed often do not allocate each time.
+ *  All the buffers are DEFAULT_DIRECT_SIZE bytes
+ */
+class AlignedBufferPool {
+    public:
+        static char*    mAcquire( OffSet offAlignment );
+        static void     mRelease( char* );
 };
 
 /*!
@@ -74,20 +110,115 @@ class IOHandle : public OllieCommon {
  */
 class PosixIOHandle : public IOHandle {
     public:
-        PosixIOHandle();
+        PosixIOHandle( bool boolDirect = false );
         virtual ~PosixIOHandle( void );
 
         // Methods
         virtual bool    mOpen( const char*, OpenMode mode );
         virtual bool    mClose( void );
         virtual bool    mOffersLargeFileSupport( void ) { return true; }
-        virtual bool    mOffersSeek( void ) { return true; }
+        virtual bool    mOffersSeek( void ) { return ! _boolStream; }
+        virtual OffSet  mGetAlignment( void ) { return _arrDirect ? _offAlignment : 1; }
         virtual int     mWaitForClearToRead( int );
         virtual int     mWaitForClearToWrite( int );
         virtual bool    mTruncate( OffSet offset );
         virtual OffSet  mSeek( OffSet );
         virtual OffSet  mRead( char*, OffSet );
         virtual OffSet  mWrite( const char*, OffSet );
+        virtual OffSet  mWriteV( const struct iovec*, int );
+        virtual OffSet  mCopyRange( IOHandle*, OffSet, OffSet );
+
+        static OffSet   mWriteAllV( int, const struct iovec*, int, OffSet );
+        static OffSet   mSpliceAllV( int, const struct iovec*, int );
+        OffSet          mCloneRange( int, OffSet, OffSet );
+
+        //! Is this a pipe, FIFO or socket? ( not a regular file or block device )
+        bool            mIsStream( void ) { return _boolStream; }
+        int             mWaitFor( int, int );
+
+        //! Are reads bypassing the page cache?
+        bool            mIsDirect( void ) { return _arrDirect != 0; }
+        bool            mOpenDirect( void );
+        OffSet          mReadDirect( char*, OffSet );
+
+        bool            _boolStream;
+        // Direct IO was asked for, only ReadOnly regular files use it
+        bool            _boolDirect;
+        OffSet          _offAlignment;
+        // The aligned buffer direct reads go through
+        char*           _arrDirect;
+        OffSet          _offDirectStart;
+        OffSet          _offDirectLen;
+        OffSet          _offDirectPosition;
+        // Registered with the shared IOReadiness
+        bool            _boolRegistered;
+
+        // Managed by IOReadiness
+        int             _intWatchEvents;
+        int             _intReadyEvents;
+        long long       _intDeadline;
+        bool            _boolInEpoll;
+};
+
+/*!
+ *  A Class to read files through a read only memory mapping,
+ *  mMap() hands out pointers into the mapping so the caller
+ *  can avoid copying the data into a scratch buffer
+ */
+class MmapIOHandle : public IOHandle {
+    public:
+        MmapIOHandle();
+        virtual ~MmapIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return true; }
+        virtual bool    mOffersSeek( void ) { return true; }
+        virtual bool    mOffersMap( void ) { return true; }
+        virtual int     mWaitForClearToRead( int ) { return 0; }
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual OffSet  mMap( const char**, OffSet );
+
+        char*   _ptrMap;
+        OffSet  _offPosition;
+};
+
+/*!
+ *  A Class that keeps the file contents in memory, no syscalls
+ *  are made. The contents survive mClose() so a buffer can be
+ *  saved and loaded again, useful for tests and benchmarks that
+ *  should not measure the disk
+ */
+class MemoryIOHandle : public IOHandle {
+    public:
+        MemoryIOHandle();
+        virtual ~MemoryIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return true; }
+        virtual bool    mOffersSeek( void ) { return true; }
+        virtual bool    mOffersMap( void ) { return true; }
+        virtual int     mWaitForClearToRead( int ) { return 0; }
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual OffSet  mMap( const char**, OffSet );
+
+        //! The contents of the file
+        std::vector<char>& mGetData( void ) { return _vecData; }
+
+        std::vector<char>   _vecData;
+        OffSet              _offPosition;
+        OpenMode            _mode;
 };
 
 #endif // IOHANDLE_INCLUDE_H
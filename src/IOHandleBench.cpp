@@ -0,0 +1,288 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+// Measures how fast each IOHandle can load a file into a PageBuffer, and
+// how many syscalls a block by block copy makes with and without buffering
+//
+// Usage: IOHandleBench [file] [megabytes]
+//   If no file is given, a test file of 'megabytes' ( default 256 ) is created
+
+#include <File.h>
+#include <AsyncIOHandle.h>
+#include <ReadAheadIOHandle.h>
+#include <BufferedIOHandle.h>
+#include <LatencyIOHandle.h>
+#include <PageBuffer.h>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/time.h>
+
+using namespace std;
+using namespace Ollie::OllieBuffer;
+
+#define BENCH_FILE  "/tmp/OllieBenchFile.txt"
+#define BENCH_COPY  "/tmp/OllieBenchFile.copy"
+
+/*!
+ * A PosixIOHandle that counts the calls that turn into syscalls
+ */
+class CountingIOHandle : public PosixIOHandle {
+    public:
+        CountingIOHandle() : offReads(0), offWrites(0), offSeeks(0) { }
+
+        virtual OffSet mSeek( OffSet offset ) { ++offSeeks; return PosixIOHandle::mSeek( offset ); }
+        virtual OffSet mRead( char* cstrBuffer, OffSet offSize ) { 
+            ++offReads; 
+            return PosixIOHandle::mRead( cstrBuffer, offSize ); 
+        }
+        virtual OffSet mWrite( const char* cstrBuffer, OffSet offSize ) { 
+            ++offWrites; 
+            return PosixIOHandle::mWrite( cstrBuffer, offSize ); 
+        }
+        virtual OffSet mWriteV( const struct iovec* arrIov, int intCount ) { 
+            ++offWrites; 
+            return PosixIOHandle::mWriteV( arrIov, intCount ); 
+        }
+
+        OffSet offReads;
+        OffSet offWrites;
+        OffSet offSeeks;
+};
+
+/*!
+ * Return the current time in seconds
+ */
+double benchNow( void ) {
+    struct timeval tv;
+    gettimeofday( &tv, 0 );
+    return tv.tv_sec + ( tv.tv_usec / 1000000.0 );
+}
+
+/*!
+ * Create a file of lines of text offSize bytes long
+ */
+bool benchCreateFile( const char* strFileName, OffSet offSize ) {
+    const char* strLine = "AAAABBBBCCCCDDDDEEEE11223344 The quick brown fox jumps over the lazy dog\n";
+    int intLineLen = strlen( strLine );
+
+    fstream ioFile;
+    ioFile.open( strFileName, fstream::out );
+    if( ! ioFile.is_open() ) return false;
+
+    for( OffSet offLen = 0 ; offLen < offSize ; offLen += intLineLen ) {
+        ioFile << strLine;
+    }
+    ioFile.close();
+    return true;
+}
+
+/*!
+ * Copy the file into a MemoryIOHandle so the load can be 
+ * measured without touching the disk
+ */
+MemoryIOHandle* benchMemoryHandle( const char* strFileName ) {
+    MemoryIOHandle* ioHandle = new MemoryIOHandle();
+    PosixIOHandle ioFile;
+    char arrChunk[ 65536 ];
+    OffSet offLen = 0;
+
+    if( ! ioFile.mOpen( strFileName, IOHandle::ReadOnly ) ) return ioHandle;
+
+    ioHandle->mOpen( strFileName, IOHandle::ReadWrite );
+    while( ( offLen = ioFile.mRead( arrChunk, sizeof( arrChunk ) ) ) > 0 ) {
+        ioHandle->mWrite( arrChunk, offLen );
+    }
+    ioHandle->mClose();
+
+    return ioHandle;
+}
+
+/*!
+ * Return the resident set size of the process in MB
+ */
+double benchResident( void ) {
+    long lngSize = 0;
+    long lngResident = 0;
+
+    FILE* ioStatm = fopen( "/proc/self/statm", "r" );
+    if( ! ioStatm ) return 0;
+    if( fscanf( ioStatm, "%ld %ld", &lngSize, &lngResident ) != 2 ) lngResident = 0;
+    fclose( ioStatm );
+
+    return ( lngResident * sysconf( _SC_PAGESIZE ) ) / ( 1024.0 * 1024.0 );
+}
+
+/*!
+ * Load the entire file into a PageBuffer the same way a buffer would, 
+ * handles that offer maps load through File::mMapNextBlock()
+ * returns the MB/s or -1 on error
+ */
+double benchLoad( const char* strName, IOHandle* ioHandle, const char* strFileName ) {
+
+    if( ! ioHandle->mOpen( strFileName, IOHandle::ReadOnly ) ) {
+        cerr << strName << ": " << ioHandle->mGetError() << endl;
+        delete ioHandle;
+        return -1;
+    }
+
+    File* file = new Utf8File( ioHandle );
+    double dblResident = benchResident();
+    double dblStart = benchNow();
+
+    PageBuffer* pageBuffer = new PageBuffer();
+    file->mPrepareLoad();
+    OffSet offTotal = pageBuffer->mAppendFile( file );
+    file->mFinalizeLoad();
+
+    double dblSecs = benchNow() - dblStart;
+
+    // How much memory the loaded buffer holds on to
+    dblResident = benchResident() - dblResident;
+
+    if( offTotal < 0 ) {
+        cerr << strName << ": " << file->mGetError() << endl;
+        offTotal = 0;
+    }
+
+    delete pageBuffer;
+    delete file;
+
+    // Give the memory back so the next load starts from the same resident size
+    malloc_trim( 0 );
+
+    double dblRate = ( offTotal / ( 1024.0 * 1024.0 ) ) / dblSecs;
+    printf( "%-12s %12ld bytes %8.3f secs %10.2f MB/s %8.1f MB resident\n", strName, (long)offTotal, 
+            dblSecs, dblRate, dblResident );
+
+    return dblRate;
+}
+
+/*!
+ * Copy the file one block at a time through the File interface, 
+ * then report the syscalls made by the counting handles
+ */
+bool benchSyscalls( const char* strName, IOHandle* ioRead, CountingIOHandle* countRead,
+                    IOHandle* ioWrite, CountingIOHandle* countWrite, const char* strFileName ) {
+    Attributes attr;
+    OffSet offLen = 0;
+
+    if( ! ioRead->mOpen( strFileName, IOHandle::ReadOnly ) ) {
+        cerr << strName << ": " << ioRead->mGetError() << endl;
+        delete ioRead;
+        delete ioWrite;
+        return false;
+    }
+
+    // IOHandles do not create files
+    fstream ioCopy;
+    ioCopy.open( BENCH_COPY, fstream::out );
+    ioCopy.close();
+
+    if( ! ioWrite->mOpen( BENCH_COPY, IOHandle::ReadWrite ) ) {
+        cerr << strName << ": " << ioWrite->mGetError() << endl;
+        delete ioRead;
+        delete ioWrite;
+        return false;
+    }
+
+    File* fileRead = new Utf8File( ioRead );
+    File* fileWrite = new Utf8File( ioWrite );
+    char* arrBlockData = new char[ fileRead->mGetBlockSize() ];
+
+    double dblStart = benchNow();
+
+    fileRead->mPrepareLoad();
+    fileWrite->mPrepareSave();
+    while( ( offLen = fileRead->mReadNextBlock( arrBlockData, attr ) ) > 0 ) {
+        if( fileWrite->mWriteNextBlock( arrBlockData, offLen, attr ) != offLen ) {
+            cerr << strName << ": " << fileWrite->mGetError() << endl;
+            break;
+        }
+    }
+    fileRead->mFinalizeLoad();
+    fileWrite->mFinalizeSave();
+
+    // Closing flushes anything still buffered
+    ioWrite->mClose();
+
+    double dblSecs = benchNow() - dblStart;
+
+    printf( "%-12s %10ld reads %10ld writes %10ld seeks %8.3f secs\n", strName, (long)countRead->offReads,
+            (long)countWrite->offWrites, (long)( countRead->offSeeks + countWrite->offSeeks ), dblSecs );
+
+    delete[] arrBlockData;
+    delete fileRead;
+    delete fileWrite;
+    unlink( BENCH_COPY );
+
+    return true;
+}
+
+int main( int argc, char** argv ) {
+    const char* strFileName = BENCH_FILE;
+    OffSet offSize = 256;
+    bool boolCreated = false;
+
+    if( argc > 1 ) strFileName = argv[1];
+    if( argc > 2 ) offSize = atol( argv[2] );
+
+    if( argc < 2 ) {
+        if( ! benchCreateFile( strFileName, offSize * 1024 * 1024 ) ) {
+            cerr << "Unable to create '" << strFileName << "'" << endl;
+            return 1;
+        }
+        boolCreated = true;
+    }
+
+    benchLoad( "posix", new PosixIOHandle(), strFileName );
+    benchLoad( "direct", new PosixIOHandle( true ), strFileName );
+    benchLoad( "mmap", new MmapIOHandle(), strFileName );
+    benchLoad( "async", new AsyncIOHandle(), strFileName );
+    benchLoad( "async-pool", new AsyncIOHandle( DEFAULT_QUEUE_DEPTH, DEFAULT_BLOCK_SIZE, false ), strFileName );
+    benchLoad( "readahead", new ReadAheadIOHandle( new PosixIOHandle() ), strFileName );
+
+    // Simulate a remote mount, 200us +/- 100us per call
+    LatencyIOHandle* ioSlow = new LatencyIOHandle( new PosixIOHandle() );
+    ioSlow->mSetLatency( 200, 100 );
+    benchLoad( "posix-slow", ioSlow, strFileName );
+
+    ioSlow = new LatencyIOHandle( new PosixIOHandle() );
+    ioSlow->mSetLatency( 200, 100 );
+    benchLoad( "ahead-slow", new ReadAheadIOHandle( ioSlow ), strFileName );
+
+    benchLoad( "memory", benchMemoryHandle( strFileName ), strFileName );
+
+    CountingIOHandle* countRead = new CountingIOHandle();
+    CountingIOHandle* countWrite = new CountingIOHandle();
+    benchSyscalls( "raw", countRead, countRead, countWrite, countWrite, strFileName );
+
+    countRead = new CountingIOHandle();
+    countWrite = new CountingIOHandle();
+    benchSyscalls( "buffered", new BufferedIOHandle( countRead ), countRead, 
+                   new BufferedIOHandle( countWrite ), countWrite, strFileName );
+
+    if( boolCreated ) unlink( strFileName );
+
+    return 0;
+}
@@ -20,12 +20,22 @@
 
 #include "cxxtest/TestSuite.h"
 #include <IOHandle.h>
+#include <AsyncIOHandle.h>
+#include <IOReadiness.h>
+#include <ReadAheadIOHandle.h>
+#include <BufferedIOHandle.h>
+#include <StreamIOHandle.h>
+#include <LatencyIOHandle.h>
+#include <File.h>
 #include <iostream>
 #include <fstream>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
 
 using namespace std;
 
@@ -54,6 +64,20 @@ class IOTests : public CxxTest::TestSuite
 
         }
 
+        // --------------------------------
+        // The number of threads in this process
+        // --------------------------------
+        int countThreads( void ) {
+            int intCount = 0;
+            DIR* dir = opendir( "/proc/self/task" );
+            if( ! dir ) return 0;
+            while( struct dirent* entry = readdir( dir ) ) {
+                if( entry->d_name[0] != '.' ) ++intCount;
+            }
+            closedir( dir );
+            return intCount;
+        }
+
         // --------------------------------
         // Create a some test files
         // --------------------------------
@@ -88,6 +112,9 @@ class IOTests : public CxxTest::TestSuite
         // --------------------------------
         void testPosixIOHandleReadOnlyFileAsReadWrite( void ) {
 
+            // root ignores the file permissions, nothing to test
+            if( geteuid() == 0 ) return;
+
             IOHandle* ioHandle = new PosixIOHandle();
             TS_ASSERT( ioHandle ); 
 
@@ -216,6 +243,727 @@ class IOTests : public CxxTest::TestSuite
             delete ioHandle;
         }
 
+        // --------------------------------
+        // --------------------------------
+        void testMmapIOHandleReadOnly( void ) {
+            string strBuffer;
+            const char* ptrData = 0;
+
+            IOHandle* ioHandle = new MmapIOHandle();
+            TS_ASSERT( ioHandle ); 
+
+            // Mapped files can only be opened ReadOnly
+            TS_ASSERT_EQUALS( ioHandle->mOpen(READ_ONLY_TEST_FILE, IOHandle::ReadWrite ), false );
+            TS_ASSERT_EQUALS( ioHandle->mGetError().substr(0,58), "IO Error: Unable to open '" READ_ONLY_TEST_FILE "'" );
+
+            // Open should return true, if not report the error
+            if( ! ioHandle->mOpen(READ_ONLY_TEST_FILE, IOHandle::ReadOnly ) ) {
+                TS_FAIL("Unable to map readonly file '" READ_ONLY_TEST_FILE "' - " + ioHandle->mGetError() );
+            }
+
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 29 );
+
+            // Reading from memory never blocks
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 2 ), 0 );
+
+            // Read the first 4 bytes from the file
+            TS_ASSERT_EQUALS( ioHandle->mRead(strBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( strBuffer, "AAAA" );
+
+            // Seek to the 8th position in the file
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 8 ), 8 );
+
+            // Map 4 bytes from that location
+            TS_ASSERT_EQUALS( ioHandle->mOffersMap(), true );
+            TS_ASSERT_EQUALS( ioHandle->mMap( &ptrData, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( ptrData, 4 ), "CCCC" );
+
+            // Mapping past the end of the file only returns what is left
+            TS_ASSERT_EQUALS( ioHandle->mMap( &ptrData, 100 ), 17 );
+            TS_ASSERT_EQUALS( ioHandle->mMap( &ptrData, 100 ), 0 );
+
+            // Can not seek past the end of the mapping
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 30 ), -1 );
+
+            // No Errors should have occured
+            ioHandle->mGetError();
+
+            // Attempt to write to the mapping ( should return -1 ) 
+            TS_ASSERT_EQUALS( ioHandle->mWrite("WRITEABLE", 9 ), -1 ); 
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 10 ), false ); 
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testMemoryIOHandle( void ) {
+            char arrBuffer[20];
+            const char* ptrData = 0;
+
+            MemoryIOHandle* ioHandle = new MemoryIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioHandle->mOffersSeek(), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 0 );
+
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToWrite( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "AAAABBBBCCCC", 12 ), 12 );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 12 );
+
+            // Overwrite the middle
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "XX", 2 ), 2 );
+
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 20 ), 12 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 12 ), "AAAAXXBBCCCC" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 20 ), 0 );
+
+            // Writing past the end fills the gap with zeros
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 14 ), 14 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "E", 1 ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 15 );
+            TS_ASSERT_EQUALS( ioHandle->mGetData()[12], 0 );
+
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 8 ), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 8 );
+
+            // The contents survive a close
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadOnly ), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 8 );
+            TS_ASSERT_EQUALS( ioHandle->mMap( &ptrData, 20 ), 8 );
+            TS_ASSERT_EQUALS( string( ptrData, 8 ), "AAAAXXBB" );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "abc", 3 ), -1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "IO Error: Unable to write 3 bytes to 'memory' - opened ReadOnly" );
+
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPosixIOHandleWriteV( void ) {
+            string strBuffer;
+            struct iovec arrIov[3];
+
+            createTestFile(TEST_FILE);
+
+            IOHandle* ioHandle = new PosixIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ), true );
+
+            arrIov[0].iov_base = (void*)"1111";
+            arrIov[0].iov_len = 4;
+            arrIov[1].iov_base = (void*)"22";
+            arrIov[1].iov_len = 2;
+            arrIov[2].iov_base = (void*)"333";
+            arrIov[2].iov_len = 3;
+
+            // Write all the buffers at offset 4
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mWriteV( arrIov, 3 ), 9 );
+
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead(strBuffer, 16 ), 16 );
+            TS_ASSERT_EQUALS( strBuffer, "AAAA111122333DDD" );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPosixIOHandleCopyRange( void ) {
+            string strBuffer;
+
+            createTestFile(TEST_FILE);
+            close( open( TEST_FILE ".copy", O_CREAT | O_TRUNC | O_WRONLY, 0644 ) );
+
+            IOHandle* ioSource = new PosixIOHandle();
+            TS_ASSERT_EQUALS( ioSource->mOpen(TEST_FILE, IOHandle::ReadOnly ), true );
+
+            IOHandle* ioHandle = new PosixIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen(TEST_FILE ".copy", IOHandle::ReadWrite ), true );
+
+            // Copy 2 ranges one after the other
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "--", 2 ), 2 );
+            TS_ASSERT_EQUALS( ioHandle->mCopyRange( ioSource, 8, 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mCopyRange( ioSource, 0, 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "--", 2 ), 2 );
+
+            // Copying past the end of the source is an error
+            TS_ASSERT_EQUALS( ioHandle->mCopyRange( ioSource, 28, 4 ), -1 );
+            TS_ASSERT_DIFFERS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead(strBuffer, 12 ), 12 );
+            TS_ASSERT_EQUALS( strBuffer, "--CCCCAAAA--" );
+
+            delete ioSource;
+            delete ioHandle;
+            unlink( TEST_FILE ".copy" );
+        }
+
+        // --------------------------------
+        // Helper to exercise an AsyncIOHandle with tiny blocks,
+        // so the 29 byte test file needs many requests
+        // --------------------------------
+        void checkAsyncIOHandle( bool boolAllowIOUring ) {
+            char arrBuffer[30];
+
+            createTestFile(TEST_FILE);
+
+            AsyncIOHandle* ioHandle = new AsyncIOHandle( 3, 4, boolAllowIOUring );
+
+            if( ! ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ) ) {
+                TS_FAIL("Unable to open file '" TEST_FILE "' - " + ioHandle->mGetError() );
+            }
+
+            if( ! boolAllowIOUring ) {
+                TS_ASSERT_EQUALS( ioHandle->mUsingIOUring(), false );
+            }
+
+            // Reads never wait on select()
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 0 ), 0 );
+
+            // Read across several queued requests
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 10 ), 10 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "AAAABBBBCC" );
+
+            // Continue reading past the queue depth
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 14 ), 14 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 14 ), "CCDDDDEEEE1122" );
+
+            // Seek backward out of the queued window
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 5 ), 5 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 6 ), 6 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 6 ), "BBBCCC" );
+
+            // Reading past the end of the file returns what is left
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 24 ), 24 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 5 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 5 ), "3344\n" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 0 );
+
+            // Writes must not be hidden by reads already queued
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 2 ), 2 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "XXXX", 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 12 ), 12 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 12 ), "AAAAXXXXCCCC" );
+
+            // Truncate shrinks what we can read
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 6 ), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 6 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 6 );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testAsyncIOHandle( void ) {
+            checkAsyncIOHandle( true );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testAsyncIOHandleThreadPool( void ) {
+            checkAsyncIOHandle( false );
+
+            // The pool is sized by DEFAULT_ASYNC_THREADS, not the queue depth
+            int intThreads = countThreads();
+            AsyncIOHandle* ioHandle = new AsyncIOHandle( 64, 4, false );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( READ_ONLY_TEST_FILE, IOHandle::ReadOnly ), true );
+            TS_ASSERT( countThreads() <= intThreads + WorkerPool::mThreadsFor( DEFAULT_ASYNC_THREADS ) );
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            TS_ASSERT_EQUALS( countThreads(), intThreads );
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // Tiny blocks so the 29 byte test file needs several prefetches
+        // --------------------------------
+        void testReadAheadIOHandle( void ) {
+            char arrBuffer[30];
+
+            createTestFile(TEST_FILE);
+
+            ReadAheadIOHandle* ioHandle = new ReadAheadIOHandle( new PosixIOHandle(), 3, 4 );
+
+            if( ! ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ) ) {
+                TS_FAIL("Unable to open file '" TEST_FILE "' - " + ioHandle->mGetError() );
+            }
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 29 );
+
+            // The first read is not enough to start prefetching
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "AAAA" );
+            TS_ASSERT_EQUALS( ioHandle->mIsPrefetching(), false );
+
+            // Sequential reads are served from the ring
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "BBBB" );
+            TS_ASSERT_EQUALS( ioHandle->mIsPrefetching(), true );
+
+            // Give the thread time to fill the ring
+            usleep( 100000 );
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 14 ), 14 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 14 ), "CCCCDDDDEEEE11" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 7 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 7 ), "223344\n" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 0 );
+            TS_ASSERT( ioHandle->mGetHits() > 0 );
+
+            // Seeking away stops the prefetch
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 6 ), 6 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "BBCC" );
+            TS_ASSERT_EQUALS( ioHandle->mIsPrefetching(), false );
+
+            // Writes must not be hidden by prefetched blocks
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 16 ), 16 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "XXXX", 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 10 ), 10 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 10 ), 10 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "CCDDDDXXXX" );
+
+            // Truncate shrinks what we can read
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 6 ), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 6 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 6 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 0 );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+
+            // Opening again stops the thread, even when the handle has no descriptor
+            int intThreads = countThreads();
+            ioHandle = new ReadAheadIOHandle( new MemoryIOHandle(), 3, 4 );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "AAAABBBB", 8 ), 8 );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadOnly ), true );
+            TS_ASSERT_EQUALS( countThreads(), intThreads + 1 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 8 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 8 ), "AAAABBBB" );
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            TS_ASSERT_EQUALS( countThreads(), intThreads );
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testBufferedIOHandle( void ) {
+            char arrBuffer[30];
+
+            createTestFile(TEST_FILE);
+
+            // A staging buffer smaller than the file
+            BufferedIOHandle* ioHandle = new BufferedIOHandle( new PosixIOHandle(), 8 );
+
+            if( ! ioHandle->mOpen(TEST_FILE, IOHandle::ReadWrite ) ) {
+                TS_FAIL("Unable to open file '" TEST_FILE "' - " + ioHandle->mGetError() );
+            }
+
+            // Small reads across several refills
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 3 ), 3 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer + 3, 7 ), 7 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "AAAABBBBCC" );
+
+            // A read larger than the buffer
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 19 ), 19 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 19 ), "CCDDDDEEEE11223344\n" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 0 );
+
+            // Small writes are held until the buffer is flushed
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "XX", 2 ), 2 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "YY", 2 ), 2 );
+            TS_ASSERT_EQUALS( ioHandle->_boolDirty, true );
+
+            // Reading flushes the writes first
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 12 ), 12 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 12 ), "AAAAXXYYCCCC" );
+
+            // Writes that are not contiguous
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "1", 1 ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 8 ), 8 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "2", 1 ), 1 );
+
+            // Extending the file updates the size before the flush
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 29 ), 29 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "Z", 1 ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 30 );
+
+            // Truncate flushes first
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 10 ), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 10 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 10 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "1AAAXXYY2C" );
+
+            // Close flushes what is left
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 10 ), 10 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "END", 3 ), 3 );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+
+            ifstream ioFile( TEST_FILE );
+            string strLine;
+            getline( ioFile, strLine );
+            TS_ASSERT_EQUALS( strLine, "1AAAXXYY2CEND" );
+
+            // Opening again flushes, even when the handle has no descriptor
+            MemoryIOHandle* ioMemory = new MemoryIOHandle();
+            ioHandle = new BufferedIOHandle( ioMemory, 8 );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "AAAA", 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "memory", IOHandle::ReadOnly ), true );
+            TS_ASSERT_EQUALS( ioMemory->mGetFileSize(), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 30 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "AAAA" );
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testLatencyIOHandle( void ) {
+            char arrBuffer[100];
+
+            LatencyIOHandle* ioHandle = new LatencyIOHandle( new PosixIOHandle() );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( READ_ONLY_TEST_FILE, IOHandle::ReadOnly ), true );
+
+            // Reads are cut short and delayed
+            ioHandle->mSetLatency( 20000, 1000 );
+            ioHandle->mSetShortReads( 10 );
+
+            long long intStart = LatencyIOHandle::mNow();
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 10 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "AAAABBBBCC" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 10 );
+            TS_ASSERT( LatencyIOHandle::mNow() - intStart >= 40 );
+            TS_ASSERT_EQUALS( ioHandle->mGetCalls(), 2 );
+
+            // The next read starts a stall longer than the timeout
+            ioHandle->mSetLatency( 0 );
+            ioHandle->mSetStall( 1, 1500 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 9 );
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 1 ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "IO Error: Timeout waiting to read '" READ_ONLY_TEST_FILE "'" );
+
+            // The stall ends before the next timeout
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 1 ), 0 );
+
+            // Seeks are passed through
+            ioHandle->mSetStall( 0, 0 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "BBBB" );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testIOStats( void ) {
+            char arrBuffer[100];
+
+            TS_ASSERT_EQUALS( IOStats::mBucketFor( 0 ), 0 );
+            TS_ASSERT_EQUALS( IOStats::mBucketFor( 1 ), 1 );
+            TS_ASSERT_EQUALS( IOStats::mBucketFor( 3 ), 2 );
+            TS_ASSERT_EQUALS( IOStats::mBucketFor( 1024 ), 11 );
+            TS_ASSERT_EQUALS( IOStats::mBucketFor( 1LL << 50 ), IOSTATS_BUCKETS - 1 );
+
+            // Decorators report the stats of the handle that makes the syscalls
+            ReadAheadIOHandle* ioHandle = new ReadAheadIOHandle( new PosixIOHandle() );
+            TS_ASSERT_EQUALS( &ioHandle->mGetStats(), &ioHandle->_ioHandle->mGetStats() );
+
+            TS_ASSERT_EQUALS( ioHandle->mOpen( READ_ONLY_TEST_FILE, IOHandle::ReadOnly ), true );
+            File* file = new Utf8File( ioHandle );
+
+            TS_ASSERT_EQUALS( ioHandle->_ioHandle->mRead( arrBuffer, 10 ), 10 );
+            TS_ASSERT_EQUALS( ioHandle->_ioHandle->mRead( arrBuffer, 100 ), 19 );
+            TS_ASSERT_EQUALS( ioHandle->_ioHandle->mSeek( 0 ), 0 );
+
+            IOStats& stats = file->mGetStats();
+            TS_ASSERT_EQUALS( stats.mGetCalls( IOStats::Read ), 2 );
+            TS_ASSERT_EQUALS( stats.mGetBytes( IOStats::Read ), 29 );
+            TS_ASSERT_EQUALS( stats.mGetCalls( IOStats::Seek ), 1 );
+            TS_ASSERT_EQUALS( stats.mGetCalls( IOStats::Write ), 0 );
+
+            long long intBuckets = 0;
+            for( int i = 0 ; i < IOSTATS_BUCKETS ; ++i ) intBuckets += stats.mGetBucket( IOStats::Read, i );
+            TS_ASSERT_EQUALS( intBuckets, 2 );
+            TS_ASSERT( stats.mGetPercentile( IOStats::Read, 0.5 ) > 0 );
+
+            // Aggregate into another set of stats
+            IOStats total;
+            total.mAdd( stats );
+            total.mAdd( stats );
+            TS_ASSERT_EQUALS( total.mGetCalls( IOStats::Read ), 4 );
+            TS_ASSERT_EQUALS( total.mGetBytes( IOStats::Read ), 58 );
+            TS_ASSERT_DIFFERS( total.mReport().find( "read" ), string::npos );
+
+            stats.mReset();
+            TS_ASSERT_EQUALS( stats.mGetCalls( IOStats::Read ), 0 );
+
+            delete file;
+
+            // Mapped reads count as reads
+            const char* ptrData = 0;
+            MmapIOHandle* ioMmap = new MmapIOHandle();
+            TS_ASSERT_EQUALS( ioMmap->mOpen( READ_ONLY_TEST_FILE, IOHandle::ReadOnly ), true );
+            TS_ASSERT_EQUALS( ioMmap->mMap( &ptrData, 10 ), 10 );
+            TS_ASSERT_EQUALS( ioMmap->mRead( arrBuffer, 100 ), 19 );
+            TS_ASSERT_EQUALS( ioMmap->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioMmap->mGetStats().mGetCalls( IOStats::Read ), 2 );
+            TS_ASSERT_EQUALS( ioMmap->mGetStats().mGetBytes( IOStats::Read ), 29 );
+            TS_ASSERT_EQUALS( ioMmap->mGetStats().mGetCalls( IOStats::Seek ), 1 );
+            delete ioMmap;
+
+            MemoryIOHandle* ioMemory = new MemoryIOHandle();
+            TS_ASSERT_EQUALS( ioMemory->mOpen( "memory", IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioMemory->mWrite( "AAAABBBB", 8 ), 8 );
+            TS_ASSERT_EQUALS( ioMemory->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioMemory->mRead( arrBuffer, 100 ), 8 );
+            TS_ASSERT_EQUALS( ioMemory->mTruncate( 4 ), true );
+            TS_ASSERT_EQUALS( ioMemory->mGetStats().mGetCalls( IOStats::Write ), 1 );
+            TS_ASSERT_EQUALS( ioMemory->mGetStats().mGetBytes( IOStats::Write ), 8 );
+            TS_ASSERT_EQUALS( ioMemory->mGetStats().mGetBytes( IOStats::Read ), 8 );
+            TS_ASSERT_EQUALS( ioMemory->mGetStats().mGetCalls( IOStats::Seek ), 1 );
+            TS_ASSERT_EQUALS( ioMemory->mGetStats().mGetCalls( IOStats::Truncate ), 1 );
+            delete ioMemory;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPosixIOHandleDirect( void ) {
+            Attributes attr;
+            char arrBuffer[100];
+            void* ptrAligned = 0;
+
+            // Direct IO is only used for ReadOnly
+            PosixIOHandle* ioHandle = new PosixIOHandle( true );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioHandle->mIsDirect(), false );
+            TS_ASSERT_EQUALS( ioHandle->mGetAlignment(), 1 );
+
+            TS_ASSERT_EQUALS( ioHandle->mOpen( READ_ONLY_TEST_FILE, IOHandle::ReadOnly ), true );
+
+            // Not every file system supports direct IO ( IE: tmpfs )
+            if( ! ioHandle->mIsDirect() ) {
+                TS_ASSERT_EQUALS( ioHandle->_offAlignment, 1 );
+                delete ioHandle;
+                return;
+            }
+            TS_ASSERT( ioHandle->mGetAlignment() >= 512 );
+
+            // Unaligned reads are served from the aligned buffer
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 10 ), 10 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 10 ), "AAAABBBBCC" );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 19 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 19 ), "CCDDDDEEEE11223344\n" );
+            TS_ASSERT_EQUALS( ioHandle->mGetStats().mGetCalls( IOStats::Read ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 0 );
+
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 4 ), 4 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 4 ), 4 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 4 ), "BBBB" );
+
+            // Aligned reads go straight into the callers buffer
+            TS_ASSERT_EQUALS( posix_memalign( &ptrAligned, ioHandle->mGetAlignment(), ioHandle->mGetAlignment() ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( static_cast<char*>( ptrAligned ), ioHandle->mGetAlignment() ), 29 );
+            TS_ASSERT_EQUALS( string( static_cast<char*>( ptrAligned ), 4 ), "AAAA" );
+            free( ptrAligned );
+
+            // Files size their blocks to the alignment
+            File* file = new Utf8File( ioHandle );
+            TS_ASSERT_EQUALS( file->mGetBlockSize() % ioHandle->mGetAlignment(), 0 );
+            TS_ASSERT( file->mGetBlockSize() >= DEFAULT_BLOCK_SIZE );
+            file->mSetBlockSize( 100 );
+            TS_ASSERT_EQUALS( file->mGetBlockSize(), ioHandle->mGetAlignment() );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            delete file;
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPosixIOHandleFIFO( void ) {
+            char arrBuffer[10];
+
+            unlink( "/tmp/OllieTestFIFO" );
+            TS_ASSERT_EQUALS( mkfifo( "/tmp/OllieTestFIFO", 0600 ), 0 );
+
+            // Opening ReadWrite keeps the FIFO from blocking on open
+            PosixIOHandle* ioHandle = new PosixIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "/tmp/OllieTestFIFO", IOHandle::ReadWrite ), true );
+
+            TS_ASSERT_EQUALS( ioHandle->mIsStream(), true );
+            TS_ASSERT_EQUALS( ioHandle->mOffersSeek(), false );
+
+            // Nothing to read yet
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 0 ), 1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "IO Error: Timeout waiting to read '/tmp/OllieTestFIFO'" );
+
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToWrite( 1 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "abc", 3 ), 3 );
+
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 1 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 10 ), 3 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 3 ), "abc" );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+            unlink( "/tmp/OllieTestFIFO" );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testIOReadinessWatch( void ) {
+            std::vector<PosixIOHandle*> vecReady;
+            std::vector<PosixIOHandle*> vecExpired;
+
+            unlink( "/tmp/OllieTestFIFO1" );
+            unlink( "/tmp/OllieTestFIFO2" );
+            TS_ASSERT_EQUALS( mkfifo( "/tmp/OllieTestFIFO1", 0600 ), 0 );
+            TS_ASSERT_EQUALS( mkfifo( "/tmp/OllieTestFIFO2", 0600 ), 0 );
+
+            PosixIOHandle* ioHandle1 = new PosixIOHandle();
+            PosixIOHandle* ioHandle2 = new PosixIOHandle();
+            TS_ASSERT_EQUALS( ioHandle1->mOpen( "/tmp/OllieTestFIFO1", IOHandle::ReadWrite ), true );
+            TS_ASSERT_EQUALS( ioHandle2->mOpen( "/tmp/OllieTestFIFO2", IOHandle::ReadWrite ), true );
+
+            IOReadiness* readiness = IOReadiness::mShared();
+
+            // Watch both, only the first has data
+            TS_ASSERT_EQUALS( ioHandle1->mWrite( "x", 1 ), 1 );
+            TS_ASSERT_EQUALS( readiness->mWatch( ioHandle1, IOReadiness::Read, 5 ), true );
+            TS_ASSERT_EQUALS( readiness->mWatch( ioHandle2, IOReadiness::Read, 1 ), true );
+
+            TS_ASSERT_EQUALS( readiness->mPoll( vecReady, vecExpired, 5000 ), 1 );
+            TS_ASSERT_EQUALS( vecReady.size(), 1 );
+            TS_ASSERT_EQUALS( vecExpired.size(), 0 );
+            if( vecReady.size() ) TS_ASSERT_EQUALS( vecReady[0], ioHandle1 );
+
+            // The second handle passes its deadline
+            vecReady.clear();
+            TS_ASSERT_EQUALS( readiness->mPoll( vecReady, vecExpired, 5000 ), 1 );
+            TS_ASSERT_EQUALS( vecReady.size(), 0 );
+            TS_ASSERT_EQUALS( vecExpired.size(), 1 );
+            if( vecExpired.size() ) TS_ASSERT_EQUALS( vecExpired[0], ioHandle2 );
+
+            TS_ASSERT_EQUALS( readiness->mGetError(), "" );
+
+            delete ioHandle1;
+            delete ioHandle2;
+            unlink( "/tmp/OllieTestFIFO1" );
+            unlink( "/tmp/OllieTestFIFO2" );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testStreamIOHandle( void ) {
+            char arrBuffer[100];
+            std::string strData;
+
+            for( int i = 0 ; i < 100 ; ++i ) strData += char( 'A' + ( i % 26 ) );
+
+            unlink( "/tmp/OllieTestFIFO" );
+            TS_ASSERT_EQUALS( mkfifo( "/tmp/OllieTestFIFO", 0600 ), 0 );
+
+            // Open the writer first so the reader does not block on open
+            int ioWriter = open( "/tmp/OllieTestFIFO", O_RDWR );
+            TS_ASSERT_DIFFERS( ioWriter, -1 );
+
+            // A small spill size so the data ends up in the temp file
+            StreamIOHandle* ioHandle = new StreamIOHandle( 32 );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "/tmp/OllieTestFIFO", IOHandle::ReadWrite ), false );
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "IO Error: Unable to open '/tmp/OllieTestFIFO' - streams can only be opened ReadOnly" );
+            TS_ASSERT_EQUALS( ioHandle->mOpen( "/tmp/OllieTestFIFO", IOHandle::ReadOnly ), true );
+            TS_ASSERT_EQUALS( ioHandle->mOffersSeek(), true );
+
+            TS_ASSERT_EQUALS( write( ioWriter, strData.c_str(), 20 ), 20 );
+
+            // Only the first 20 bytes are in memory
+            TS_ASSERT_EQUALS( ioHandle->mWaitForClearToRead( 1 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 20 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 20 ), strData.substr( 0, 20 ) );
+            TS_ASSERT_EQUALS( ioHandle->mIsSpilled(), false );
+
+            // Reading the data already received does not pull in more of the stream
+            TS_ASSERT_EQUALS( write( ioWriter, strData.c_str() + 20, 10 ), 10 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 0 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 5 ), 5 );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 20 );
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 20 ), 20 );
+
+            // The rest spills to disk
+            TS_ASSERT_EQUALS( write( ioWriter, strData.c_str() + 30, 70 ), 70 );
+            close( ioWriter );
+
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 80 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 80 ), strData.substr( 20 ) );
+            TS_ASSERT_EQUALS( ioHandle->mIsSpilled(), true );
+            TS_ASSERT_EQUALS( ioHandle->mGetFileSize(), 100 );
+
+            // End of the stream
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 100 ), 0 );
+            TS_ASSERT_EQUALS( ioHandle->mIsComplete(), true );
+
+            // Seek back and read again
+            TS_ASSERT_EQUALS( ioHandle->mSeek( 10 ), 10 );
+            TS_ASSERT_EQUALS( ioHandle->mRead( arrBuffer, 15 ), 15 );
+            TS_ASSERT_EQUALS( string( arrBuffer, 15 ), strData.substr( 10, 15 ) );
+
+            // No Errors should have occured
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "" );
+
+            // Streams are read only
+            TS_ASSERT_EQUALS( ioHandle->mWrite( "abc", 3 ), -1 );
+            TS_ASSERT_EQUALS( ioHandle->mGetError(), "IO Error: '/tmp/OllieTestFIFO' is a stream opened ReadOnly" );
+
+            TS_ASSERT_EQUALS( ioHandle->mClose(), true );
+            delete ioHandle;
+            unlink( "/tmp/OllieTestFIFO" );
+        }
+
         // --------------------------------
         // --------------------------------
         void testPosixIOHandleCleanUpRDONLYFile( void ) {
@@ -0,0 +1,336 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <IOReadiness.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+// The most events we collect from a single epoll_wait()
+#define READINESS_MAX_EVENTS    64
+
+static IOReadiness* ptrSharedReadiness = 0;
+static pthread_once_t onceReadiness = PTHREAD_ONCE_INIT;
+
+static void createSharedReadiness( void ) {
+    ptrSharedReadiness = new IOReadiness();
+}
+
+/*!
+ * Return the readiness engine shared by all the PosixIOHandles
+ */
+IOReadiness* IOReadiness::mShared( void ) {
+    pthread_once( &onceReadiness, createSharedReadiness );
+    return ptrSharedReadiness;
+}
+
+/*!
+ * Return a monotonic time in milliseconds
+ */
+long long IOReadiness::mNow( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( ts.tv_sec * 1000LL ) + ( ts.tv_nsec / 1000000 );
+}
+
+/*!
+ * IOReadiness Constructor
+ */
+IOReadiness::IOReadiness( void ) : _boolPolling(false) {
+    pthread_condattr_t attr;
+
+    pthread_mutex_init( &_mutex, 0 );
+    pthread_condattr_init( &attr );
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+    pthread_cond_init( &_condEvents, &attr );
+    pthread_condattr_destroy( &attr );
+
+    if( ( _ioEpoll = epoll_create1( EPOLL_CLOEXEC ) ) == -1 ) {
+        mSetError() << "IO Error: Unable to create epoll instance - " << strerror( errno );
+    }
+}
+
+/*!
+ * IOReadiness Destructor
+ */
+IOReadiness::~IOReadiness( void ) {
+    if( _ioEpoll != -1 ) close( _ioEpoll );
+    pthread_cond_destroy( &_condEvents );
+    pthread_mutex_destroy( &_mutex );
+}
+
+/*!
+ * Add the handle to the set we can wait on, returns false if
+ * the handle does not support waiting ( IE: /dev/null )
+ */
+bool IOReadiness::mAdd( PosixIOHandle* ioHandle ) {
+    struct epoll_event ev;
+
+    if( _ioEpoll == -1 ) return false;
+
+    // Make sure epoll can wait on this file descriptor, the handle is only
+    // kept in the epoll set while it is waiting so idle pipes that hang up
+    // do not keep waking up epoll_wait()
+    memset( &ev, 0, sizeof(ev) );
+    if( epoll_ctl( _ioEpoll, EPOLL_CTL_ADD, ioHandle->_ioFile, &ev ) == -1 ) return false;
+    epoll_ctl( _ioEpoll, EPOLL_CTL_DEL, ioHandle->_ioFile, &ev );
+
+    pthread_mutex_lock( &_mutex );
+    ioHandle->_intWatchEvents = 0;
+    ioHandle->_intReadyEvents = 0;
+    ioHandle->_intDeadline = 0;
+    ioHandle->_boolInEpoll = false;
+    _setHandles.insert( ioHandle );
+    pthread_mutex_unlock( &_mutex );
+
+    return true;
+}
+
+/*!
+ * Remove the handle, must be called before the handle is closed
+ */
+void IOReadiness::mRemove( PosixIOHandle* ioHandle ) {
+    pthread_mutex_lock( &_mutex );
+    ioHandle->_intWatchEvents = 0;
+    mUpdateInterest( ioHandle );
+    _setHandles.erase( ioHandle );
+    pthread_mutex_unlock( &_mutex );
+}
+
+/*!
+ * Tell epoll about the events the handle is waiting for
+ */
+bool IOReadiness::mUpdateInterest( PosixIOHandle* ioHandle ) {
+    struct epoll_event ev;
+
+    memset( &ev, 0, sizeof(ev) );
+    ev.data.ptr = ioHandle;
+
+    // Nothing to wait for, take it out of the set
+    if( ioHandle->_intWatchEvents == 0 ) {
+        if( ioHandle->_boolInEpoll ) {
+            epoll_ctl( _ioEpoll, EPOLL_CTL_DEL, ioHandle->_ioFile, &ev );
+            ioHandle->_boolInEpoll = false;
+        }
+        return true;
+    }
+
+    if( ioHandle->_intWatchEvents & Read )  ev.events |= EPOLLIN;
+    if( ioHandle->_intWatchEvents & Write ) ev.events |= EPOLLOUT;
+
+    int intOp = EPOLL_CTL_ADD;
+    if( ioHandle->_boolInEpoll ) intOp = EPOLL_CTL_MOD;
+
+    if( epoll_ctl( _ioEpoll, intOp, ioHandle->_ioFile, &ev ) == -1 ) {
+        mSetError() << "epoll_ctl() failed - " << strerror( errno );
+        return false;
+    }
+    ioHandle->_boolInEpoll = true;
+    return true;
+}
+
+/*!
+ * Collect events from epoll and mark the handles ready, only one thread
+ * calls epoll_wait() at a time, the others wait for it to hand out the
+ * events. Must be called with the mutex held
+ */
+bool IOReadiness::mDispatch( int intMilliSeconds ) {
+    struct epoll_event arrEvents[ READINESS_MAX_EVENTS ];
+
+    // Someone is already waiting in epoll_wait(), wait for them to dispatch
+    if( _boolPolling ) {
+        if( intMilliSeconds < 0 ) {
+            pthread_cond_wait( &_condEvents, &_mutex );
+        } else if( intMilliSeconds > 0 ) {
+            long long intDeadline = mNow() + intMilliSeconds;
+            struct timespec ts;
+            ts.tv_sec = intDeadline / 1000;
+            ts.tv_nsec = ( intDeadline % 1000 ) * 1000000;
+            pthread_cond_timedwait( &_condEvents, &_mutex, &ts );
+        }
+        return true;
+    }
+
+    _boolPolling = true;
+    pthread_mutex_unlock( &_mutex );
+
+    int intCount = epoll_wait( _ioEpoll, arrEvents, READINESS_MAX_EVENTS, intMilliSeconds );
+    int intErr = errno;
+
+    pthread_mutex_lock( &_mutex );
+    _boolPolling = false;
+
+    if( intCount == -1 ) {
+        pthread_cond_broadcast( &_condEvents );
+        if( intErr == EINTR ) return true;
+        mSetError() << "epoll_wait() failed - " << strerror( intErr );
+        return false;
+    }
+
+    for( int i = 0 ; i < intCount ; ++i ) {
+        PosixIOHandle* ioHandle = static_cast<PosixIOHandle*>( arrEvents[i].data.ptr );
+
+        // The handle was removed while we were waiting
+        if( _setHandles.find( ioHandle ) == _setHandles.end() ) continue;
+
+        // Errors and hang ups are reported as ready, the next read or write will see them
+        int intReady = 0;
+        if( arrEvents[i].events & ( EPOLLIN | EPOLLHUP | EPOLLERR ) )  intReady |= Read;
+        if( arrEvents[i].events & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) ) intReady |= Write;
+        intReady &= ioHandle->_intWatchEvents;
+
+        ioHandle->_intReadyEvents |= intReady;
+        ioHandle->_intWatchEvents &= ~intReady;
+        mUpdateInterest( ioHandle );
+    }
+
+    pthread_cond_broadcast( &_condEvents );
+    return true;
+}
+
+/*!
+ * Wait for the handle to become ready for intEvents
+ * Return 0 if ready, 1 if we timed out, -1 on error
+ */
+int IOReadiness::mWait( PosixIOHandle* ioHandle, int intEvents, int intSeconds ) {
+    long long intDeadline = mNow() + ( intSeconds * 1000LL );
+    bool boolPolled = false;
+    int intResult = 1;
+
+    pthread_mutex_lock( &_mutex );
+
+    ioHandle->_intWatchEvents |= intEvents;
+    if( ! mUpdateInterest( ioHandle ) ) {
+        ioHandle->_intWatchEvents &= ~intEvents;
+        pthread_mutex_unlock( &_mutex );
+        return -1;
+    }
+
+    while( true ) {
+        if( ioHandle->_intReadyEvents & intEvents ) {
+            ioHandle->_intReadyEvents &= ~intEvents;
+            intResult = 0;
+            break;
+        }
+
+        long long intLeft = intDeadline - mNow();
+        if( intLeft < 0 ) intLeft = 0;
+
+        // Always check at least once, even with a timeout of 0
+        if( boolPolled and intLeft == 0 ) break;
+        boolPolled = true;
+
+        if( ! mDispatch( intLeft ) ) {
+            intResult = -1;
+            break;
+        }
+    }
+
+    ioHandle->_intWatchEvents &= ~intEvents;
+    mUpdateInterest( ioHandle );
+
+    pthread_mutex_unlock( &_mutex );
+    return intResult;
+}
+
+/*!
+ * Watch the handle for events until mPoll() reports it
+ */
+bool IOReadiness::mWatch( PosixIOHandle* ioHandle, int intEvents, int intSeconds ) {
+    pthread_mutex_lock( &_mutex );
+
+    ioHandle->_intWatchEvents |= intEvents;
+    ioHandle->_intDeadline = 0;
+    if( intSeconds > 0 ) ioHandle->_intDeadline = mNow() + ( intSeconds * 1000LL );
+
+    bool boolResult = mUpdateInterest( ioHandle );
+
+    pthread_mutex_unlock( &_mutex );
+    return boolResult;
+}
+
+/*!
+ * Wait for any of the watched handles to become ready or pass their deadline
+ */
+int IOReadiness::mPoll( std::vector<PosixIOHandle*>& vecReady, std::vector<PosixIOHandle*>& vecExpired,
+                        int intMilliSeconds ) {
+    std::set<PosixIOHandle*>::iterator it;
+    long long intEnd = mNow() + intMilliSeconds;
+    bool boolPolled = false;
+    int intCount = 0;
+
+    pthread_mutex_lock( &_mutex );
+
+    while( true ) {
+        long long intNow = mNow();
+
+        // Report the handles that are ready or past their deadline
+        for( it = _setHandles.begin() ; it != _setHandles.end() ; ++it ) {
+            PosixIOHandle* ioHandle = *it;
+
+            if( ioHandle->_intReadyEvents ) {
+                ioHandle->_intReadyEvents = 0;
+                if( ioHandle->_intWatchEvents == 0 ) ioHandle->_intDeadline = 0;
+                vecReady.push_back( ioHandle );
+                ++intCount;
+                continue;
+            }
+
+            if( ioHandle->_intWatchEvents and ioHandle->_intDeadline and intNow >= ioHandle->_intDeadline ) {
+                ioHandle->_intWatchEvents = 0;
+                ioHandle->_intDeadline = 0;
+                mUpdateInterest( ioHandle );
+                vecExpired.push_back( ioHandle );
+                ++intCount;
+            }
+        }
+
+        if( intCount ) break;
+
+        // Do not sleep past the nearest deadline
+        long long intLeft = -1;
+        if( intMilliSeconds >= 0 ) {
+            intLeft = intEnd - intNow;
+            if( intLeft < 0 ) intLeft = 0;
+        }
+        for( it = _setHandles.begin() ; it != _setHandles.end() ; ++it ) {
+            if( (*it)->_intWatchEvents and (*it)->_intDeadline ) {
+                long long intDeadline = (*it)->_intDeadline - intNow;
+                if( intDeadline < 0 ) intDeadline = 0;
+                if( intLeft < 0 or intDeadline < intLeft ) intLeft = intDeadline;
+            }
+        }
+
+        // Always check at least once, even with a timeout of 0
+        if( boolPolled and intLeft == 0 and intMilliSeconds >= 0 and intNow >= intEnd ) break;
+        boolPolled = true;
+
+        if( ! mDispatch( intLeft ) ) {
+            intCount = -1;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &_mutex );
+    return intCount;
+}
@@ -0,0 +1,76 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef IOREADINESS_INCLUDE_H
+#define IOREADINESS_INCLUDE_H
+
+#include <IOHandle.h>
+#include <pthread.h>
+#include <vector>
+#include <set>
+
+/*!
+ *  Waits for streaming PosixIOHandles ( pipes, FIFOs and sockets ) to
+ *  become ready using a single epoll instance shared by all handles.
+ *
+ *  A handle can wait on itself with mWait(), or one thread can watch
+ *  many handles with mWatch() and collect them with mPoll()
+ */
+class IOReadiness : public OllieCommon {
+
+    public:
+        IOReadiness( void );
+        ~IOReadiness( void );
+
+        // Events a handle can wait for
+        enum Events { Read = 1, Write = 2 };
+
+        static IOReadiness* mShared( void );
+
+        // Add / Remove a handle from the epoll instance
+        bool mAdd( PosixIOHandle* );
+        void mRemove( PosixIOHandle* );
+
+        // Wait for the handle to become ready, returns 0 if ready, 1 on timeout, -1 on error
+        int  mWait( PosixIOHandle*, int intEvents, int intSeconds );
+
+        // Watch the handle for events, the handle is reported as expired
+        // by mPoll() if it is not ready within intSeconds ( 0 = no deadline )
+        bool mWatch( PosixIOHandle*, int intEvents, int intSeconds );
+
+        // Wait up to intMilliSeconds for any watched handle to become
+        // ready or expire, returns the number of handles reported or -1 on error
+        int  mPoll( std::vector<PosixIOHandle*>& vecReady, std::vector<PosixIOHandle*>& vecExpired,
+                    int intMilliSeconds );
+
+        static long long mNow( void );
+
+    protected:
+        bool mDispatch( int intMilliSeconds );
+        bool mUpdateInterest( PosixIOHandle* );
+
+        int                         _ioEpoll;
+        bool                        _boolPolling;
+        pthread_mutex_t             _mutex;
+        pthread_cond_t              _condEvents;
+        std::set<PosixIOHandle*>    _setHandles;
+};
+
+#endif // IOREADINESS_INCLUDE_H
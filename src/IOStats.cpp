@@ -0,0 +1,125 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <IOStats.h>
+
+#include <time.h>
+#include <stdio.h>
+
+/*!
+ * Return a monotonic time in micro seconds
+ */
+long long IOStats::mNow( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( ts.tv_sec * 1000000LL ) + ( ts.tv_nsec / 1000 );
+}
+
+/*!
+ * Return the histogram bucket for the latency
+ */
+int IOStats::mBucketFor( long long intMicroSeconds ) {
+    int intBucket = 0;
+
+    while( intMicroSeconds > 0 and intBucket < IOSTATS_BUCKETS - 1 ) {
+        intMicroSeconds >>= 1;
+        ++intBucket;
+    }
+    return intBucket;
+}
+
+const char* IOStats::mOpName( Op op ) {
+    switch( op ) {
+        case Read:      return "read";
+        case Write:     return "write";
+        case Seek:      return "seek";
+        case Truncate:  return "truncate";
+        case Wait:      return "wait";
+        default:        return "unknown";
+    }
+}
+
+/*!
+ * Zero all the counters
+ */
+void IOStats::mReset( void ) {
+    for( int op = 0 ; op < OpCount ; ++op ) {
+        _arrCalls[op] = 0;
+        _arrBytes[op] = 0;
+        _arrMicroSeconds[op] = 0;
+        for( int i = 0 ; i < IOSTATS_BUCKETS ; ++i ) _arrBuckets[op][i] = 0;
+    }
+}
+
+/*!
+ * Count a single call
+ */
+void IOStats::mRecord( Op op, OffSet offBytes, long long intMicroSeconds ) {
+    __sync_fetch_and_add( &_arrCalls[op], 1LL );
+    __sync_fetch_and_add( &_arrBytes[op], (long long)offBytes );
+    __sync_fetch_and_add( &_arrMicroSeconds[op], intMicroSeconds );
+    __sync_fetch_and_add( &_arrBuckets[op][ mBucketFor( intMicroSeconds ) ], 1LL );
+}
+
+void IOStats::mAdd( const IOStats& stats ) {
+    for( int op = 0 ; op < OpCount ; ++op ) {
+        __sync_fetch_and_add( &_arrCalls[op], stats._arrCalls[op] );
+        __sync_fetch_and_add( &_arrBytes[op], stats._arrBytes[op] );
+        __sync_fetch_and_add( &_arrMicroSeconds[op], stats._arrMicroSeconds[op] );
+        for( int i = 0 ; i < IOSTATS_BUCKETS ; ++i ) {
+            __sync_fetch_and_add( &_arrBuckets[op][i], stats._arrBuckets[op][i] );
+        }
+    }
+}
+
+/*!
+ * Return the upper bound in micro seconds of the bucket 
+ * that holds the percentile ( 0.0 - 1.0 ) of the calls
+ */
+long long IOStats::mGetPercentile( Op op, double dblPercentile ) const {
+    long long intCalls = _arrCalls[op];
+    long long intCount = 0;
+
+    if( ! intCalls ) return 0;
+
+    for( int i = 0 ; i < IOSTATS_BUCKETS ; ++i ) {
+        intCount += _arrBuckets[op][i];
+        if( intCount >= intCalls * dblPercentile ) return 1LL << i;
+    }
+    return 1LL << ( IOSTATS_BUCKETS - 1 );
+}
+
+/*!
+ * Return a line for each operation that was called
+ */
+std::string IOStats::mReport( void ) const {
+    std::string strReport;
+    char arrLine[256];
+
+    for( int op = 0 ; op < OpCount ; ++op ) {
+        if( ! _arrCalls[op] ) continue;
+
+        snprintf( arrLine, sizeof( arrLine ), "%-8s %10lld calls %14lld bytes %12lld us  p50 %lld us  p99 %lld us\n",
+                  mOpName( Op( op ) ), _arrCalls[op], _arrBytes[op], _arrMicroSeconds[op],
+                  mGetPercentile( Op( op ), 0.50 ), mGetPercentile( Op( op ), 0.99 ) );
+        strReport += arrLine;
+    }
+    return strReport;
+}
@@ -0,0 +1,89 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef IOSTATS_INCLUDE_H
+#define IOSTATS_INCLUDE_H
+
+#include <Ollie.h>
+
+// The number of log2 latency buckets, the last bucket holds everything over 2^30 micro seconds ( ~18 minutes )
+#define IOSTATS_BUCKETS     32
+
+/*!
+ *  Counts the calls, bytes and time spent in each kind of IOHandle 
+ *  operation, with a histogram of the call latencies. Bucket 0 holds
+ *  calls under 1 micro second, bucket N holds calls that took 
+ *  2^(N-1) to 2^N micro seconds.
+ *
+ *  The counters are updated with atomic adds, so the readahead and
+ *  async worker threads can record without taking a lock
+ */
+class IOStats {
+
+    public:
+        IOStats( void ) { mReset(); }
+        ~IOStats( void ) { }
+
+        // The operations we keep stats for
+        enum Op { Read, Write, Seek, Truncate, Wait, OpCount };
+
+        void        mReset( void );
+        void        mRecord( Op, OffSet offBytes, long long intMicroSeconds );
+        //! Add the counters from another IOStats to ours
+        void        mAdd( const IOStats& );
+
+        long long   mGetCalls( Op op ) const { return _arrCalls[op]; }
+        long long   mGetBytes( Op op ) const { return _arrBytes[op]; }
+        long long   mGetMicroSeconds( Op op ) const { return _arrMicroSeconds[op]; }
+        long long   mGetBucket( Op op, int intBucket ) const { return _arrBuckets[op][intBucket]; }
+        long long   mGetPercentile( Op, double ) const;
+        std::string mReport( void ) const;
+
+        static int          mBucketFor( long long intMicroSeconds );
+        static long long    mNow( void );
+        static const char*  mOpName( Op );
+
+        volatile long long  _arrCalls[ OpCount ];
+        volatile long long  _arrBytes[ OpCount ];
+        volatile long long  _arrMicroSeconds[ OpCount ];
+        volatile long long  _arrBuckets[ OpCount ][ IOSTATS_BUCKETS ];
+};
+
+/*!
+ * Times an operation from construction until it goes out of scope
+ * and records it, so every return path of a method is counted
+ */
+class IOStatsTimer {
+
+    public:
+        IOStatsTimer( IOStats& stats, IOStats::Op op ) : _stats( stats ), _op( op ), 
+                                                         _offBytes(0), _intStart( IOStats::mNow() ) { }
+        ~IOStatsTimer( void ) { _stats.mRecord( _op, _offBytes, IOStats::mNow() - _intStart ); }
+
+        //! Record the bytes transferred, errors ( -1 ) are not counted
+        void        mSetBytes( OffSet offBytes ) { if( offBytes > 0 ) _offBytes = offBytes; }
+
+        IOStats&    _stats;
+        IOStats::Op _op;
+        OffSet      _offBytes;
+        long long   _intStart;
+};
+
+#endif // IOSTATS_INCLUDE_H
@@ -0,0 +1,244 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <LatencyIOHandle.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+/*!
+ * LatencyIOHandle Constructor
+ */
+LatencyIOHandle::LatencyIOHandle( IOHandle* ioHandle, unsigned int intSeed )
+                : _ioHandle( ioHandle ), _intSeed( intSeed ), _intLatency(0), _intJitter(0), _offShortRead(0),
+                  _intStallEvery(0), _intStallTime(0), _intCalls(0), _intStallEnd(0), _boolOpen(false) {
+
+    assert( ioHandle != 0 );
+}
+
+/*!
+ * LatencyIOHandle Destructor
+ */
+LatencyIOHandle::~LatencyIOHandle() {
+
+    mClose();
+    delete _ioHandle;
+
+}
+
+/*!
+ * Return a monotonic time in milliseconds
+ */
+long long LatencyIOHandle::mNow( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( ts.tv_sec * 1000LL ) + ( ts.tv_nsec / 1000000 );
+}
+
+/*!
+ * Sleep for intMicroSeconds, a signal does not cut the sleep short
+ */
+void LatencyIOHandle::mSleep( long long intMicroSeconds ) {
+    struct timespec ts;
+    ts.tv_sec  = intMicroSeconds / 1000000;
+    ts.tv_nsec = ( intMicroSeconds % 1000000 ) * 1000;
+
+    while( nanosleep( &ts, &ts ) == -1 and errno == EINTR ) { }
+}
+
+/*!
+ * Open the wrapped handle
+ */
+bool LatencyIOHandle::mOpen( const char* strFileName, OpenMode mode ) {
+
+    if( _boolOpen ) { mClose(); }
+
+    if( ! _ioHandle->mOpen( strFileName, mode ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _boolOpen = true;
+
+    _strName        = _ioHandle->mGetName();
+    _offFileSize    = _ioHandle->mGetFileSize();
+    _offDeviceBlock = _ioHandle->mGetDeviceBlockSize();
+    _ioFile         = _ioHandle->_ioFile;
+    _intStallEnd    = 0;
+
+    return true;
+}
+
+/*!
+ * Close the wrapped handle
+ */
+bool LatencyIOHandle::mClose( void ) {
+
+    _ioFile = 0;
+    _intStallEnd = 0;
+    _boolOpen = false;
+
+    if( ! _ioHandle->mClose() ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Block until the current stall is over, then sleep for the
+ * latency of a single call. Every _intStallEvery calls a new
+ * stall starts that the following calls will run into
+ */
+void LatencyIOHandle::mDelay( void ) {
+
+    if( _intStallEnd ) {
+        long long intLeft = _intStallEnd - mNow();
+        if( intLeft > 0 ) mSleep( intLeft * 1000 );
+        _intStallEnd = 0;
+    }
+
+    int intDelay = _intLatency;
+    if( _intJitter ) intDelay += rand_r( &_intSeed ) % ( _intJitter + 1 );
+    if( intDelay ) mSleep( intDelay );
+
+    ++_intCalls;
+    if( _intStallEvery and ( _intCalls % _intStallEvery ) == 0 ) {
+        _intStallEnd = mNow() + _intStallTime;
+    }
+}
+
+/*!
+ * Wait out a stall for up to intSeconds
+ * Return 0 if the stall is over, 1 if we timed out
+ */
+int LatencyIOHandle::mWaitForStall( int intSeconds, const char* strOp ) {
+
+    if( ! _intStallEnd ) return 0;
+
+    long long intLeft = _intStallEnd - mNow();
+    if( intLeft <= 0 ) {
+        _intStallEnd = 0;
+        return 0;
+    }
+
+    if( intLeft > intSeconds * 1000LL ) {
+        if( intSeconds ) mSleep( intSeconds * 1000000LL );
+        mSetError() << "IO Error: Timeout waiting to " << strOp << " '" << _strName << "'";
+        return 1;
+    }
+
+    mSleep( intLeft * 1000 );
+    _intStallEnd = 0;
+    return 0;
+}
+
+/*!
+ * Return 0 if the read will not block
+ */
+int LatencyIOHandle::mWaitForClearToRead( int intSeconds ) {
+
+    int intVal = mWaitForStall( intSeconds, "read" );
+    if( intVal ) return intVal;
+
+    intVal = _ioHandle->mWaitForClearToRead( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    return intVal;
+}
+
+/*!
+ * Return 0 if the write will not block
+ */
+int LatencyIOHandle::mWaitForClearToWrite( int intSeconds ) {
+
+    int intVal = mWaitForStall( intSeconds, "write" );
+    if( intVal ) return intVal;
+
+    intVal = _ioHandle->mWaitForClearToWrite( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    return intVal;
+}
+
+/*!
+ * Seeks are not delayed, they only change the position
+ */
+OffSet LatencyIOHandle::mSeek( OffSet offset ) {
+    OffSet offVal = _ioHandle->mSeek( offset );
+
+    if( offVal == -1 ) mSetError( _ioHandle->mGetError() );
+    return offVal;
+}
+
+/*!
+ * Delay, then read at most _offShortRead bytes
+ */
+OffSet LatencyIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+
+    mDelay();
+
+    if( _offShortRead and offSize > _offShortRead ) offSize = _offShortRead;
+
+    OffSet offLen = _ioHandle->mRead( cstrBuffer, offSize );
+    if( offLen < 0 ) mSetError( _ioHandle->mGetError() );
+    return offLen;
+}
+
+/*!
+ * Delay, then write
+ */
+OffSet LatencyIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
+
+    mDelay();
+
+    OffSet offLen = _ioHandle->mWrite( cstrBuffer, offSize );
+    if( offLen < 0 ) mSetError( _ioHandle->mGetError() );
+    _offFileSize = _ioHandle->mGetFileSize();
+    return offLen;
+}
+
+/*!
+ * Delay once for the whole vector, then write
+ */
+OffSet LatencyIOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+
+    mDelay();
+
+    OffSet offLen = _ioHandle->mWriteV( arrIov, intCount );
+    if( offLen < 0 ) mSetError( _ioHandle->mGetError() );
+    _offFileSize = _ioHandle->mGetFileSize();
+    return offLen;
+}
+
+/*!
+ * Delay, then truncate
+ */
+bool LatencyIOHandle::mTruncate( OffSet offset ) {
+
+    mDelay();
+
+    if( ! _ioHandle->mTruncate( offset ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _offFileSize = _ioHandle->mGetFileSize();
+    return true;
+}
@@ -0,0 +1,89 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef LATENCYIOHANDLE_INCLUDE_H
+#define LATENCYIOHANDLE_INCLUDE_H
+
+#include <IOHandle.h>
+
+/*!
+ *  A Class that wraps another IOHandle and makes it behave like a
+ *  slow or remote mount. Reads, writes and truncates are delayed by
+ *  a fixed latency plus random jitter, reads can be cut short, and
+ *  every Nth call starts a stall that blocks the handle for a while.
+ *
+ *  While stalled mWaitForClearToRead() and mWaitForClearToWrite() 
+ *  time out if the stall outlasts the timeout, the same way a remote
+ *  mount does during an outage. Reads and writes simply block until
+ *  the stall is over.
+ *
+ *  The jitter is generated from a seed so runs can be repeated.
+ *  The wrapped handle is owned and deleted by this handle
+ */
+class LatencyIOHandle : public IOHandle {
+    public:
+        LatencyIOHandle( IOHandle*, unsigned int intSeed = 1 );
+        virtual ~LatencyIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return _ioHandle->mOffersLargeFileSupport(); }
+        virtual bool    mOffersSeek( void ) { return _ioHandle->mOffersSeek(); }
+        virtual int     mWaitForClearToRead( int );
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual IOStats& mGetStats( void ) { return _ioHandle->mGetStats(); }
+        virtual OffSet  mWriteV( const struct iovec*, int );
+
+        //! Delay each call by intMicroSeconds plus up to intJitter micro seconds
+        void            mSetLatency( int intMicroSeconds, int intJitter = 0 ) { 
+                            _intLatency = intMicroSeconds; _intJitter = intJitter; }
+        //! Return at most offSize bytes from each read ( 0 = no limit )
+        void            mSetShortReads( OffSet offSize ) { _offShortRead = offSize; }
+        //! Stall for intMilliSeconds on every intEvery call ( 0 = never )
+        void            mSetStall( int intEvery, int intMilliSeconds ) { 
+                            _intStallEvery = intEvery; _intStallTime = intMilliSeconds; }
+        //! The number of delayed calls made so far
+        long            mGetCalls( void ) { return _intCalls; }
+
+        void            mDelay( void );
+        int             mWaitForStall( int, const char* );
+        static long long mNow( void );
+        static void     mSleep( long long );
+
+        IOHandle*       _ioHandle;
+        unsigned int    _intSeed;
+        int             _intLatency;
+        int             _intJitter;
+        OffSet          _offShortRead;
+        int             _intStallEvery;
+        int             _intStallTime;
+        long            _intCalls;
+        // When the current stall is over in milliseconds ( 0 = not stalled )
+        long long       _intStallEnd;
+        // The wrapped handle is open, _ioFile is 0 for handles without a descriptor
+        bool            _boolOpen;
+};
+
+#endif // LATENCYIOHANDLE_INCLUDE_H
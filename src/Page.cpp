@@ -28,12 +28,20 @@ namespace Ollie {
 
         /********************************************/
 
-        Block::Block( const ByteArray& arrBytes ) :_sizeBlockSize(0) {
+        /*!
+         * Is the byte at intPos the start of a UTF-8 sequence ( or the end of the bytes )
+         */
+        static bool isCodePoint( const ByteArray& arrBytes, size_t intPos ) {
+            if( intPos >= arrBytes.mSize() ) return true;
+            return ( arrBytes.mData()[ intPos ] & 0xC0 ) != 0x80;
+        }
+
+        Block::Block( const ByteArray& arrBytes ) :_sizeBlockSize(0), _boolDirty(false) {
             _arrBlockData.mAppend( arrBytes );
             _sizeBlockSize += arrBytes.mSize();
         }
 
-        Block::Block( const ByteArray& arrBytes, const Attributes &attr ) :_sizeBlockSize(0) {
+        Block::Block( const ByteArray& arrBytes, const Attributes &attr ) :_sizeBlockSize(0), _boolDirty(false) {
             _arrBlockData.mAppend( arrBytes );
             _sizeBlockSize += arrBytes.mSize();
             _attr = attr;
@@ -42,6 +50,9 @@ namespace Ollie {
         void Block::mSetBytes( const ByteArray& arrBytes ) {
             _arrBlockData.mAppend( arrBytes );
             _sizeBlockSize += arrBytes.mSize();
+            _boolDirty = true;
+            // The new bytes were never validated
+            _attr.mSetFlag( Attributes::Utf8Validated, false );
         }
 
         int Block::mInsertBytes( int intPos, const ByteArray& arrBytes ) {
@@ -55,6 +66,9 @@ namespace Ollie {
 
             // Update the size
             _sizeBlockSize += arrBytes.mSize();
+            _boolDirty = true;
+            // The new bytes were never validated
+            _attr.mSetFlag( Attributes::Utf8Validated, false );
 
             return arrBytes.mSize();
         }
@@ -63,6 +77,10 @@ namespace Ollie {
 
             BlockPtr newBlock( new Block() );
 
+            // Valid UTF-8 cut on code points is still valid
+            bool boolValid = _attr.mHasFlag( Attributes::Utf8Validated ) and isCodePoint( _arrBlockData, intPos ) 
+                             and ( intLen < 0 or isCodePoint( _arrBlockData, intPos + intLen ) );
+
             if( intLen < 0 ) { 
                 // Set the new block data
                 newBlock->mSetBytes( _arrBlockData.mSubStr( intPos, nPos ) );
@@ -77,6 +95,8 @@ namespace Ollie {
 
             // Update the block size
             _sizeBlockSize = _arrBlockData.mSize();
+            _boolDirty = true;
+            _attr.mSetFlag( Attributes::Utf8Validated, boolValid );
             // Copy the attributes from this block into the new block
             newBlock->mSetAttributes( mAttributes() );
 
@@ -215,6 +235,9 @@ namespace Ollie {
 
             Block::Iterator itOld;
 
+            _boolDirty = true;
+            _boolBlocksChanged = true;
+
             // If this is the only block in the page
             if( itBlock.it == mLast().it and itBlock.it == mFirst().it ) {
                 // Replace the current block with an empty one
@@ -298,6 +321,8 @@ namespace Ollie {
 
             // Record Incr the Cur size of our page
             _offPageSize += (*ptrItem)->mSize();
+            _boolDirty = true;
+            _boolBlocksChanged = true;
             // Update the pos to the end of the block
             itBlock.mSetPos( (*ptrItem)->mSize() );
 
@@ -343,6 +368,8 @@ namespace Ollie {
 
             ChangeSetPtr changeSet( new ChangeSet );
 
+            _boolDirty = true;
+
             // Make a copy of our iterator
             Block::Iterator itStart( itBlock );
 
@@ -416,6 +443,7 @@ namespace Ollie {
 
             // Update the page size
             _offPageSize += intLen;
+            _boolDirty = true;
             // Update the pos
             itBlock.mSetPos( itBlock.mPos() + intLen );
 
@@ -534,6 +562,24 @@ namespace Ollie {
             std::cout << it.mPage() << " Block " << it->mAttributes().mTestValue() << " - " << &(*it) <<  " - " << it->mBytes() << std::endl;
         }
 
+        /*!
+         * Record the page was written to the file at offset, 
+         * and now matches what is in the file
+         */
+        void Page::mSetSaved( OffSet offset ) {
+            PPtrIterator<Block> it;
+
+            _offFileOffSet = offset;
+            _offSavedSize = _offPageSize;
+            _boolDirty = false;
+            _boolBlocksChanged = false;
+
+            for( it = blockContainer.mFirst() ; it != blockContainer.mLast() ; ++it ) {
+                it->mSetClean();
+            }
+            it->mSetClean();
+        }
+
         const ByteArray& Page::mByteArray( const Block::Iterator& itBlock, int intCount ) { 
             assert( itBlock.mPage() == this );
             assert( itBlock.mIsValid() == true );
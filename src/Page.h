@@ -41,7 +41,7 @@ namespace Ollie {
         class Block {
 
             public:
-                Block( void ) : _sizeBlockSize(0) {} 
+                Block( void ) : _sizeBlockSize(0), _boolDirty(false) {} 
                 Block( const ByteArray& );
                 Block( const ByteArray& , const Attributes &attr );
                  ~Block( void ) {}
@@ -56,6 +56,9 @@ namespace Ollie {
                 bool                mIsEmpty( void ) const { return _arrBlockData.mIsEmpty(); }
                 void                mClear( void ) { _arrBlockData.mClear(); _sizeBlockSize = 0; }
                 size_t              mSize( void ) const { return _sizeBlockSize; }
+                // Has the block changed since it was last saved?
+                bool                mIsDirty( void ) const { return _boolDirty; }
+                void                mSetClean( void ) { _boolDirty = false; }
 
                 int                 mInsertBytes( int, const ByteArray& );
                 Block*              mDeleteBytes( int, int );
@@ -63,6 +66,7 @@ namespace Ollie {
                 ByteArray           _arrBlockData;
                 size_t              _sizeBlockSize;
                 Attributes          _attr;
+                bool                _boolDirty;
 
         };
         typedef std::auto_ptr<Block> BlockPtr;
@@ -282,7 +286,9 @@ namespace Ollie {
 
             public:
                 Page( OffSet offTargetPageSize = DEFAULT_PAGE_SIZE ) : _offTargetPageSize( offTargetPageSize ),
-                                                                       _offPageSize( 0 ), _offFileOffSet( -1 ), _offOffSet( -1 ) {
+                                                                       _offPageSize( 0 ), _offFileOffSet( -1 ), _offOffSet( -1 ),
+                                                                       _offSavedSize( -1 ), _boolDirty( false ),
+                                                                       _boolBlocksChanged( false ) {
                     blockContainer.mPushBack( new Block() ); 
                 }
                 ~Page( void ) { }
@@ -343,6 +349,18 @@ namespace Ollie {
                     if( ( offBytes + _offPageSize ) > _offTargetPageSize ) return false; 
                     return true;
                 }
+                // Has the page changed since it was last saved?
+                bool mIsDirty( void ) const {
+                    return _boolDirty;
+                }
+                // Is the page still at the same offset and size it was last saved with?
+                bool mIsInPlace( OffSet offset ) const {
+                    if( _offFileOffSet == offset and _offSavedSize == _offPageSize ) return true;
+                    return false;
+                }
+                OffSet mSavedSize( void ) const {
+                    return _offSavedSize;
+                }
 
                 int mFindPos( const Block::Iterator& );
                 int mInsertBlock( Block::Iterator&, Block* );
@@ -359,6 +377,7 @@ namespace Ollie {
                 int mPrevBlock( Block::Iterator& );
                 const ByteArray& mByteArray( const Block::Iterator&, int );
                 void mPrintPage( void );
+                void mSetSaved( OffSet );
 
                 PPtrList<Block> blockContainer;
                 OffSet _offFileOffSet;
@@ -366,6 +385,12 @@ namespace Ollie {
                 OffSet _offTargetPageSize;
                 OffSet _offPageSize;
                 ByteArray _arrTemp;
+                // The size of the page when it was written at _offFileOffSet
+                OffSet _offSavedSize;
+                bool _boolDirty;
+                // Blocks were inserted or removed, so only the 
+                // entire page can be written in place
+                bool _boolBlocksChanged;
         };
         typedef std::auto_ptr<Page> PagePtr;
     };
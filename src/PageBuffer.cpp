@@ -51,6 +51,145 @@ namespace Ollie {
             return page->mSize();
         }
 
+        /*!
+         * Choose the page and block sizes for a file of offFileSize bytes, small files
+         * keep the default sizes so edits stay cheap. Large files get pages large enough
+         * to keep the page count near DEFAULT_MAX_PAGES, made of blocks that are whole 
+         * device blocks ( offDeviceBlock, 0 if unknown )
+         */
+        void PageBuffer::mSizeFor( OffSet offFileSize, OffSet offDeviceBlock, OffSet& offPage, OffSet& offBlock ) {
+            offPage = DEFAULT_PAGE_SIZE;
+            offBlock = DEFAULT_BLOCK_SIZE;
+
+            OffSet offWant = offFileSize / DEFAULT_MAX_PAGES;
+            if( offWant <= DEFAULT_PAGE_SIZE ) return;
+            if( offWant > DEFAULT_MAX_PAGE_SIZE ) offWant = DEFAULT_MAX_PAGE_SIZE;
+
+            offBlock = offWant / DEFAULT_PAGE_BLOCKS;
+            if( offBlock < DEFAULT_BLOCK_SIZE ) offBlock = DEFAULT_BLOCK_SIZE;
+            if( offDeviceBlock > 0 and offBlock > offDeviceBlock ) {
+                offBlock = ( ( offBlock + offDeviceBlock - 1 ) / offDeviceBlock ) * offDeviceBlock;
+            }
+
+            // The page is always a multiple of the block size
+            offPage = ( ( offWant + offBlock - 1 ) / offBlock ) * offBlock;
+        }
+
+        /*!
+         * Size the pages and the blocks the file reads for the file, 
+         * only an empty buffer that is sizing itself is changed
+         */
+        void PageBuffer::mSizeForFile( File* file ) {
+            OffSet offPage = 0;
+            OffSet offBlock = 0;
+
+            if( ! _boolAutoSize or ! mIsEmpty() ) return;
+
+            mSizeFor( file->mGetFileSize(), file->mGetIOHandler()->mGetDeviceBlockSize(), offPage, offBlock );
+
+            // Small files and sizes the caller asked for are left alone
+            if( offPage <= DEFAULT_PAGE_SIZE or offPage <= _offTargetPageSize ) return;
+
+            _offTargetPageSize = offPage;
+            pageList.begin()->mSetTargetSize( offPage );
+            if( offBlock > file->mGetBlockSize() ) file->mSetBlockSize( offBlock );
+        }
+
+        void PageBuffer::mSetTargetPageSize( OffSet offSize ) {
+            _offTargetPageSize = offSize;
+            _boolAutoSize = false;
+        }
+
+        /*!
+         * Count an edit, editing many times per page halves the size
+         * of the pages, until they are back to the default size
+         */
+        void PageBuffer::mCountEdit( void ) {
+
+            if( ! _boolAutoSize or _offTargetPageSize <= DEFAULT_PAGE_SIZE ) return;
+            if( ++_intEdits < mCount() * DEFAULT_EDIT_DENSITY ) return;
+
+            _offTargetPageSize /= 2;
+            if( _offTargetPageSize < DEFAULT_PAGE_SIZE ) _offTargetPageSize = DEFAULT_PAGE_SIZE;
+            _intEdits = 0;
+        }
+
+        /*!
+         * Read the next blocks of the file, mapped files point the iovec 
+         * at the mapping so the bytes are only copied once, into the block
+         */
+        static int readBlocks( File* file, bool boolMap, char* arrBuffer, struct iovec* arrIov, Attributes* arrAttr ) {
+            const char* ptrBlock = 0;
+
+            if( ! boolMap ) return file->mReadBlocks( DEFAULT_LOAD_BLOCKS, arrBuffer, arrIov, arrAttr );
+
+            OffSet offLen = file->mMapNextBlock( &ptrBlock, arrAttr[0] );
+            if( offLen <= 0 ) return offLen;
+
+            arrIov[0].iov_base = const_cast<char*>( ptrBlock );
+            arrIov[0].iov_len = offLen;
+            return 1;
+        }
+
+        /*!
+         * Read the file from it's current offset to the end and append the
+         * blocks to the buffer as new pages, the pages already in the buffer 
+         * are not touched. If the buffer held exactly what the file held up 
+         * to the offset, the new pages are marked as saved at their file offsets 
+         * Returns the number of bytes appended or -1 on error
+         */
+        OffSet PageBuffer::mAppendFile( File* file ) {
+            Attributes arrAttr[ DEFAULT_LOAD_BLOCKS ];
+            struct iovec arrIov[ DEFAULT_LOAD_BLOCKS ];
+            OffSet offTotal = 0;
+            int intBlocks = 0;
+            OffSet offStart = file->mGetOffSet();
+            OffSet offPage = offStart;
+
+            // The first load decides how large the pages are
+            if( offStart == 0 ) mSizeForFile( file );
+
+            // The mapping stays valid until the handle is closed, a followed file grows past it
+            bool boolMap = file->mOffersMap() and ! file->mIsFollowing();
+
+            std::vector<char> arrBlocks;
+            if( ! boolMap ) arrBlocks.resize( file->mGetBlockSize() * DEFAULT_LOAD_BLOCKS );
+
+            bool boolSaved = ( mIsEmpty() and offStart == 0 ) or ( _offSavedSize != -1 and _offSavedSize == offStart );
+
+            PagePtr page( new Page( _offTargetPageSize ) );
+            Block::Iterator itBlock = page->mFirst();
+
+            // Ask for many blocks at once, the file may read them all with one call
+            while( ( intBlocks = readBlocks( file, boolMap, boolMap ? 0 : &arrBlocks[0], arrIov, arrAttr ) ) > 0 ) {
+                for( int i = 0 ; i < intBlocks ; ++i ) {
+                    const char* arrBlockData = static_cast<const char*>( arrIov[i].iov_base );
+                    page->mInsertBlock( itBlock, new Block( ByteArray( arrBlockData, arrIov[i].iov_len ), arrAttr[i] ) );
+                    offTotal += arrIov[i].iov_len;
+
+                    if( page->mIsFull() ) {
+                        if( boolSaved ) page->mSetSaved( offPage );
+                        offPage += page->mSize();
+                        mAppendPage( page.release() );
+
+                        page.reset( new Page( _offTargetPageSize ) );
+                        itBlock = page->mFirst();
+                    }
+                }
+            }
+
+            if( ! page->mIsEmpty() ) {
+                if( boolSaved ) page->mSetSaved( offPage );
+                mAppendPage( page.release() );
+            }
+
+            if( intBlocks < 0 ) return -1;
+
+            if( boolSaved ) _offSavedSize = offStart + offTotal;
+
+            return offTotal;
+        }
+
         int PageBuffer::mInsertPage( Page::Iterator& it, Page* page ) {
             // If this is the only page in the buffer
             if( it.it == mFirst().it and it.it == mLast().it ) {
@@ -283,6 +422,56 @@ namespace Ollie {
 
         }
 
+        /*!
+         * Write the bytes from itStart up to itEnd to the file descriptor, the iovecs 
+         * point directly at the block storage so no copy of the range is built. 
+         * If boolSplice is true and the descriptor is a pipe the blocks are
+         * vmsplice()'d, the blocks must not change until the reader consumes them
+         * and each block takes a slot in the pipe, so a reader must be draining it
+         * Returns the number of bytes written or -1 with errno set
+         */
+        OffSet PageBuffer::mExport( int ioFile, const Page::Iterator& itStart, const Page::Iterator& itEnd, 
+                                    bool boolSplice ) {
+            std::vector<struct iovec> vecIov;
+            OffSet offTotal = 0;
+            OffSet offLen = 0;
+
+            Page::Iterator itTemp( itStart );
+
+            while( true ) {
+                bool boolLast = ( itTemp.itBlock.mPointer() == itEnd.itBlock.mPointer() );
+                int intPos = itTemp.itBlock.mPos();
+                int intEnd = itTemp.itBlock->mSize();
+                if( boolLast ) intEnd = itEnd.itBlock.mPos();
+
+                if( intEnd > intPos ) {
+                    struct iovec iov;
+                    iov.iov_base = const_cast<char*>( itTemp.itBlock->mBytes().mData() ) + intPos;
+                    iov.iov_len = intEnd - intPos;
+                    vecIov.push_back( iov );
+                }
+
+                // Write the blocks IOV_MAX at a time
+                if( vecIov.size() == IOV_MAX ) {
+                    if( boolSplice ) offLen = PosixIOHandle::mSpliceAllV( ioFile, &vecIov[0], vecIov.size() );
+                    else offLen = PosixIOHandle::mWriteAllV( ioFile, &vecIov[0], vecIov.size(), -1 );
+                    if( offLen < 0 ) return -1;
+                    offTotal += offLen;
+                    vecIov.clear();
+                }
+
+                if( boolLast or mNextBlock( itTemp ) == -1 ) break;
+            }
+
+            if( vecIov.empty() ) return offTotal;
+
+            if( boolSplice ) offLen = PosixIOHandle::mSpliceAllV( ioFile, &vecIov[0], vecIov.size() );
+            else offLen = PosixIOHandle::mWriteAllV( ioFile, &vecIov[0], vecIov.size(), -1 );
+            if( offLen < 0 ) return -1;
+
+            return offTotal + offLen;
+        }
+
         void PageBuffer::mPrintPageBuffer( void ) {
 
             boost::ptr_list<Page>::iterator it;
@@ -326,6 +515,10 @@ namespace Ollie {
            
             // Insert the bytes at the page level
             int intLen = it->mInsertBytes( it.itBlock, arrBytes, attr );
+
+            // The page size changed since the page was made, the split brings it to the new size
+            mCountEdit();
+            it->mSetTargetSize( _offTargetPageSize );
            
             // If the size of the page is equal or greater than the target size
             if( it->mSize() >= it->mTargetSize() ) {
@@ -339,6 +532,8 @@ namespace Ollie {
         ChangeSet* PageBuffer::mDeleteBytes( Page::Iterator& itPage, Page::Iterator& itEnd ) {
             bool boolUpdateIterator = false;
 
+            mCountEdit();
+
             // If the start and end are on the same page
             if( itPage.it == itEnd.it ) {
                 // Delete the bytes at the page level
@@ -380,5 +575,260 @@ namespace Ollie {
             return changeSet.release();
         }
 
+        // Hand a batch of blocks to the file and empty the batch
+        static OffSet writeBatch( File* file, std::vector<struct iovec>& vecIov, std::vector<Attributes>& vecAttr ) {
+            if( vecIov.empty() ) return 0;
+
+            OffSet offLen = file->mWriteBlocks( &vecIov[0], &vecAttr[0], vecIov.size() );
+
+            vecIov.clear();
+            vecAttr.clear();
+            return offLen;
+        }
+
+        /*!
+         * Queue the blocks from itBlock to the end of the page for writing, 
+         * writing them out IOV_MAX at a time
+         */
+        static OffSet queueBlocks( File* file, Page* page, Block::Iterator itBlock, std::vector<struct iovec>& vecIov,
+                                   std::vector<Attributes>& vecAttr, Block* blockLast = 0 ) {
+            OffSet offTotal = 0;
+            OffSet offLen = 0;
+
+            do {
+                // Point the file directly at the block storage, no copies are made
+                if( itBlock->mSize() ) {
+                    struct iovec iov;
+                    iov.iov_base = const_cast<char*>( itBlock->mBytes().mData() );
+                    iov.iov_len = itBlock->mSize();
+                    vecIov.push_back( iov );
+                    vecAttr.push_back( itBlock->mAttributes() );
+                }
+
+                // Write the blocks IOV_MAX at a time
+                if( vecIov.size() == IOV_MAX ) {
+                    if( ( offLen = writeBatch( file, vecIov, vecAttr ) ) < 0 ) return -1;
+                    offTotal += offLen;
+                }
+
+                if( itBlock.mPointer() == blockLast ) break;
+            } while( page->mNextBlock( itBlock ) != -1 );
+
+            return offTotal;
+        }
+
+        /*!
+         * Write the changes made to a page that still has the same
+         * size and offset in the file, only the blocks from the first
+         * to the last dirty block are written
+         */
+        static OffSet savePageInPlace( File* file, Page* page, OffSet offset ) {
+            std::vector<struct iovec> vecIov;
+            std::vector<Attributes> vecAttr;
+            OffSet offLen = 0;
+
+            Block::Iterator itBlock = page->mFirst();
+            Block::Iterator itStart = itBlock;
+            Block* blockLast = 0;
+            OffSet offStart = -1;
+            OffSet offPos = 0;
+
+            // The blocks moved around, we can only trust the page as a whole
+            if( page->_boolBlocksChanged ) {
+                offStart = 0;
+            } else {
+                do {
+                    if( itBlock->mIsDirty() ) {
+                        if( offStart == -1 ) {
+                            offStart = offPos;
+                            itStart = itBlock;
+                        }
+                        blockLast = itBlock.mPointer();
+                    }
+                    offPos += itBlock->mSize();
+                } while( page->mNextBlock( itBlock ) != -1 );
+
+                // The page changed, but none of its blocks are dirty 
+                // ( IE: Bytes were deleted and then inserted into a new block )
+                if( offStart == -1 ) {
+                    offStart = 0;
+                    itStart = page->mFirst();
+                    blockLast = 0;
+                }
+            }
+
+            if( file->mSetOffSet( offset + offStart ) == -1 ) return -1;
+
+            OffSet offTotal = queueBlocks( file, page, itStart, vecIov, vecAttr, blockLast );
+            if( offTotal < 0 or ( offLen = writeBatch( file, vecIov, vecAttr ) ) < 0 ) return -1;
+
+            return offTotal + offLen;
+        }
+
+        /*!
+         * Write the buffer to the file, returns the number of bytes written or -1 on error
+         *
+         * If boolInPlace is true and the file still holds what we last saved to it, 
+         * only the pages that changed are written. Pages that kept their size 
+         * are overwritten in place, everything from the first page that moved
+         * or changed size to the end of the buffer is rewritten and the 
+         * file is truncated.
+         */
+        OffSet PageBuffer::mSave( File* file, bool boolInPlace ) {
+            std::vector<struct iovec> vecIov;
+            std::vector<Attributes> vecAttr;
+            OffSet offTotal = 0;
+            OffSet offLen = 0;
+            OffSet offPosition = 0;
+
+            // The file must be exactly as we left it
+            if( ! file->mOffersInPlaceSave() or _offSavedSize == -1 or file->mGetFileSize() != _offSavedSize ) {
+                boolInPlace = false;
+            }
+
+            if( ! boolInPlace ) {
+                if( ! file->mPrepareSave() ) return -1;
+            }
+
+            vecIov.reserve( IOV_MAX );
+            vecAttr.reserve( IOV_MAX );
+
+            boost::ptr_list<Page>::iterator it;
+            for( it = pageList.begin() ; it != pageList.end() ; ++it ) {
+
+                if( boolInPlace ) {
+                    // Unchanged since the last save, leave it be
+                    if( it->mIsInPlace( offPosition ) ) {
+                        if( it->mIsDirty() ) {
+                            if( ( offLen = savePageInPlace( file, &*it, offPosition ) ) < 0 ) return -1;
+                            offTotal += offLen;
+                        }
+                        offPosition += it->mSize();
+                        continue;
+                    }
+
+                    // This page moved or changed size, rewrite everything from here on
+                    boolInPlace = false;
+                    if( file->mSetOffSet( offPosition ) == -1 ) return -1;
+                }
+
+                if( ( offLen = queueBlocks( file, &*it, it->mFirst(), vecIov, vecAttr ) ) < 0 ) return -1;
+                offTotal += offLen;
+                offPosition += it->mSize();
+            }
+
+            // Write what is left
+            if( ( offLen = writeBatch( file, vecIov, vecAttr ) ) < 0 ) return -1;
+            offTotal += offLen;
+
+            // Every page was in place, truncate any pages deleted from the end
+            if( boolInPlace ) {
+                if( file->mSetOffSet( offPosition ) == -1 ) return -1;
+            }
+
+            if( ! file->mFinalizeSave() ) return -1;
+
+            // Record where each page now lives in the file
+            offPosition = 0;
+            for( it = pageList.begin() ; it != pageList.end() ; ++it ) {
+                it->mSetSaved( offPosition );
+                offPosition += it->mSize();
+            }
+            _offSavedSize = offPosition;
+
+            return offTotal;
+        }
+
+        /*!
+         * Copy the range of the original file to the file
+         */
+        static OffSet copyRun( File* file, IOHandle* ioOriginal, OffSet& offRunStart, OffSet& offRunSize ) {
+            if( offRunSize == 0 ) return 0;
+
+            OffSet offLen = file->mCopyBlocks( ioOriginal, offRunStart, offRunSize );
+
+            offRunStart = -1;
+            offRunSize = 0;
+            return offLen;
+        }
+
+        /*!
+         * Write the buffer to a new file, ioOriginal is the file we last saved to.
+         * Runs of pages unchanged since that save are copied from the original
+         * by the IO ( with a reflink or copy_file_range() where possible ) and only
+         * the pages that changed are written from memory. 
+         * Returns the number of bytes written or copied, -1 on error
+         */
+        OffSet PageBuffer::mSaveAs( File* file, IOHandle* ioOriginal ) {
+            std::vector<struct iovec> vecIov;
+            std::vector<Attributes> vecAttr;
+            OffSet offTotal = 0;
+            OffSet offLen = 0;
+            OffSet offRunStart = -1;
+            OffSet offRunSize = 0;
+
+            // The original must be exactly as we left it
+            if( ! ioOriginal or ! file->mOffersInPlaceSave() or _offSavedSize == -1 
+                    or ioOriginal->mGetFileSize() != _offSavedSize ) {
+                return mSave( file );
+            }
+
+            if( ! file->mPrepareSave() ) return -1;
+
+            vecIov.reserve( IOV_MAX );
+            vecAttr.reserve( IOV_MAX );
+
+            boost::ptr_list<Page>::iterator it;
+            for( it = pageList.begin() ; it != pageList.end() ; ++it ) {
+
+                if( it->mIsEmpty() ) continue;
+
+                // Unchanged since the last save, copy it from the original
+                if( ! it->mIsDirty() and it->mFileOffSet() != -1 ) {
+
+                    // Extend the run if the page follows it in the original
+                    if( offRunSize and it->mFileOffSet() == offRunStart + offRunSize ) {
+                        offRunSize += it->mSize();
+                        continue;
+                    }
+
+                    // Blocks queued before this page must be written first
+                    if( ( offLen = writeBatch( file, vecIov, vecAttr ) ) < 0 ) return -1;
+                    offTotal += offLen;
+                    if( ( offLen = copyRun( file, ioOriginal, offRunStart, offRunSize ) ) < 0 ) return -1;
+                    offTotal += offLen;
+
+                    offRunStart = it->mFileOffSet();
+                    offRunSize = it->mSize();
+                    continue;
+                }
+
+                // Copy the run before writing this page after it
+                if( ( offLen = copyRun( file, ioOriginal, offRunStart, offRunSize ) ) < 0 ) return -1;
+                offTotal += offLen;
+
+                if( ( offLen = queueBlocks( file, &*it, it->mFirst(), vecIov, vecAttr ) ) < 0 ) return -1;
+                offTotal += offLen;
+            }
+
+            // Write and copy what is left
+            if( ( offLen = writeBatch( file, vecIov, vecAttr ) ) < 0 ) return -1;
+            offTotal += offLen;
+            if( ( offLen = copyRun( file, ioOriginal, offRunStart, offRunSize ) ) < 0 ) return -1;
+            offTotal += offLen;
+
+            if( ! file->mFinalizeSave() ) return -1;
+
+            // The pages now live in the new file
+            OffSet offPosition = 0;
+            for( it = pageList.begin() ; it != pageList.end() ; ++it ) {
+                it->mSetSaved( offPosition );
+                offPosition += it->mSize();
+            }
+            _offSavedSize = offPosition;
+
+            return offTotal;
+        }
+
     };
 };
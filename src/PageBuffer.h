@@ -23,6 +23,7 @@
 
 #include <Page.h>
 #include <boost/ptr_container/ptr_list.hpp>
+#include <vector>
 
 namespace Ollie {
     namespace OllieBuffer {
@@ -30,7 +31,9 @@ namespace Ollie {
         class PageBuffer {
 
             public:
-                PageBuffer( OffSet offTargetPageSize = DEFAULT_PAGE_SIZE  ) : _offTargetPageSize( offTargetPageSize ) {
+                PageBuffer( OffSet offTargetPageSize = DEFAULT_PAGE_SIZE  ) : _offTargetPageSize( offTargetPageSize ),
+                                                                              _offSavedSize( -1 ), _boolAutoSize( true ),
+                                                                              _intEdits( 0 ) {
                     pageList.push_back( new Page( _offTargetPageSize ) ); 
                 }
                 ~PageBuffer( void ){ };
@@ -63,14 +66,30 @@ namespace Ollie {
                 int mNextBlock( Page::Iterator& );
                 int mPrevBlock( Page::Iterator& );
                 const ByteArray& mByteArray( const Page::Iterator&, int );
+                OffSet mExport( int, const Page::Iterator&, const Page::Iterator&, bool boolSplice = false );
                 void mPrintPageBuffer( void );
                 void mUpdatePageOffSets( const boost::ptr_list<Page>::iterator& );
                 int mInsertBytes( Page::Iterator&, const ByteArray&, const Attributes& );
                 ChangeSet* mDeleteBytes( Page::Iterator& , Page::Iterator& );
+                OffSet mSave( File*, bool boolInPlace = false );
+                OffSet mSaveAs( File*, IOHandle* );
+                OffSet mAppendFile( File* );
+                // Set the target size of new pages, existing pages take the 
+                // new size the next time they are edited. Stops the automatic sizing
+                void mSetTargetPageSize( OffSet );
+                void mSizeForFile( File* );
+                void mCountEdit( void );
+                static void mSizeFor( OffSet offFileSize, OffSet offDeviceBlock, OffSet& offPage, OffSet& offBlock );
 
                 boost::ptr_list<Page> pageList;
                 OffSet _offTargetPageSize;
+                // The size of the file after the last save
+                OffSet _offSavedSize;
                 ByteArray _arrTemp;
+                // Size the pages from the file loaded and the edits made
+                bool _boolAutoSize;
+                // Edits since the page size last changed
+                int _intEdits;
         };
     };
 };
@@ -22,6 +22,9 @@
 #include <PageBuffer.h>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace Ollie::OllieBuffer;
@@ -406,5 +409,381 @@ class PageBufferTests : public CxxTest::TestSuite
 
         }
 
-};
+        // --------------------------------
+        // Save a buffer with more blocks than a single writev() accepts
+        // --------------------------------
+        void testPageBufferExport( void ) {
+            PageBuffer pageBuffer( 50 );
+            char arrBuffer[500];
+            int arrPipe[2];
+
+            TS_ASSERT_EQUALS( pageBuffer.mAppendPage( createDataPage( 0 ) ), 100 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendPage( createDataPage( 0 ) ), 100 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendPage( createDataPage( 0 ) ), 100 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendPage( createDataPage( 0 ) ), 100 );
+
+            // A range that starts and ends in the middle of a block, across pages
+            Page::Iterator itStart = pageBuffer.mFirst();
+            Page::Iterator itEnd = pageBuffer.mFirst();
+            TS_ASSERT_EQUALS( pageBuffer.mNext( itStart, 5 ), 5 );
+            TS_ASSERT_EQUALS( pageBuffer.mNext( itEnd, 355 ), 355 );
+            std::string strExpected = pageBuffer.mByteArray( itStart, 350 ).str();
+
+            TS_ASSERT_EQUALS( pipe( arrPipe ), 0 );
+
+            TS_ASSERT_EQUALS( pageBuffer.mExport( arrPipe[1], itStart, itEnd ), 350 );
+            TS_ASSERT_EQUALS( read( arrPipe[0], arrBuffer, sizeof( arrBuffer ) ), 350 );
+            TS_ASSERT_EQUALS( std::string( arrBuffer, 350 ), strExpected );
+
+            // Splice a range into the pipe, each block takes a slot in the pipe
+            // so keep it under the 16 slots a pipe has, since no one is reading
+            itEnd = itStart;
+            TS_ASSERT_EQUALS( pageBuffer.mNext( itEnd, 100 ), 100 );
+            TS_ASSERT_EQUALS( pageBuffer.mExport( arrPipe[1], itStart, itEnd, true ), 100 );
+            TS_ASSERT_EQUALS( read( arrPipe[0], arrBuffer, sizeof( arrBuffer ) ), 100 );
+            TS_ASSERT_EQUALS( std::string( arrBuffer, 100 ), strExpected.substr( 0, 100 ) );
+
+            // An empty range writes nothing
+            TS_ASSERT_EQUALS( pageBuffer.mExport( arrPipe[1], itStart, itStart ), 0 );
+
+            close( arrPipe[0] );
+            close( arrPipe[1] );
+        }
+
+        void testPageBufferSave( void ) {
+            PageBuffer pageBuffer( 50 );
+
+            // 110 pages of 10 blocks each
+            for( int i = 0 ; i < 110 ; ++i ) {
+                pageBuffer.mAppendPage( createDataPage( 'A' + ( i % 26 ) ) );
+            }
+
+            // Create an empty file to save to
+            close( open( TEST_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0644 ) );
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadWrite ), true );
+            File* file = new Utf8File( ioHandle );
+
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file ), 11000 );
+            TS_ASSERT_EQUALS( file->mGetOffSet(), 11000 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+
+            // Read the file back in
+            ifstream ioFile( TEST_FILE );
+            stringstream strContents;
+            strContents << ioFile.rdbuf();
+            string strData = strContents.str();
+
+            TS_ASSERT_EQUALS( strData.size(), 11000 );
+            TS_ASSERT_EQUALS( strData.substr( 0, 100 ), string( 100, 'A' ) );
+            TS_ASSERT_EQUALS( strData.substr( 10900, 100 ), string( 100, 'A' + ( 109 % 26 ) ) );
+
+            unlink( TEST_FILE );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        string readTestFile( void ) {
+            ifstream ioFile( TEST_FILE );
+            stringstream strContents;
+            strContents << ioFile.rdbuf();
+            return strContents.str();
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPageBufferSaveInPlace( void ) {
+            PageBuffer pageBuffer( 50 );
+
+            // 110 pages of 10 blocks each
+            for( int i = 0 ; i < 110 ; ++i ) {
+                pageBuffer.mAppendPage( createDataPage( 'A' + ( i % 26 ) ) );
+            }
+
+            close( open( TEST_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0644 ) );
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadWrite ), true );
+            File* file = new Utf8File( ioHandle );
+
+            // Nothing was saved yet, so everything is written
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 11000 );
+
+            // Nothing changed, nothing is written
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 0 );
+
+            // Replace a byte in the 3rd block of the 6th page
+            boost::ptr_list<Page>::iterator itPage = pageBuffer.pageList.begin();
+            std::advance( itPage, 5 );
+            Block::Iterator itBlock = itPage->mFirst();
+            TS_ASSERT_EQUALS( itPage->mNext( itBlock, 25 ), 25 );
+            delete itPage->mDeleteBytes( itBlock, 1 );
+            TS_ASSERT_EQUALS( itPage->mInsertBytes( itBlock, STR("z"), Attributes(3) ), 1 );
+            TS_ASSERT_EQUALS( itPage->mIsDirty(), true );
+
+            // Only the changed block is written
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 10 );
+            TS_ASSERT_EQUALS( itPage->mIsDirty(), false );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+
+            string strData = readTestFile();
+            TS_ASSERT_EQUALS( strData.size(), 11000 );
+            TS_ASSERT_EQUALS( strData.substr( 520, 10 ), "FFFFFzFFFF" );
+            TS_ASSERT_EQUALS( strData.substr( 510, 10 ), string( 10, 'F' ) );
+
+            // Grow the 101st page, only it and the pages after it are written
+            itPage = pageBuffer.pageList.begin();
+            std::advance( itPage, 100 );
+            itBlock = itPage->mFirst();
+            TS_ASSERT_EQUALS( itPage->mInsertBytes( itBlock, STR("++"), Attributes(1) ), 2 );
+
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 1002 );
+            strData = readTestFile();
+            TS_ASSERT_EQUALS( strData.size(), 11002 );
+            TS_ASSERT_EQUALS( strData.substr( 10000, 4 ), "++" + string( 2, 'A' + ( 100 % 26 ) ) );
+            TS_ASSERT_EQUALS( strData.substr( 10902, 100 ), string( 100, 'A' + ( 109 % 26 ) ) );
+
+            // Removing the last page truncates the file without writing anything
+            pageBuffer.pageList.pop_back();
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 0 );
+            TS_ASSERT_EQUALS( readTestFile().size(), 10902 );
+
+            // The file no longer matches what we saved, so everything is written
+            TS_ASSERT_EQUALS( ioHandle->mTruncate( 0 ), true );
+            TS_ASSERT_EQUALS( pageBuffer.mSave( file, true ), 10902 );
+            TS_ASSERT_EQUALS( readTestFile().substr( 520, 10 ), "FFFFFzFFFF" );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+
+            delete file;
+            unlink( TEST_FILE );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPageBufferSaveAs( void ) {
+            PageBuffer pageBuffer( 50 );
+            string strCopy = TEST_FILE ".copy";
 
+            // 110 pages of 10 blocks each
+            for( int i = 0 ; i < 110 ; ++i ) {
+                pageBuffer.mAppendPage( createDataPage( 'A' + ( i % 26 ) ) );
+            }
+
+            close( open( TEST_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0644 ) );
+            close( open( strCopy.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644 ) );
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadWrite ), true );
+            File* file = new Utf8File( ioHandle );
+
+            // Without an original everything is written from memory
+            TS_ASSERT_EQUALS( pageBuffer.mSaveAs( file, 0 ), 11000 );
+            delete file;
+
+            // Grow the 6th page and change a byte in the 51st
+            boost::ptr_list<Page>::iterator itPage = pageBuffer.pageList.begin();
+            std::advance( itPage, 5 );
+            Block::Iterator itBlock = itPage->mFirst();
+            TS_ASSERT_EQUALS( itPage->mInsertBytes( itBlock, STR("++"), Attributes(1) ), 2 );
+
+            std::advance( itPage, 45 );
+            itBlock = itPage->mFirst();
+            delete itPage->mDeleteBytes( itBlock, 1 );
+            TS_ASSERT_EQUALS( itPage->mInsertBytes( itBlock, STR("z"), Attributes(1) ), 1 );
+
+            // Remove the last page
+            pageBuffer.pageList.pop_back();
+
+            IOHandle* ioOriginal = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioOriginal->mOpen( TEST_FILE, IOHandle::ReadOnly ), true );
+
+            ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( strCopy, IOHandle::ReadWrite ), true );
+            file = new Utf8File( ioHandle );
+
+            TS_ASSERT_EQUALS( pageBuffer.mSaveAs( file, ioOriginal ), 10902 );
+            TS_ASSERT_EQUALS( file->mGetError(), "" );
+            delete file;
+            delete ioOriginal;
+
+            // Build what we expect the copy to hold
+            string strExpected;
+            for( int i = 0 ; i < 109 ; ++i ) {
+                if( i == 5 ) strExpected += "++";
+                if( i == 50 ) {
+                    strExpected += "z" + string( 99, 'A' + ( i % 26 ) );
+                    continue;
+                }
+                strExpected += string( 100, 'A' + ( i % 26 ) );
+            }
+
+            ifstream ioFile( strCopy.c_str() );
+            stringstream strContents;
+            strContents << ioFile.rdbuf();
+            TS_ASSERT( strContents.str() == strExpected );
+            TS_ASSERT_EQUALS( strContents.str().size(), 10902 );
+
+            // The pages now belong to the copy
+            TS_ASSERT_EQUALS( pageBuffer.pageList.begin()->mIsDirty(), false );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mFileOffSet(), 10802 );
+
+            unlink( TEST_FILE );
+            unlink( strCopy.c_str() );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPageBufferFollow( void ) {
+            PageBuffer pageBuffer( 50 );
+
+            ofstream ioOut( TEST_FILE, ios::out | ios::trunc );
+            ioOut << string( 120, 'A' );
+            ioOut.flush();
+
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadOnly ), true );
+            File* file = new Utf8File( ioHandle );
+            file->mSetBlockSize( 10 );
+
+            TS_ASSERT_EQUALS( file->mFollow(), true );
+            TS_ASSERT_EQUALS( file->mIsFollowing(), true );
+
+            // The initial load, 120 bytes in pages of 50
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 120 );
+            TS_ASSERT_EQUALS( pageBuffer.mCount(), 3 );
+            TS_ASSERT_EQUALS( pageBuffer._offSavedSize, 120 );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mIsInPlace( 100 ), true );
+
+            // Nothing was appended yet
+            TS_ASSERT_EQUALS( file->mWaitForAppend( 0 ), 1 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 0 );
+
+            // Only the appended bytes are read
+            ioOut << string( 35, 'B' );
+            ioOut.flush();
+            TS_ASSERT_EQUALS( file->mWaitForAppend( 1 ), 0 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 35 );
+            TS_ASSERT_EQUALS( pageBuffer.mCount(), 4 );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mOffSet(), 120 );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mIsInPlace( 120 ), true );
+            TS_ASSERT_EQUALS( pageBuffer._offSavedSize, 155 );
+
+            Page::Iterator it = pageBuffer.mFirst();
+            TS_ASSERT_EQUALS( pageBuffer.mNext( it, 115 ), 115 );
+            TS_ASSERT_EQUALS( pageBuffer.mByteArray( it, 10 ), "AAAAABBBBB" );
+
+            // A sequence the writer has not finished waits for the rest
+            ioOut << "caf\xc3";
+            ioOut.flush();
+            TS_ASSERT_EQUALS( file->mWaitForAppend( 1 ), 0 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 3 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 0 );
+
+            ioOut << "\xa9";
+            ioOut.flush();
+            TS_ASSERT_EQUALS( file->mWaitForAppend( 1 ), 0 );
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 2 );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mLast()->mBytes(), "\xc3\xa9" );
+
+            it = pageBuffer.mFirst();
+            TS_ASSERT_EQUALS( pageBuffer.mNext( it, 155 ), 155 );
+            TS_ASSERT_EQUALS( pageBuffer.mByteArray( it, 5 ), "caf\xc3\xa9" );
+
+            // Truncating the file is reported
+            ioOut.close();
+            TS_ASSERT_EQUALS( truncate( TEST_FILE, 10 ), 0 );
+            TS_ASSERT_EQUALS( file->mWaitForAppend( 1 ), -1 );
+            TS_ASSERT_EQUALS( file->mGetError(), "IO Error: '" TEST_FILE "' was truncated" );
+
+            delete file;
+            unlink( TEST_FILE );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPageBufferSizing( void ) {
+            OffSet offPage = 0;
+            OffSet offBlock = 0;
+
+            // Small files keep the default sizes
+            PageBuffer::mSizeFor( 100000, 4096, offPage, offBlock );
+            TS_ASSERT_EQUALS( offPage, DEFAULT_PAGE_SIZE );
+            TS_ASSERT_EQUALS( offBlock, DEFAULT_BLOCK_SIZE );
+
+            // Huge files are capped and read in whole device blocks
+            PageBuffer::mSizeFor( 64LL * 1024 * 1024 * 1024, 4096, offPage, offBlock );
+            TS_ASSERT_EQUALS( offPage, DEFAULT_MAX_PAGE_SIZE );
+            TS_ASSERT_EQUALS( offBlock, 262144 );
+            TS_ASSERT_EQUALS( offPage % offBlock, 0 );
+
+            ofstream ioOut( TEST_FILE, ios::out | ios::trunc );
+            ioOut << string( 10000000, 'A' );
+            ioOut.close();
+
+            PageBuffer pageBuffer;
+            IOHandle* ioHandle = IOHandle::mGetDefaultIOHandler();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadOnly ), true );
+            File* file = new Utf8File( ioHandle );
+
+            // The file chooses pages larger than the default
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), 10000000 );
+            TS_ASSERT_EQUALS( pageBuffer._offTargetPageSize, 4000 );
+            TS_ASSERT_EQUALS( pageBuffer.mCount() <= 2500, true );
+
+            // Existing pages are only re-chunked when edited
+            int intCount = pageBuffer.mCount();
+            OffSet offLast = pageBuffer.pageList.back().mSize();
+            pageBuffer.mSetTargetPageSize( 1000 );
+            TS_ASSERT_EQUALS( pageBuffer._offTargetPageSize, 1000 );
+            Page::Iterator it = pageBuffer.mFirst();
+            TS_ASSERT_EQUALS( pageBuffer.mInsertBytes( it, STR("B"), Attributes() ), 1 );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.begin()->mSize() <= 2000, true );
+            TS_ASSERT_EQUALS( pageBuffer.pageList.back().mSize(), offLast );
+            TS_ASSERT_EQUALS( pageBuffer.mCount() > intCount, true );
+
+            it = pageBuffer.mFirst();
+            TS_ASSERT_EQUALS( pageBuffer.mByteArray( it, 3 ), "BAA" );
+
+            delete file;
+            unlink( TEST_FILE );
+        }
+
+        // --------------------------------
+        // --------------------------------
+        void testPageBufferMappedLoad( void ) {
+            string strData;
+            for( int i = 0 ; i < 500 ; ++i ) strData += "AAAABBBBCCCC caf\xc3\xa9\n";
+
+            ofstream ioOut( TEST_FILE, ios::out | ios::trunc );
+            ioOut << strData;
+            ioOut.close();
+
+            // Mapped handles load through mMapNextBlock()
+            PageBuffer pageBuffer( 500 );
+            IOHandle* ioHandle = new MmapIOHandle();
+            TS_ASSERT_EQUALS( ioHandle->mOpen( TEST_FILE, IOHandle::ReadOnly ), true );
+            Utf8File* file = new Utf8File( ioHandle );
+            file->mSetBlockSize( 101 );
+            TS_ASSERT_EQUALS( file->mOffersMap(), true );
+
+            TS_ASSERT_EQUALS( pageBuffer.mAppendFile( file ), OffSet( strData.size() ) );
+            TS_ASSERT_EQUALS( pageBuffer._offSavedSize, OffSet( strData.size() ) );
+
+            Page::Iterator it = pageBuffer.mFirst();
+            TS_ASSERT( pageBuffer.mByteArray( it, strData.size() ).str() == strData );
+
+            // Blocks end on code points
+            Block::Iterator itBlock = pageBuffer.pageList.begin()->mFirst();
+            TS_ASSERT( itBlock->mAttributes().mHasFlag( Attributes::Utf8Validated ) );
+
+            // Normalizing needs the bytes copied
+            file->mSetNormalize( true );
+            TS_ASSERT_EQUALS( file->mOffersMap(), false );
+
+            delete file;
+            unlink( TEST_FILE );
+        }
+
+};
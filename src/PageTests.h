@@ -85,6 +85,69 @@ class PageTests : public CxxTest::TestSuite
 
         }
 
+        // --------------------------------
+        // Edits clear the flags a File set that no longer hold
+        // --------------------------------
+        void testBlockFlags( void ) {
+            Attributes attr( 1 );
+            attr.mSetFlag( Attributes::Utf8Validated, true );
+
+            BlockPtr block( new Block( STR("AAAA caf\xc3\xa9 BBBB"), attr ) );
+            TS_ASSERT( block->mAttributes() == Attributes( 1 ) );
+
+            // Cut on code points the bytes are still valid
+            BlockPtr newBlock( block->mDeleteBytes( 0, 5 ) );
+            TS_ASSERT( newBlock->mAttributes().mHasFlag( Attributes::Utf8Validated ) );
+            TS_ASSERT( block->mAttributes().mHasFlag( Attributes::Utf8Validated ) );
+
+            // Cutting a sequence in two is not
+            newBlock.reset( block->mDeleteBytes( 4, 1 ) );
+            TS_ASSERT( ! block->mAttributes().mHasFlag( Attributes::Utf8Validated ) );
+
+            // Inserted bytes were never validated
+            block.reset( new Block( STR("AAAA"), attr ) );
+            block->mInsertBytes( 2, STR("\xff") );
+            TS_ASSERT( ! block->mAttributes().mHasFlag( Attributes::Utf8Validated ) );
+            TS_ASSERT( block->mAttributes() == Attributes( 1 ) );
+        }
+
+        // --------------------------------
+        // Sub strings share the bytes until they are written
+        // --------------------------------
+        void testByteArraySlices( void ) {
+            ByteArray arrBytes( "AAAAABBBBBCCCCC" );
+
+            ByteArray arrSlice = arrBytes.mSubStr( 5, 5 );
+            TS_ASSERT_EQUALS( arrSlice, "BBBBB" );
+            TS_ASSERT( arrSlice.mData() == arrBytes.mData() + 5 );
+
+            // Past the end is clipped
+            TS_ASSERT_EQUALS( arrBytes.mSubStr( 10, nPos ), "CCCCC" );
+            TS_ASSERT_EQUALS( arrBytes.mSubStr( 20, 5 ).mIsEmpty(), true );
+
+            // Erasing the start or the end does not copy
+            ByteArray arrCopy = arrBytes;
+            arrCopy.mErase( 0, 5 );
+            arrCopy.mErase( 5, nPos );
+            TS_ASSERT_EQUALS( arrCopy, "BBBBB" );
+            TS_ASSERT( arrCopy.mData() == arrSlice.mData() );
+
+            // Writing a shared slice copies it, the others are unchanged
+            arrSlice.mInsert( 0, STR("11111") );
+            TS_ASSERT_EQUALS( arrSlice, "11111BBBBB" );
+            arrCopy.mErase( 1, 3 );
+            TS_ASSERT_EQUALS( arrCopy, "BB" );
+            TS_ASSERT_EQUALS( arrBytes, "AAAAABBBBBCCCCC" );
+
+            // Splitting a block shares the bytes with the new block
+            BlockPtr block( new Block( arrBytes ) );
+            BlockPtr newBlock( block->mDeleteBytes( 0, 5 ) );
+            TS_ASSERT_EQUALS( newBlock->mBytes(), "AAAAA" );
+            TS_ASSERT_EQUALS( block->mBytes(), "BBBBBCCCCC" );
+            TS_ASSERT( block->mBytes().mData() == arrBytes.mData() + 5 );
+            TS_ASSERT( newBlock->mBytes().mData() == arrBytes.mData() );
+        }
+
         // --------------------------------
         // Create an block
         // TODO: Add tests to verify attributes in blocks
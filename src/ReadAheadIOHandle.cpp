@@ -0,0 +1,485 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#include <ReadAheadIOHandle.h>
+
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+
+// The number of back to back reads before we start prefetching
+#define READAHEAD_TRIGGER   2
+
+/*!
+ * ReadAheadIOHandle Constructor
+ */
+ReadAheadIOHandle::ReadAheadIOHandle( IOHandle* ioHandle, int intBlocks, OffSet offBlockSize )
+                : _ioHandle( ioHandle ), _vecSlots( intBlocks ), _offBlockSize( offBlockSize ),
+                  _offPosition(0), _offLastRead(0), _offFetch(0), _offHits(0), _intSequential(0),
+                  _intGeneration(0), _boolStop(false), _boolThread(false), _boolOpen(false) {
+
+    assert( ioHandle != 0 );
+    assert( intBlocks > 0 );
+
+    pthread_mutex_init( &_mutex, 0 );
+    pthread_mutex_init( &_mutexIO, 0 );
+    pthread_cond_init( &_condWork, 0 );
+    pthread_cond_init( &_condDone, 0 );
+
+    // One contiguous allocation for the entire ring
+    _arrData = new char[ intBlocks * offBlockSize ];
+    for( int i = 0 ; i < intBlocks ; ++i ) {
+        _vecSlots[i].arrData = _arrData + ( i * offBlockSize );
+    }
+}
+
+/*!
+ * ReadAheadIOHandle Destructor
+ */
+ReadAheadIOHandle::~ReadAheadIOHandle() {
+
+    // Stop the prefetch thread before freeing the ring
+    mClose();
+    delete _ioHandle;
+    delete[] _arrData;
+
+    pthread_cond_destroy( &_condDone );
+    pthread_cond_destroy( &_condWork );
+    pthread_mutex_destroy( &_mutexIO );
+    pthread_mutex_destroy( &_mutex );
+}
+
+/*!
+ * Open the wrapped handle and start the prefetch thread
+ */
+bool ReadAheadIOHandle::mOpen( const char* strFileName, OpenMode mode ) {
+
+    if( _boolOpen ) { mClose(); }
+
+    if( ! _ioHandle->mOpen( strFileName, mode ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    _boolOpen = true;
+
+    _strName        = _ioHandle->mGetName();
+    _offFileSize    = _ioHandle->mGetFileSize();
+    _offDeviceBlock = _ioHandle->mGetDeviceBlockSize();
+    _ioFile         = _ioHandle->_ioFile;
+    _offPosition    = 0;
+    _offLastRead    = 0;
+    _offFetch       = 0;
+    _offHits        = 0;
+    _intSequential  = 0;
+    mInvalidate();
+
+    // Without seek we can not read ahead of the caller
+    if( _ioHandle->mOffersSeek() ) {
+        _boolStop = false;
+        if( pthread_create( &_thread, 0, &ReadAheadIOHandle::mWorker, this ) == 0 ) {
+            _boolThread = true;
+        }
+        // Without the thread every read goes straight to the wrapped handle
+    }
+
+    return true;
+}
+
+/*!
+ * Stop the prefetch thread, then close the wrapped handle
+ */
+bool ReadAheadIOHandle::mClose( void ) {
+
+    if( _boolThread ) {
+        pthread_mutex_lock( &_mutex );
+        _boolStop = true;
+        pthread_cond_broadcast( &_condWork );
+        pthread_mutex_unlock( &_mutex );
+
+        pthread_join( _thread, 0 );
+        _boolThread = false;
+    }
+
+    for( size_t i = 0 ; i < _vecSlots.size() ; ++i ) {
+        _vecSlots[i].intState = ReadAheadSlot::Free;
+    }
+
+    _ioFile = 0;
+    _boolOpen = false;
+    if( ! _ioHandle->mClose() ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    return true;
+}
+
+bool ReadAheadIOHandle::mIsPrefetching( void ) {
+    pthread_mutex_lock( &_mutex );
+    bool boolResult = _boolThread and _intSequential >= READAHEAD_TRIGGER;
+    pthread_mutex_unlock( &_mutex );
+    return boolResult;
+}
+
+/*!
+ * Discard every prefetched block, blocks the thread is still 
+ * filling are discarded when they complete.
+ * Must be called with the mutex held
+ */
+void ReadAheadIOHandle::mInvalidate( void ) {
+    ++_intGeneration;
+    for( size_t i = 0 ; i < _vecSlots.size() ; ++i ) {
+        if( _vecSlots[i].intState == ReadAheadSlot::Ready ) {
+            _vecSlots[i].intState = ReadAheadSlot::Free;
+        }
+    }
+    pthread_cond_broadcast( &_condWork );
+}
+
+/*!
+ * Free the blocks that are behind the current position.
+ * Must be called with the mutex held
+ */
+void ReadAheadIOHandle::mRecycle( void ) {
+    for( size_t i = 0 ; i < _vecSlots.size() ; ++i ) {
+        ReadAheadSlot* slot = &_vecSlots[i];
+        if( slot->intState != ReadAheadSlot::Ready ) continue;
+
+        if( slot->offOffSet + slot->offSize <= _offPosition ) {
+            slot->intState = ReadAheadSlot::Free;
+            pthread_cond_broadcast( &_condWork );
+        }
+    }
+}
+
+/*!
+ * Return the current block that holds, or will hold, the data at offset.
+ * Must be called with the mutex held
+ */
+ReadAheadSlot* ReadAheadIOHandle::mFindSlot( OffSet offset ) {
+    for( size_t i = 0 ; i < _vecSlots.size() ; ++i ) {
+        ReadAheadSlot* slot = &_vecSlots[i];
+        if( slot->intState == ReadAheadSlot::Free ) continue;
+        if( slot->intGeneration != _intGeneration ) continue;
+        if( slot->offOffSet <= offset and offset < slot->offOffSet + slot->offSize ) return slot;
+    }
+    return 0;
+}
+
+/*!
+ * The prefetch thread, fills free slots with the blocks
+ * following the reader while the reads are sequential
+ */
+void* ReadAheadIOHandle::mWorker( void* ptrHandle ) {
+    ReadAheadIOHandle* handle = static_cast<ReadAheadIOHandle*>( ptrHandle );
+    OffSet offRing = handle->_vecSlots.size() * handle->_offBlockSize;
+
+    pthread_mutex_lock( &handle->_mutex );
+    while( true ) {
+        ReadAheadSlot* slot = 0;
+
+        while( ! handle->_boolStop ) {
+            if( handle->_intSequential >= READAHEAD_TRIGGER and handle->_offFetch < handle->_offFileSize ) {
+                for( size_t i = 0 ; i < handle->_vecSlots.size() ; ++i ) {
+                    if( handle->_vecSlots[i].intState == ReadAheadSlot::Free ) {
+                        slot = &handle->_vecSlots[i];
+                        break;
+                    }
+                }
+                if( slot ) break;
+            }
+            pthread_cond_wait( &handle->_condWork, &handle->_mutex );
+        }
+        if( handle->_boolStop ) break;
+
+        OffSet offOffSet = handle->_offFetch;
+        OffSet offSize = handle->_offBlockSize;
+        if( offOffSet + offSize > handle->_offFileSize ) offSize = handle->_offFileSize - offOffSet;
+
+        slot->offOffSet     = offOffSet;
+        slot->offSize       = offSize;
+        slot->intGeneration = handle->_intGeneration;
+        slot->intState      = ReadAheadSlot::Filling;
+        handle->_offFetch  += offSize;
+        pthread_mutex_unlock( &handle->_mutex );
+
+        // Once per ring, ask the kernel to start reading the ring after this one
+        if( handle->_ioFile > 0 and ( offOffSet % offRing ) < handle->_offBlockSize ) {
+            posix_fadvise( handle->_ioFile, offOffSet + offRing, offRing, POSIX_FADV_WILLNEED );
+        }
+
+        pthread_mutex_lock( &handle->_mutexIO );
+        OffSet offLen = handle->_ioHandle->mSeek( offOffSet );
+        if( offLen != -1 ) offLen = handle->_ioHandle->mRead( slot->arrData, offSize );
+        pthread_mutex_unlock( &handle->_mutexIO );
+
+        pthread_mutex_lock( &handle->_mutex );
+        if( slot->intGeneration != handle->_intGeneration or offLen <= 0 ) {
+            slot->intState = ReadAheadSlot::Free;
+            // Stop prefetching after an error
+            if( offLen < 0 and slot->intGeneration == handle->_intGeneration ) handle->_intSequential = 0;
+        } else {
+            slot->offSize = offLen;
+            slot->intState = ReadAheadSlot::Ready;
+        }
+        pthread_cond_broadcast( &handle->_condDone );
+    }
+    pthread_mutex_unlock( &handle->_mutex );
+    return 0;
+}
+
+/*!
+ * Read straight from the wrapped handle
+ */
+OffSet ReadAheadIOHandle::mReadDirect( OffSet offset, char* cstrBuffer, OffSet offSize ) {
+    OffSet offVal = 0;
+
+    pthread_mutex_lock( &_mutexIO );
+    if( ( offVal = _ioHandle->mSeek( offset ) ) != -1 ) {
+        offVal = _ioHandle->mRead( cstrBuffer, offSize );
+    }
+    if( offVal < 0 ) mSetError( _ioHandle->mGetError() );
+    pthread_mutex_unlock( &_mutexIO );
+
+    return offVal;
+}
+
+/*!
+ * Return 0 if the read will not block, if the block is
+ * not prefetched ask the wrapped handle
+ */
+int ReadAheadIOHandle::mWaitForClearToRead( int intSeconds ) {
+
+    pthread_mutex_lock( &_mutex );
+    ReadAheadSlot* slot = mFindSlot( _offPosition );
+    pthread_mutex_unlock( &_mutex );
+
+    if( slot ) return 0;
+
+    pthread_mutex_lock( &_mutexIO );
+    int intVal = _ioHandle->mWaitForClearToRead( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    pthread_mutex_unlock( &_mutexIO );
+
+    return intVal;
+}
+
+int ReadAheadIOHandle::mWaitForClearToWrite( int intSeconds ) {
+
+    pthread_mutex_lock( &_mutexIO );
+    int intVal = _ioHandle->mWaitForClearToWrite( intSeconds );
+    if( intVal ) mSetError( _ioHandle->mGetError() );
+    pthread_mutex_unlock( &_mutexIO );
+
+    return intVal;
+}
+
+/*!
+ * Seek to a location in the file, the prefetched blocks
+ * are kept until the next read decides if it is sequential
+ */
+OffSet ReadAheadIOHandle::mSeek( OffSet offset ) {
+
+    if( offset < 0 ) {
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    // Streams can not seek, let the wrapped handle report the error
+    if( ! _boolThread ) {
+        pthread_mutex_lock( &_mutexIO );
+        OffSet offVal = _ioHandle->mSeek( offset );
+        if( offVal == -1 ) mSetError( _ioHandle->mGetError() );
+        pthread_mutex_unlock( &_mutexIO );
+        if( offVal == -1 ) return -1;
+    }
+
+    pthread_mutex_lock( &_mutex );
+    _offPosition = offset;
+    pthread_mutex_unlock( &_mutex );
+
+    return offset;
+}
+
+/*!
+ * Copy data out of the prefetched blocks, reading from the
+ * wrapped handle when the data has not been prefetched
+ */
+OffSet ReadAheadIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    // Without the thread we are a simple pass through
+    if( ! _boolThread ) {
+        OffSet offVal = _ioHandle->mRead( cstrBuffer, offSize );
+        if( offVal < 0 ) mSetError( _ioHandle->mGetError() );
+        return offVal;
+    }
+
+    pthread_mutex_lock( &_mutex );
+
+    // A read that does not continue where the last one left off is not sequential
+    if( _offPosition != _offLastRead ) {
+        mInvalidate();
+        _intSequential = 0;
+        _offFetch = _offPosition;
+    }
+    if( _intSequential < READAHEAD_TRIGGER ) {
+        if( ++_intSequential == READAHEAD_TRIGGER and _ioFile > 0 ) {
+            posix_fadvise( _ioFile, 0, 0, POSIX_FADV_SEQUENTIAL );
+        }
+    }
+    mRecycle();
+
+    // Wake the thread to fetch the blocks after this read
+    if( _intSequential >= READAHEAD_TRIGGER ) {
+        if( _offFetch < _offPosition ) _offFetch = _offPosition;
+        pthread_cond_broadcast( &_condWork );
+    }
+
+    while( offTotal < offSize ) {
+        ReadAheadSlot* slot = mFindSlot( _offPosition );
+
+        // Not prefetched, read the rest from the wrapped handle
+        if( ! slot ) {
+            // Avoid the syscall if we already know we are at the end of the file
+            if( offTotal and _offPosition >= _offFileSize ) break;
+
+            OffSet offPosition = _offPosition;
+            pthread_mutex_unlock( &_mutex );
+            OffSet offLen = mReadDirect( offPosition, cstrBuffer + offTotal, offSize - offTotal );
+            pthread_mutex_lock( &_mutex );
+
+            if( offLen < 0 ) {
+                pthread_mutex_unlock( &_mutex );
+                return -1;
+            }
+            _offPosition += offLen;
+            offTotal += offLen;
+            if( _offFetch < _offPosition ) _offFetch = _offPosition;
+            break;
+        }
+
+        // The thread is still reading this block
+        if( slot->intState == ReadAheadSlot::Filling ) {
+            pthread_cond_wait( &_condDone, &_mutex );
+            continue;
+        }
+
+        OffSet offEnd = slot->offOffSet + slot->offSize;
+        OffSet offLen = offEnd - _offPosition;
+        if( offLen > offSize - offTotal ) offLen = offSize - offTotal;
+
+        memcpy( cstrBuffer + offTotal, slot->arrData + ( _offPosition - slot->offOffSet ), offLen );
+        _offPosition += offLen;
+        offTotal += offLen;
+        ++_offHits;
+
+        // Consumed the entire block, the thread can refill it
+        if( _offPosition >= offEnd ) {
+            slot->intState = ReadAheadSlot::Free;
+            pthread_cond_broadcast( &_condWork );
+        }
+    }
+
+    _offLastRead = _offPosition;
+    pthread_mutex_unlock( &_mutex );
+
+    return offTotal;
+}
+
+/*!
+ * Writes through to the wrapped handle, discarding the prefetched blocks
+ */
+OffSet ReadAheadIOHandle::mWrite( const char* cstrBuffer, OffSet offSize ) {
+    struct iovec iov;
+
+    iov.iov_base = const_cast<char*>( cstrBuffer );
+    iov.iov_len = offSize;
+
+    // Keep the single write a single write() on the wrapped handle
+    if( ! _boolThread ) {
+        OffSet offVal = _ioHandle->mWrite( cstrBuffer, offSize );
+        if( offVal < 0 ) mSetError( _ioHandle->mGetError() );
+        return offVal;
+    }
+
+    return mWriteV( &iov, 1 );
+}
+
+/*!
+ * Writes all the buffers through to the wrapped handle,
+ * discarding the prefetched blocks
+ */
+OffSet ReadAheadIOHandle::mWriteV( const struct iovec* arrIov, int intCount ) {
+    OffSet offVal = 0;
+
+    pthread_mutex_lock( &_mutex );
+    mInvalidate();
+    _intSequential = 0;
+    _offLastRead = -1;
+    OffSet offPosition = _offPosition;
+    pthread_mutex_unlock( &_mutex );
+
+    pthread_mutex_lock( &_mutexIO );
+    if( _boolThread ) offVal = _ioHandle->mSeek( offPosition );
+    if( offVal != -1 ) {
+        if( intCount == 1 ) {
+            offVal = _ioHandle->mWrite( static_cast<const char*>( arrIov[0].iov_base ), arrIov[0].iov_len );
+        } else {
+            offVal = _ioHandle->mWriteV( arrIov, intCount );
+        }
+    }
+    if( offVal < 0 ) mSetError( _ioHandle->mGetError() );
+    pthread_mutex_unlock( &_mutexIO );
+
+    if( offVal < 0 ) return -1;
+
+    pthread_mutex_lock( &_mutex );
+    _offPosition = offPosition + offVal;
+    if( _offPosition > _offFileSize ) _offFileSize = _offPosition;
+    pthread_mutex_unlock( &_mutex );
+
+    return offVal;
+}
+
+/*!
+ * Truncates the wrapped handle, discarding the prefetched blocks
+ */
+bool ReadAheadIOHandle::mTruncate( OffSet offset ) {
+
+    pthread_mutex_lock( &_mutex );
+    mInvalidate();
+    _intSequential = 0;
+    _offLastRead = -1;
+    pthread_mutex_unlock( &_mutex );
+
+    pthread_mutex_lock( &_mutexIO );
+    bool boolResult = _ioHandle->mTruncate( offset );
+    if( ! boolResult ) mSetError( _ioHandle->mGetError() );
+    pthread_mutex_unlock( &_mutexIO );
+
+    if( ! boolResult ) return false;
+
+    pthread_mutex_lock( &_mutex );
+    _offFileSize = offset;
+    pthread_mutex_unlock( &_mutex );
+
+    return true;
+}
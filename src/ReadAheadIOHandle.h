@@ -0,0 +1,111 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#ifndef READAHEADIOHANDLE_INCLUDE_H
+#define READAHEADIOHANDLE_INCLUDE_H
+
+#include <IOHandle.h>
+#include <pthread.h>
+#include <vector>
+
+/*!
+ * A single block held in the read ahead ring
+ */
+struct ReadAheadSlot {
+
+    // Filling is owned by the prefetch thread until it completes
+    enum State { Free, Filling, Ready };
+
+    ReadAheadSlot( void ) : offOffSet(0), offSize(0), arrData(0), intState(Free), intGeneration(0) { }
+
+    OffSet  offOffSet;
+    OffSet  offSize;
+    char*   arrData;
+    int     intState;
+    // The ring generation the slot was filled for
+    int     intGeneration;
+};
+
+/*!
+ *  A Class that wraps another IOHandle and prefetches the blocks
+ *  ahead of the reader on a background thread once the reads look
+ *  sequential. Any seek away from the read position, write or
+ *  truncate discards the prefetched blocks.
+ *
+ *  The wrapped handle is owned and deleted by this handle
+ */
+class ReadAheadIOHandle : public IOHandle {
+    public:
+        ReadAheadIOHandle( IOHandle*, int intBlocks = DEFAULT_READAHEAD_BLOCKS,
+                           OffSet offBlockSize = DEFAULT_BLOCK_SIZE );
+        virtual ~ReadAheadIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return _ioHandle->mOffersLargeFileSupport(); }
+        virtual bool    mOffersSeek( void ) { return _ioHandle->mOffersSeek(); }
+        virtual int     mWaitForClearToRead( int );
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual IOStats& mGetStats( void ) { return _ioHandle->mGetStats(); }
+        virtual OffSet  mWriteV( const struct iovec*, int );
+
+        //! Returns true if the reads look sequential and we are prefetching
+        bool            mIsPrefetching( void );
+        //! The number of reads that were copied out of the ring
+        OffSet          mGetHits( void ) { return _offHits; }
+
+        static void*    mWorker( void* );
+        void            mInvalidate( void );
+        void            mRecycle( void );
+        ReadAheadSlot*  mFindSlot( OffSet );
+        OffSet          mReadDirect( OffSet, char*, OffSet );
+
+        IOHandle*                   _ioHandle;
+        std::vector<ReadAheadSlot>  _vecSlots;
+        char*                       _arrData;
+        OffSet                      _offBlockSize;
+        OffSet                      _offPosition;
+        // Where the last read ended, a read starting here is sequential
+        OffSet                      _offLastRead;
+        // The next offset the prefetch thread will read
+        OffSet                      _offFetch;
+        OffSet                      _offHits;
+        int                         _intSequential;
+        int                         _intGeneration;
+        bool                        _boolStop;
+        bool                        _boolThread;
+        // The wrapped handle is open, _ioFile is 0 for handles without a descriptor
+        bool                        _boolOpen;
+        pthread_t                   _thread;
+        // Protects everything above
+        pthread_mutex_t             _mutex;
+        // Serializes access to the wrapped handle
+        pthread_mutex_t             _mutexIO;
+        pthread_cond_t              _condWork;
+        pthread_cond_t              _condDone;
+};
+
+#endif // READAHEADIOHANDLE_INCLUDE_H
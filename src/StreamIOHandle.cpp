@@ -0,0 +1,294 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#include <StreamIOHandle.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+
+// The most we read from the stream at once
+#define STREAM_CHUNK_SIZE   65536
+
+/*!
+ * StreamIOHandle Constructor
+ */
+StreamIOHandle::StreamIOHandle( OffSet offSpillSize ) : _ioStream( new PosixIOHandle() ), _offSpillSize( offSpillSize ),
+                                                         _offPosition(0), _ioSpill(-1), _boolComplete(false), 
+                                                         _boolOpen(false) { }
+
+/*!
+ * StreamIOHandle Destructor
+ */
+StreamIOHandle::~StreamIOHandle() {
+
+    mClose();
+    delete _ioStream;
+
+}
+
+/*!
+ * Open the stream, "-" opens stdin. Only ReadOnly is supported,
+ * the data received can not be changed
+ */
+bool StreamIOHandle::mOpen( const char* strFileName, OpenMode mode ) {
+
+    if( _boolOpen ) { mClose(); }
+
+    if( mode != ReadOnly ) {
+        mSetError() << "IO Error: Unable to open '" << strFileName << "' - streams can only be opened ReadOnly";
+        return false;
+    }
+
+    const char* strPath = strFileName;
+    if( strcmp( strFileName, "-" ) == 0 ) strPath = "/dev/stdin";
+
+    if( ! _ioStream->mOpen( strPath, mode ) ) {
+        mSetError( _ioStream->mGetError() );
+        return false;
+    }
+
+    _boolOpen       = true;
+    _strName        = strFileName;
+    _ioFile         = _ioStream->_ioFile;
+    _offFileSize    = 0;
+    _offPosition    = 0;
+    _boolComplete   = false;
+    _vecMemory.clear();
+
+    return true;
+}
+
+/*!
+ * Close the stream and throw away the data received
+ */
+bool StreamIOHandle::mClose( void ) {
+
+    if( _ioSpill != -1 ) {
+        close( _ioSpill );
+        _ioSpill = -1;
+    }
+    _vecMemory.clear();
+    _ioFile = 0;
+    _boolOpen = false;
+
+    if( ! _ioStream->mClose() ) {
+        mSetError( _ioStream->mGetError() );
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Move the data held in memory to an anonymous temp file
+ */
+bool StreamIOHandle::mSpill( void ) {
+    const char* strDir = getenv( "TMPDIR" );
+    if( ! strDir or ! *strDir ) strDir = "/tmp";
+
+#ifdef O_TMPFILE
+    _ioSpill = open( strDir, O_TMPFILE | O_RDWR, 0600 );
+#endif
+
+    // No O_TMPFILE, create a temp file and unlink it
+    if( _ioSpill == -1 ) {
+        std::string strTemp = std::string( strDir ) + "/OllieStreamXXXXXX";
+        std::vector<char> arrTemp( strTemp.begin(), strTemp.end() );
+        arrTemp.push_back( 0 );
+
+        if( ( _ioSpill = mkstemp( &arrTemp[0] ) ) == -1 ) {
+            mSetError() << "IO Error: Unable to create a temp file in '" << strDir << "' - " << strerror( errno );
+            return false;
+        }
+        unlink( &arrTemp[0] );
+    }
+
+    struct iovec iov;
+    iov.iov_base = &_vecMemory[0];
+    iov.iov_len = _vecMemory.size();
+
+    if( PosixIOHandle::mWriteAllV( _ioSpill, &iov, 1, 0 ) == -1 ) {
+        mSetError() << "IO Error: Unable to write to the temp file for '" << _strName << "' - " << strerror( errno );
+        close( _ioSpill );
+        _ioSpill = -1;
+        return false;
+    }
+
+    // Release the memory
+    std::vector<char>().swap( _vecMemory );
+    return true;
+}
+
+/*!
+ * Keep the data received from the stream
+ */
+bool StreamIOHandle::mStore( const char* arrData, OffSet offSize ) {
+
+    if( _ioSpill == -1 ) {
+        _vecMemory.insert( _vecMemory.end(), arrData, arrData + offSize );
+        if( (OffSet)_vecMemory.size() > _offSpillSize and ! mSpill() ) return false;
+    } else {
+        struct iovec iov;
+        iov.iov_base = const_cast<char*>( arrData );
+        iov.iov_len = offSize;
+
+        if( PosixIOHandle::mWriteAllV( _ioSpill, &iov, 1, _offFileSize ) == -1 ) {
+            mSetError() << "IO Error: Unable to write to the temp file for '" << _strName << "' - " << strerror( errno );
+            return false;
+        }
+    }
+
+    _offFileSize += offSize;
+    return true;
+}
+
+/*!
+ * Read a chunk from the stream, if boolWait is false only 
+ * read if the stream has data ready
+ * Returns the bytes received, 0 if nothing was ready or -1 on error
+ */
+OffSet StreamIOHandle::mReceiveChunk( bool boolWait ) {
+    char arrChunk[ STREAM_CHUNK_SIZE ];
+
+    if( _boolComplete ) return 0;
+
+    if( ! boolWait ) {
+        struct pollfd pfd;
+        pfd.fd = _ioFile;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if( poll( &pfd, 1, 0 ) <= 0 ) return 0;
+    }
+
+    OffSet offLen = _ioStream->mRead( arrChunk, STREAM_CHUNK_SIZE );
+    if( offLen < 0 ) {
+        mSetError( _ioStream->mGetError() );
+        return -1;
+    }
+
+    if( offLen == 0 ) {
+        _boolComplete = true;
+        return 0;
+    }
+
+    if( ! mStore( arrChunk, offLen ) ) return -1;
+    return offLen;
+}
+
+OffSet StreamIOHandle::mReceive( void ) {
+    OffSet offTotal = 0;
+    OffSet offLen = 0;
+
+    while( ( offLen = mReceiveChunk( false ) ) > 0 ) {
+        offTotal += offLen;
+    }
+    if( offLen < 0 ) return -1;
+
+    return offTotal;
+}
+
+/*!
+ * Return 0 if the read will not block
+ */
+int StreamIOHandle::mWaitForClearToRead( int intSeconds ) {
+
+    // We have the data, or there is no more coming
+    if( _offPosition < _offFileSize or _boolComplete ) return 0;
+
+    int intVal = _ioStream->mWaitForClearToRead( intSeconds );
+    if( intVal ) mSetError( _ioStream->mGetError() );
+    return intVal;
+}
+
+int StreamIOHandle::mWaitForClearToWrite( int ) {
+    mSetError() << "IO Error: '" << _strName << "' is a stream opened ReadOnly";
+    return -1;
+}
+
+/*!
+ * Seek to a location in the data, we wait for
+ * the stream if the location was not received yet
+ */
+OffSet StreamIOHandle::mSeek( OffSet offset ) {
+
+    if( offset < 0 ) {
+        mSetError() << "IO Error: Unable to seek to offset " << offset << " - " <<  strerror( EINVAL );
+        return -1;
+    }
+
+    while( offset > _offFileSize and ! _boolComplete ) {
+        if( mReceiveChunk( true ) < 0 ) return -1;
+    }
+
+    _offPosition = offset;
+    return _offPosition;
+}
+
+/*!
+ * Copy the data received at the current position, only
+ * waits on the stream if nothing has been received there yet
+ */
+OffSet StreamIOHandle::mRead( char* cstrBuffer, OffSet offSize ) {
+    OffSet offLen = 0;
+
+    // Wait for more data
+    while( _offPosition >= _offFileSize and ! _boolComplete ) {
+        if( mReceiveChunk( true ) < 0 ) return -1;
+    }
+
+    // Fill the rest of the read with what the stream has ready, but 
+    // never receive more than the read asked for
+    while( _offFileSize - _offPosition < offSize ) {
+        if( ( offLen = mReceiveChunk( false ) ) < 0 ) return -1;
+        if( offLen == 0 ) break;
+    }
+
+    if( _offPosition >= _offFileSize ) return 0;
+
+    offLen = _offFileSize - _offPosition;
+    if( offLen > offSize ) offLen = offSize;
+
+    if( _ioSpill == -1 ) {
+        memcpy( cstrBuffer, &_vecMemory[ _offPosition ], offLen );
+    } else {
+        while( ( offLen = pread( _ioSpill, cstrBuffer, offLen, _offPosition ) ) == -1 and errno == EINTR );
+        if( offLen == -1 ) {
+            mSetError() << "IO Error: Unable to read the temp file for '" << _strName << "' - " << strerror( errno );
+            return -1;
+        }
+    }
+
+    _offPosition += offLen;
+    return offLen;
+}
+
+OffSet StreamIOHandle::mWrite( const char*, OffSet ) {
+    mSetError() << "IO Error: '" << _strName << "' is a stream opened ReadOnly";
+    return -1;
+}
+
+bool StreamIOHandle::mTruncate( OffSet ) {
+    mSetError() << "IO Error: '" << _strName << "' is a stream opened ReadOnly";
+    return false;
+}
@@ -0,0 +1,77 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+
+#ifndef STREAMIOHANDLE_INCLUDE_H
+#define STREAMIOHANDLE_INCLUDE_H
+
+#include <IOHandle.h>
+#include <vector>
+
+/*!
+ *  A Class that reads a pipe, FIFO, socket or stdin ( "-" ) and keeps
+ *  everything it received, so the stream can be read and seeked like
+ *  a regular file. The data is held in memory until it grows past
+ *  the spill size, then it is moved to an anonymous temp file.
+ *
+ *  Reads return the data already received without waiting, and
+ *  only wait on the stream when there is nothing to return. 
+ *  mGetFileSize() is the number of bytes received so far.
+ */
+class StreamIOHandle : public IOHandle {
+    public:
+        StreamIOHandle( OffSet offSpillSize = DEFAULT_SPILL_SIZE );
+        virtual ~StreamIOHandle( void );
+
+        // Methods
+        virtual bool    mOpen( const char*, OpenMode mode );
+        virtual bool    mClose( void );
+        virtual bool    mOffersLargeFileSupport( void ) { return true; }
+        virtual bool    mOffersSeek( void ) { return true; }
+        virtual int     mWaitForClearToRead( int );
+        virtual int     mWaitForClearToWrite( int );
+        virtual bool    mTruncate( OffSet offset );
+        virtual OffSet  mSeek( OffSet );
+        virtual OffSet  mRead( char*, OffSet );
+        virtual OffSet  mWrite( const char*, OffSet );
+        virtual IOStats& mGetStats( void ) { return _ioStream->mGetStats(); }
+
+        //! Read what the stream has ready without waiting, returns the bytes received or -1 on error
+        OffSet          mReceive( void );
+        //! Has the stream reached the end of it's data?
+        bool            mIsComplete( void ) { return _boolComplete; }
+        //! Has the data spilled to a temp file?
+        bool            mIsSpilled( void ) { return _ioSpill != -1; }
+
+        OffSet          mReceiveChunk( bool );
+        bool            mStore( const char*, OffSet );
+        bool            mSpill( void );
+
+        PosixIOHandle*      _ioStream;
+        std::vector<char>   _vecMemory;
+        OffSet              _offSpillSize;
+        OffSet              _offPosition;
+        int                 _ioSpill;
+        bool                _boolComplete;
+        // The stream is open, the descriptor can be 0 when stdin was closed
+        bool                _boolOpen;
+};
+
+#endif // STREAMIOHANDLE_INCLUDE_H
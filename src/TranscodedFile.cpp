@@ -0,0 +1,565 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <File.h>
+#include <Utf8Validator.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The smallest block that holds any character and the bytes held back before it
+#define TRANSCODE_MIN_BLOCK     8
+
+/*!
+ * Write a code point as UTF-8, returns the bytes written
+ */
+static inline int encodeUtf8( unsigned int intCode, char* arrOut ) {
+
+    if( intCode < 0x80 ) {
+        arrOut[0] = intCode;
+        return 1;
+    }
+    if( intCode < 0x800 ) {
+        arrOut[0] = 0xC0 | ( intCode >> 6 );
+        arrOut[1] = 0x80 | ( intCode & 0x3F );
+        return 2;
+    }
+    if( intCode < 0x10000 ) {
+        arrOut[0] = 0xE0 | ( intCode >> 12 );
+        arrOut[1] = 0x80 | ( ( intCode >> 6 ) & 0x3F );
+        arrOut[2] = 0x80 | ( intCode & 0x3F );
+        return 3;
+    }
+    arrOut[0] = 0xF0 | ( intCode >> 18 );
+    arrOut[1] = 0x80 | ( ( intCode >> 12 ) & 0x3F );
+    arrOut[2] = 0x80 | ( ( intCode >> 6 ) & 0x3F );
+    arrOut[3] = 0x80 | ( intCode & 0x3F );
+    return 4;
+}
+
+/*!
+ * Read a UTF-8 sequence, returns the length of the 
+ * sequence or 0 if the sequence is not valid UTF-8
+ */
+static inline int decodeUtf8( const unsigned char* arrIn, OffSet offLeft, unsigned int& intCode ) {
+    unsigned char chByte = arrIn[0];
+    int intLen = 0;
+
+    if( chByte < 0x80 ) { intCode = chByte; return 1; }
+    else if( ( chByte & 0xE0 ) == 0xC0 ) { intLen = 2; intCode = chByte & 0x1F; }
+    else if( ( chByte & 0xF0 ) == 0xE0 ) { intLen = 3; intCode = chByte & 0x0F; }
+    else if( ( chByte & 0xF8 ) == 0xF0 ) { intLen = 4; intCode = chByte & 0x07; }
+    else return 0;
+
+    if( intLen > offLeft ) return 0;
+
+    for( int i = 1 ; i < intLen ; ++i ) {
+        if( ( arrIn[i] & 0xC0 ) != 0x80 ) return 0;
+        intCode = ( intCode << 6 ) | ( arrIn[i] & 0x3F );
+    }
+
+    // Overlong encodings, surrogates and code points past U+10FFFF
+    if( ( intLen == 2 and intCode < 0x80 ) or ( intLen == 3 and intCode < 0x800 ) or
+        ( intLen == 4 and intCode < 0x10000 ) or intCode > 0x10FFFF or
+        ( intCode >= 0xD800 and intCode <= 0xDFFF ) ) return 0;
+
+    return intLen;
+}
+
+/*!
+ * TranscodedFile Constructor
+ */
+TranscodedFile::TranscodedFile( IOHandle* const ioHandle ) : File( ioHandle ), _boolBom(false), 
+                                _boolStart(true), _boolEnd(false), _offWritten(0) { }
+
+/*!
+ * We do not know how many UTF-8 bytes are left until we convert them
+ */
+OffSet TranscodedFile::mPeekNextBlock( void ) {
+    if( _boolEnd and _strCarry.empty() ) return 0;
+    return _offBlockSize;
+}
+
+/*
+ * Read in the next block of the file and convert it to UTF-8, 
+ * the blocks are always valid UTF-8 and flagged as such
+ */
+OffSet TranscodedFile::mReadNextBlock( char* arrBlockData, Attributes &attr ) {
+    assert( _ioHandle != 0 );
+
+    if( _offBlockSize < TRANSCODE_MIN_BLOCK ) {
+        mSetError() << "Transcode Error: The block size must be at least " << TRANSCODE_MIN_BLOCK << " bytes";
+        return -1;
+    }
+
+    // If we timeout waiting on clear to read
+    if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+        mSetError( _ioHandle->mGetError() );
+        return -1;
+    }
+
+    _vecRaw.resize( mDecodeSize( _offBlockSize ) );
+    OffSet offOut = 0;
+
+    // Streams may hand us less than a character at a time
+    while( true ) {
+        OffSet offCarry = _strCarry.size();
+        OffSet offLen = 0;
+
+        memcpy( &_vecRaw[0], _strCarry.data(), offCarry );
+
+        if( ! _boolEnd ) {
+            if( ( offLen = _ioHandle->mRead( &_vecRaw[0] + offCarry, _vecRaw.size() - offCarry ) ) < 0 ) {
+                mSetError( _ioHandle->mGetError() );
+                return -1;
+            }
+            if( offLen == 0 ) _boolEnd = true;
+        }
+
+        OffSet offRaw = offCarry + offLen;
+        OffSet offStart = 0;
+
+        // Skip the byte order mark once we have enough bytes to see it
+        if( _boolStart and ( offRaw >= 4 or _boolEnd ) ) {
+            offStart = mCheckBom( &_vecRaw[0], offRaw );
+            // An empty file keeps the byte order mark we would write
+            if( offRaw ) _boolBom = ( offStart != 0 );
+            _boolStart = false;
+        } else if( _boolStart ) {
+            _strCarry.assign( &_vecRaw[0], offRaw );
+            continue;
+        }
+
+        OffSet offUsed = 0;
+        offOut = mDecode( &_vecRaw[0] + offStart, offRaw - offStart, arrBlockData, offUsed, _boolEnd );
+        _strCarry.assign( &_vecRaw[0] + offStart + offUsed, offRaw - offStart - offUsed );
+
+        if( offOut or _boolEnd ) break;
+    }
+
+    attr.mSetFlag( Attributes::Utf8Validated, true );
+
+    // Keep track of where in the file we are
+    _offCurrent += offOut;
+
+    return offOut;
+}
+
+/*
+ * Read in a block of text at specific offset
+ */
+OffSet TranscodedFile::mReadBlock( OffSet offset, char* arrBlockData, Attributes& attr ) {
+
+    // Set the current offset
+    if( mSetOffSet( offset ) == -1 ) {
+        return -1;
+    }
+
+    return mReadNextBlock( arrBlockData, attr );
+}
+
+/*
+ * The UTF-8 offsets do not map to file offsets, 
+ * we can only start over or stay where we are
+ */
+OffSet TranscodedFile::mSetOffSet( OffSet offset ) {
+    assert( _ioHandle != 0 ); 
+
+    // Return if the requested location is the same
+    if( _offCurrent == offset and offset != 0 ) return _offCurrent;
+
+    if( offset != 0 ) {
+        mSetError() << "Transcode Error: '" << mGetFileName() << "' can only seek to the start of the file";
+        return -1;
+    }
+
+    if( _ioHandle->mOffersSeek() ) {
+        if( _ioHandle->mSeek( 0 ) == -1 ) {
+            mSetError( _ioHandle->mGetError() );
+            return -1;
+        }
+    // A stream is only at the start if we have not read from it
+    } else if( _offCurrent != 0 or ! _boolStart ) {
+        mSetError("Current IO Device does not support file seeks");
+        return -1;
+    }
+
+    _offCurrent = 0;
+    _strCarry.clear();
+    _boolStart = true;
+    _boolEnd = false;
+
+    return _offCurrent;
+}
+
+/**
+ * Prepare to load a file
+ */
+bool TranscodedFile::mPrepareLoad( void ) {
+
+    // Set the file offset to the begining of the file
+    if( mSetOffSet( 0 ) != 0 ) return false;
+    return true;
+}
+
+/**
+ * Finalize the load
+ */
+bool TranscodedFile::mFinalizeLoad( void ) {
+    return true;
+}
+
+/*!
+ * Write all the bytes to the handle
+ */
+bool TranscodedFile::mWriteAll( const char* arrData, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize ) {
+        // If we timeout waiting on clear to write
+        if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+
+        OffSet offLen = _ioHandle->mWrite( arrData + offTotal, offSize - offTotal );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+        offTotal += offLen;
+    }
+
+    _offWritten += offTotal;
+    return true;
+}
+
+/**
+ * Prepare to save a file, we always write the whole file from the start
+ */
+bool TranscodedFile::mPrepareSave( void ) {
+
+    if( _ioHandle->mOffersSeek() and _ioHandle->mSeek( 0 ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    _offCurrent = 0;
+    _offWritten = 0;
+    _strCarry.clear();
+    _boolStart = true;
+    _boolEnd = false;
+
+    // Keep the byte order mark the file had
+    if( _boolBom ) {
+        _boolStart = false;
+        std::string strBom = mGetBom();
+        return mWriteAll( strBom.data(), strBom.size() );
+    }
+    return true;
+}
+
+/*
+ * Convert a block of text at a specific offset, the 
+ * offset must be where the last block ended
+ */
+OffSet TranscodedFile::mWriteBlock( OffSet offset, const char* arrBlockData, OffSet offBlockSize, Attributes& attr ) {
+
+    if( offset != _offCurrent ) {
+        mSetError("TranscodedFile can only write sequentially");
+        return -1;
+    }
+
+    return mWriteNextBlock( arrBlockData, offBlockSize, attr );
+}
+
+/*
+ * Convert the next block of UTF-8 text to the file encoding, a
+ * sequence cut off by the end of the block waits for the next block
+ */
+OffSet TranscodedFile::mWriteNextBlock( const char* arrBlockData, OffSet offBlockSize, Attributes& ) {
+    assert( _ioHandle != 0 );
+
+    const char* arrData = arrBlockData;
+    OffSet offSize = offBlockSize;
+    std::string strJoined;
+
+    // Finish the sequence the last block started
+    if( _strCarry.size() ) {
+        strJoined.reserve( _strCarry.size() + offBlockSize );
+        strJoined.assign( _strCarry );
+        strJoined.append( arrBlockData, offBlockSize );
+        arrData = strJoined.data();
+        offSize = strJoined.size();
+    }
+
+    OffSet offBoundary = Utf8Validator::mBoundary( arrData, offSize );
+
+    _vecRaw.resize( mEncodeSize( offBoundary ) + 1 );
+    OffSet offLen = mEncode( arrData, offBoundary, &_vecRaw[0] );
+    if( offLen < 0 ) return -1;
+
+    if( ! mWriteAll( &_vecRaw[0], offLen ) ) return -1;
+
+    _strCarry.assign( arrData + offBoundary, offSize - offBoundary );
+    _boolStart = false;
+
+    // Keep track of where in the file we are
+    _offCurrent += offBlockSize;
+
+    return offBlockSize;
+}
+
+/**
+ * Truncate anything left over from a larger file
+ */
+bool TranscodedFile::mFinalizeSave( void ) {
+
+    if( _strCarry.size() ) {
+        mSetError() << "Transcode Error: The text written to '" << mGetFileName() << "' ends in the middle of a UTF-8 sequence";
+        _strCarry.clear();
+        return false;
+    }
+
+    if( _ioHandle->mTruncate( _offWritten ) == false ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    return true;
+}
+
+// --- Begin utf16file.cpp ---
+
+/*!
+ * The byte order mark also tells us the byte order
+ */
+int Utf16File::mCheckBom( const char* arrData, OffSet offSize ) {
+    if( offSize < 2 ) return 0;
+
+    if( arrData[0] == '\xff' and arrData[1] == '\xfe' ) {
+        _boolBigEndian = false;
+        return 2;
+    }
+    if( arrData[0] == '\xfe' and arrData[1] == '\xff' ) {
+        _boolBigEndian = true;
+        return 2;
+    }
+    return 0;
+}
+
+/*!
+ * Convert UTF-16 to UTF-8, runs of ASCII are converted 8 characters at a time.
+ * Unpaired surrogates become U+FFFD
+ */
+OffSet Utf16File::mDecode( const char* arrIn, OffSet offIn, char* arrOut, OffSet& offUsed, bool boolEnd ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrIn );
+    int intHigh = _boolBigEndian ? 0 : 1;
+    int intLow = _boolBigEndian ? 1 : 0;
+    OffSet i = 0;
+    OffSet o = 0;
+
+    while( i + 2 <= offIn ) {
+
+#ifdef __SSE2__
+        // Pack 8 ASCII characters into 8 bytes
+        const __m128i vecMask = _mm_set1_epi16( short( 0xFF80 ) );
+        while( i + 16 <= offIn ) {
+            __m128i vecUnits = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrBytes + i ) );
+            if( _boolBigEndian ) {
+                vecUnits = _mm_or_si128( _mm_slli_epi16( vecUnits, 8 ), _mm_srli_epi16( vecUnits, 8 ) );
+            }
+            if( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( vecUnits, vecMask ), _mm_setzero_si128() ) ) != 0xFFFF ) break;
+
+            _mm_storel_epi64( reinterpret_cast<__m128i*>( arrOut + o ), _mm_packus_epi16( vecUnits, vecUnits ) );
+            i += 16;
+            o += 8;
+        }
+        if( i + 2 > offIn ) break;
+#endif
+        unsigned int intUnit = ( arrBytes[ i + intHigh ] << 8 ) | arrBytes[ i + intLow ];
+
+        if( intUnit >= 0xD800 and intUnit <= 0xDBFF ) {
+            // The pair is cut off by the end
+            if( i + 4 > offIn and ! boolEnd ) break;
+
+            if( i + 4 <= offIn ) {
+                unsigned int intNext = ( arrBytes[ i + 2 + intHigh ] << 8 ) | arrBytes[ i + 2 + intLow ];
+                if( intNext >= 0xDC00 and intNext <= 0xDFFF ) {
+                    o += encodeUtf8( 0x10000 + ( ( intUnit - 0xD800 ) << 10 ) + ( intNext - 0xDC00 ), arrOut + o );
+                    i += 4;
+                    continue;
+                }
+            }
+            intUnit = 0xFFFD;
+        } else if( intUnit >= 0xDC00 and intUnit <= 0xDFFF ) {
+            intUnit = 0xFFFD;
+        }
+
+        o += encodeUtf8( intUnit, arrOut + o );
+        i += 2;
+    }
+
+    // A file with an odd number of bytes
+    if( boolEnd and i < offIn ) {
+        o += encodeUtf8( 0xFFFD, arrOut + o );
+        i = offIn;
+    }
+
+    offUsed = i;
+    return o;
+}
+
+/*!
+ * Convert UTF-8 to UTF-16, runs of ASCII are converted 16 characters at a time
+ */
+OffSet Utf16File::mEncode( const char* arrIn, OffSet offIn, char* arrOut ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrIn );
+    int intHigh = _boolBigEndian ? 0 : 1;
+    int intLow = _boolBigEndian ? 1 : 0;
+    OffSet i = 0;
+    OffSet o = 0;
+
+    while( i < offIn ) {
+
+#ifdef __SSE2__
+        // Widen 16 ASCII characters into 32 bytes
+        while( i + 16 <= offIn ) {
+            __m128i vecData = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrBytes + i ) );
+            if( _mm_movemask_epi8( vecData ) ) break;
+
+            __m128i vecZero = _mm_setzero_si128();
+            if( _boolBigEndian ) {
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o ), _mm_unpacklo_epi8( vecZero, vecData ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o + 16 ), _mm_unpackhi_epi8( vecZero, vecData ) );
+            } else {
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o ), _mm_unpacklo_epi8( vecData, vecZero ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o + 16 ), _mm_unpackhi_epi8( vecData, vecZero ) );
+            }
+            i += 16;
+            o += 32;
+        }
+        if( i >= offIn ) break;
+#endif
+        unsigned int intCode = 0;
+        int intLen = decodeUtf8( arrBytes + i, offIn - i, intCode );
+        if( ! intLen ) {
+            mSetError() << "Transcode Error: Invalid UTF-8 written to '" << mGetFileName() << "'";
+            return -1;
+        }
+        i += intLen;
+
+        // Characters past the BMP become a surrogate pair
+        if( intCode >= 0x10000 ) {
+            intCode -= 0x10000;
+            unsigned int intUnit = 0xD800 | ( intCode >> 10 );
+            arrOut[ o + intHigh ] = intUnit >> 8;
+            arrOut[ o + intLow ] = intUnit & 0xFF;
+            o += 2;
+            intCode = 0xDC00 | ( intCode & 0x3FF );
+        }
+        arrOut[ o + intHigh ] = intCode >> 8;
+        arrOut[ o + intLow ] = intCode & 0xFF;
+        o += 2;
+    }
+
+    return o;
+}
+
+// --- End utf16file.cpp ---
+
+// --- Begin latin1file.cpp ---
+
+/*!
+ * Convert Latin-1 to UTF-8, runs of ASCII are copied 16 bytes at a time
+ */
+OffSet Latin1File::mDecode( const char* arrIn, OffSet offIn, char* arrOut, OffSet& offUsed, bool ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrIn );
+    OffSet i = 0;
+    OffSet o = 0;
+
+    while( i < offIn ) {
+
+#ifdef __SSE2__
+        while( i + 16 <= offIn ) {
+            __m128i vecData = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrBytes + i ) );
+            if( _mm_movemask_epi8( vecData ) ) break;
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o ), vecData );
+            i += 16;
+            o += 16;
+        }
+        if( i >= offIn ) break;
+#endif
+        unsigned char chByte = arrBytes[i++];
+
+        // Every Latin-1 character is the code point of the same value
+        if( chByte < 0x80 ) {
+            arrOut[o++] = chByte;
+        } else {
+            arrOut[o++] = 0xC0 | ( chByte >> 6 );
+            arrOut[o++] = 0x80 | ( chByte & 0x3F );
+        }
+    }
+
+    offUsed = i;
+    return o;
+}
+
+/*!
+ * Convert UTF-8 to Latin-1, runs of ASCII are copied 16 bytes at a time.
+ * Characters past U+00FF are an error
+ */
+OffSet Latin1File::mEncode( const char* arrIn, OffSet offIn, char* arrOut ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrIn );
+    OffSet i = 0;
+    OffSet o = 0;
+
+    while( i < offIn ) {
+
+#ifdef __SSE2__
+        while( i + 16 <= offIn ) {
+            __m128i vecData = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrBytes + i ) );
+            if( _mm_movemask_epi8( vecData ) ) break;
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( arrOut + o ), vecData );
+            i += 16;
+            o += 16;
+        }
+        if( i >= offIn ) break;
+#endif
+        unsigned int intCode = 0;
+        int intLen = decodeUtf8( arrBytes + i, offIn - i, intCode );
+        if( ! intLen ) {
+            mSetError() << "Transcode Error: Invalid UTF-8 written to '" << mGetFileName() << "'";
+            return -1;
+        }
+        if( intCode > 0xFF ) {
+            mSetError() << "Transcode Error: U+" << std::hex << intCode << std::dec 
+                        << " can not be written to the Latin-1 file '" << mGetFileName() << "'";
+            return -1;
+        }
+        arrOut[o++] = intCode;
+        i += intLen;
+    }
+
+    return o;
+}
+
+// --- End latin1file.cpp ---
@@ -0,0 +1,323 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <Utf8Validator.h>
+#include <string.h>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define UTF8_VALIDATOR_X86
+#include <immintrin.h>
+#endif
+
+/*!
+ * Check one byte at a time, skipping ASCII 8 bytes at a time
+ */
+static bool validateScalar( const unsigned char* arrData, OffSet offSize ) {
+    OffSet i = 0;
+
+    while( i < offSize ) {
+
+        // Skip ASCII a word at a time
+        while( i + 8 <= offSize ) {
+            unsigned long long intWord;
+            memcpy( &intWord, arrData + i, 8 );
+            if( intWord & 0x8080808080808080ULL ) break;
+            i += 8;
+        }
+        if( i >= offSize ) break;
+
+        unsigned char chByte = arrData[i];
+
+        if( chByte < 0x80 ) {
+            ++i;
+            continue;
+        }
+
+        int intLen = 0;
+        unsigned int intCode = 0;
+        if( ( chByte & 0xE0 ) == 0xC0 ) { intLen = 2; intCode = chByte & 0x1F; }
+        else if( ( chByte & 0xF0 ) == 0xE0 ) { intLen = 3; intCode = chByte & 0x0F; }
+        else if( ( chByte & 0xF8 ) == 0xF0 ) { intLen = 4; intCode = chByte & 0x07; }
+        else return false;
+
+        if( i + intLen > offSize ) return false;
+
+        for( int x = 1 ; x < intLen ; ++x ) {
+            if( ( arrData[i+x] & 0xC0 ) != 0x80 ) return false;
+            intCode = ( intCode << 6 ) | ( arrData[i+x] & 0x3F );
+        }
+
+        // Overlong encodings, surrogates and code points past U+10FFFF
+        if( ( intLen == 2 and intCode < 0x80 ) or ( intLen == 3 and intCode < 0x800 ) or
+            ( intLen == 4 and intCode < 0x10000 ) or intCode > 0x10FFFF or
+            ( intCode >= 0xD800 and intCode <= 0xDFFF ) ) return false;
+
+        i += intLen;
+    }
+    return true;
+}
+
+#ifdef UTF8_VALIDATOR_X86
+
+// The error each table entry flags, an error is found when 
+// the same bit is set in all three lookups
+#define TOO_SHORT       ( 1 << 0 )
+#define TOO_LONG        ( 1 << 1 )
+#define OVERLONG_3      ( 1 << 2 )
+#define TOO_LARGE       ( 1 << 3 )
+#define SURROGATE       ( 1 << 4 )
+#define OVERLONG_2      ( 1 << 5 )
+#define TOO_LARGE_1000  ( 1 << 6 )
+#define OVERLONG_4      ( 1 << 6 )
+#define TWO_CONTS       ( 1 << 7 )
+#define CARRY           ( TOO_SHORT | TOO_LONG | TWO_CONTS )
+
+// Indexed by the high nibble of the first byte
+#define BYTE_1_HIGH \
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+    TOO_SHORT | OVERLONG_2, \
+    TOO_SHORT, \
+    TOO_SHORT | OVERLONG_3 | SURROGATE, \
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+
+// Indexed by the low nibble of the first byte
+#define BYTE_1_LOW \
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, \
+    CARRY | OVERLONG_2, \
+    CARRY, \
+    CARRY, \
+    CARRY | TOO_LARGE, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000
+
+// Indexed by the high nibble of the second byte
+#define BYTE_2_HIGH \
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+
+// Subtracted from the last bytes of a chunk, anything left over
+// is the start of a sequence that continues into the next chunk
+#define INCOMPLETE_TAIL     char(0xEF), char(0xDF), char(0xBF)
+
+/*!
+ * Check 16 bytes at a time, the tail is copied into a zero padded chunk
+ */
+__attribute__(( target( "ssse3" ) ))
+static bool validateSSSE3( const unsigned char* arrData, OffSet offSize ) {
+    const __m128i vecByte1High = _mm_setr_epi8( BYTE_1_HIGH );
+    const __m128i vecByte1Low = _mm_setr_epi8( BYTE_1_LOW );
+    const __m128i vecByte2High = _mm_setr_epi8( BYTE_2_HIGH );
+    const __m128i vecNibble = _mm_set1_epi8( 0x0F );
+    const __m128i vecMax = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, INCOMPLETE_TAIL );
+    __m128i vecError = _mm_setzero_si128();
+    __m128i vecPrev = _mm_setzero_si128();
+    __m128i vecIncomplete = _mm_setzero_si128();
+    unsigned char arrTail[ 16 ];
+
+    for( OffSet i = 0 ; i < offSize ; i += 16 ) {
+        __m128i vecInput;
+
+        if( i + 16 <= offSize ) {
+            vecInput = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrData + i ) );
+        } else {
+            memset( arrTail, 0, sizeof( arrTail ) );
+            memcpy( arrTail, arrData + i, offSize - i );
+            vecInput = _mm_loadu_si128( reinterpret_cast<const __m128i*>( arrTail ) );
+        }
+
+        // All ASCII, only a sequence left open by the last chunk is an error
+        if( _mm_movemask_epi8( vecInput ) == 0 ) {
+            vecError = _mm_or_si128( vecError, vecIncomplete );
+            vecIncomplete = _mm_setzero_si128();
+            vecPrev = vecInput;
+            continue;
+        }
+
+        __m128i vecPrev1 = _mm_alignr_epi8( vecInput, vecPrev, 15 );
+        __m128i vecPrev2 = _mm_alignr_epi8( vecInput, vecPrev, 14 );
+        __m128i vecPrev3 = _mm_alignr_epi8( vecInput, vecPrev, 13 );
+
+        __m128i vecSpecial = _mm_and_si128( 
+            _mm_and_si128( 
+                _mm_shuffle_epi8( vecByte1High, _mm_and_si128( _mm_srli_epi16( vecPrev1, 4 ), vecNibble ) ),
+                _mm_shuffle_epi8( vecByte1Low, _mm_and_si128( vecPrev1, vecNibble ) ) ),
+            _mm_shuffle_epi8( vecByte2High, _mm_and_si128( _mm_srli_epi16( vecInput, 4 ), vecNibble ) ) );
+
+        // The third and fourth bytes of a sequence must be continuations
+        __m128i vecThird = _mm_subs_epu8( vecPrev2, _mm_set1_epi8( char( 0xE0 - 0x80 ) ) );
+        __m128i vecFourth = _mm_subs_epu8( vecPrev3, _mm_set1_epi8( char( 0xF0 - 0x80 ) ) );
+        __m128i vecMust = _mm_and_si128( _mm_or_si128( vecThird, vecFourth ), _mm_set1_epi8( char( 0x80 ) ) );
+
+        vecError = _mm_or_si128( vecError, _mm_xor_si128( vecMust, vecSpecial ) );
+        vecIncomplete = _mm_subs_epu8( vecInput, vecMax );
+        vecPrev = vecInput;
+    }
+
+    vecError = _mm_or_si128( vecError, vecIncomplete );
+    return _mm_movemask_epi8( _mm_cmpeq_epi8( vecError, _mm_setzero_si128() ) ) == 0xFFFF;
+}
+
+/*!
+ * Check 32 bytes at a time, the tail is copied into a zero padded chunk
+ */
+__attribute__(( target( "avx2" ) ))
+static bool validateAVX2( const unsigned char* arrData, OffSet offSize ) {
+    const __m256i vecByte1High = _mm256_setr_epi8( BYTE_1_HIGH, BYTE_1_HIGH );
+    const __m256i vecByte1Low = _mm256_setr_epi8( BYTE_1_LOW, BYTE_1_LOW );
+    const __m256i vecByte2High = _mm256_setr_epi8( BYTE_2_HIGH, BYTE_2_HIGH );
+    const __m256i vecNibble = _mm256_set1_epi8( 0x0F );
+    const __m256i vecMax = _mm256_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, INCOMPLETE_TAIL );
+    __m256i vecError = _mm256_setzero_si256();
+    __m256i vecPrev = _mm256_setzero_si256();
+    __m256i vecIncomplete = _mm256_setzero_si256();
+    unsigned char arrTail[ 32 ];
+
+    for( OffSet i = 0 ; i < offSize ; i += 32 ) {
+        __m256i vecInput;
+
+        if( i + 32 <= offSize ) {
+            vecInput = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( arrData + i ) );
+        } else {
+            memset( arrTail, 0, sizeof( arrTail ) );
+            memcpy( arrTail, arrData + i, offSize - i );
+            vecInput = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( arrTail ) );
+        }
+
+        // All ASCII, only a sequence left open by the last chunk is an error
+        if( _mm256_movemask_epi8( vecInput ) == 0 ) {
+            vecError = _mm256_or_si256( vecError, vecIncomplete );
+            vecIncomplete = _mm256_setzero_si256();
+            vecPrev = vecInput;
+            continue;
+        }
+
+        // The high half of the last chunk followed by the low half of this one
+        __m256i vecCross = _mm256_permute2x128_si256( vecPrev, vecInput, 0x21 );
+        __m256i vecPrev1 = _mm256_alignr_epi8( vecInput, vecCross, 15 );
+        __m256i vecPrev2 = _mm256_alignr_epi8( vecInput, vecCross, 14 );
+        __m256i vecPrev3 = _mm256_alignr_epi8( vecInput, vecCross, 13 );
+
+        __m256i vecSpecial = _mm256_and_si256( 
+            _mm256_and_si256( 
+                _mm256_shuffle_epi8( vecByte1High, _mm256_and_si256( _mm256_srli_epi16( vecPrev1, 4 ), vecNibble ) ),
+                _mm256_shuffle_epi8( vecByte1Low, _mm256_and_si256( vecPrev1, vecNibble ) ) ),
+            _mm256_shuffle_epi8( vecByte2High, _mm256_and_si256( _mm256_srli_epi16( vecInput, 4 ), vecNibble ) ) );
+
+        // The third and fourth bytes of a sequence must be continuations
+        __m256i vecThird = _mm256_subs_epu8( vecPrev2, _mm256_set1_epi8( char( 0xE0 - 0x80 ) ) );
+        __m256i vecFourth = _mm256_subs_epu8( vecPrev3, _mm256_set1_epi8( char( 0xF0 - 0x80 ) ) );
+        __m256i vecMust = _mm256_and_si256( _mm256_or_si256( vecThird, vecFourth ), _mm256_set1_epi8( char( 0x80 ) ) );
+
+        vecError = _mm256_or_si256( vecError, _mm256_xor_si256( vecMust, vecSpecial ) );
+        vecIncomplete = _mm256_subs_epu8( vecInput, vecMax );
+        vecPrev = vecInput;
+    }
+
+    vecError = _mm256_or_si256( vecError, vecIncomplete );
+    return _mm256_testz_si256( vecError, vecError );
+}
+
+#endif // UTF8_VALIDATOR_X86
+
+/*!
+ * Return the widest implementation the CPU supports
+ */
+int Utf8Validator::mBest( void ) {
+    static int intBest = -1;
+
+    if( intBest == -1 ) {
+#ifdef UTF8_VALIDATOR_X86
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports( "avx2" ) ) intBest = AVX2;
+        else if( __builtin_cpu_supports( "ssse3" ) ) intBest = SSSE3;
+        else intBest = Scalar;
+#else
+        intBest = Scalar;
+#endif
+    }
+    return intBest;
+}
+
+const char* Utf8Validator::mName( int intImplementation ) {
+    switch( intImplementation ) {
+        case AVX2:  return "avx2";
+        case SSSE3: return "ssse3";
+    }
+    return "scalar";
+}
+
+bool Utf8Validator::mValidate( const char* arrData, OffSet offSize ) {
+    return mValidateWith( mBest(), arrData, offSize );
+}
+
+/*!
+ * Validate with a specific implementation, the caller must 
+ * make sure the CPU supports it ( IE: mBest() >= intImplementation )
+ */
+bool Utf8Validator::mValidateWith( int intImplementation, const char* arrData, OffSet offSize ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrData );
+
+#ifdef UTF8_VALIDATOR_X86
+    switch( intImplementation ) {
+        case AVX2:  return validateAVX2( arrBytes, offSize );
+        case SSSE3: return validateSSSE3( arrBytes, offSize );
+    }
+#endif
+    return validateScalar( arrBytes, offSize );
+}
+
+/*!
+ * Look back over the last 3 bytes for the start of a sequence 
+ * that needs more bytes than the block has left
+ */
+OffSet Utf8Validator::mBoundary( const char* arrData, OffSet offSize ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrData );
+
+    for( OffSet i = offSize - 1 ; i >= 0 and i >= offSize - 3 ; --i ) {
+        unsigned char chByte = arrBytes[i];
+
+        // Continuation byte, keep looking for the start
+        if( ( chByte & 0xC0 ) == 0x80 ) continue;
+
+        if( chByte >= 0xC0 ) {
+            OffSet offLen = 2;
+            if( chByte >= 0xF0 ) offLen = 4;
+            else if( chByte >= 0xE0 ) offLen = 3;
+            if( offSize - i < offLen ) return i;
+        }
+        break;
+    }
+    return offSize;
+}
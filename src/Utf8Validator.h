@@ -0,0 +1,51 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef UTF8VALIDATOR_INCLUDE_H
+#define UTF8VALIDATOR_INCLUDE_H
+
+#include <Ollie.h>
+
+/*!
+ * Checks that blocks of bytes are valid UTF-8 
+ *
+ * On x86 the check runs 32 or 16 bytes at a time using the lookup tables
+ * from Keiser and Lemire's "Validating UTF-8 In Less Than One Instruction
+ * Per Byte", the widest implementation the CPU supports is chosen the 
+ * first time mValidate() is called. Other CPUs use the scalar check
+ */
+class Utf8Validator {
+
+    public:
+        enum Implementation { Scalar, SSSE3, AVX2 };
+
+        //! Returns true if the bytes are valid UTF-8, a sequence cut off by the end is invalid
+        static bool     mValidate( const char*, OffSet );
+        static bool     mValidateWith( int, const char*, OffSet );
+
+        //! The widest implementation this CPU supports
+        static int      mBest( void );
+        static const char* mName( int );
+
+        //! The end of the last complete sequence, bytes after it start a sequence the block cut off
+        static OffSet   mBoundary( const char*, OffSet );
+};
+
+#endif // UTF8VALIDATOR_INCLUDE_H
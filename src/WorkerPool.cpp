@@ -0,0 +1,107 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <WorkerPool.h>
+#include <unistd.h>
+
+WorkerPool::WorkerPool( int intThreads ) : _boolStop(false) {
+    pthread_mutex_init( &_mutex, 0 );
+    pthread_cond_init( &_condWork, 0 );
+    pthread_cond_init( &_condDone, 0 );
+
+    for( int i = 0 ; i < intThreads ; ++i ) {
+        pthread_t thread;
+        if( pthread_create( &thread, 0, &WorkerPool::mWorker, this ) == 0 ) {
+            _vecThreads.push_back( thread );
+        }
+    }
+    // Without threads mSubmit() will run the job itself
+}
+
+WorkerPool::~WorkerPool() {
+
+    pthread_mutex_lock( &_mutex );
+    _boolStop = true;
+    pthread_cond_broadcast( &_condWork );
+    pthread_mutex_unlock( &_mutex );
+
+    for( size_t i = 0 ; i < _vecThreads.size() ; ++i ) {
+        pthread_join( _vecThreads[i], 0 );
+    }
+
+    pthread_cond_destroy( &_condDone );
+    pthread_cond_destroy( &_condWork );
+    pthread_mutex_destroy( &_mutex );
+}
+
+int WorkerPool::mThreadsFor( int intThreads ) {
+    if( intThreads > 0 ) return intThreads;
+
+    long intCpus = sysconf( _SC_NPROCESSORS_ONLN );
+    if( intCpus < 1 ) return 1;
+    return intCpus;
+}
+
+void* WorkerPool::mWorker( void* ptrPool ) {
+    WorkerPool* pool = static_cast<WorkerPool*>( ptrPool );
+
+    pthread_mutex_lock( &pool->_mutex );
+    while( true ) {
+        while( ! pool->_boolStop and pool->_queJobs.empty() ) {
+            pthread_cond_wait( &pool->_condWork, &pool->_mutex );
+        }
+        if( pool->_boolStop ) break;
+
+        WorkerJob* job = pool->_queJobs.front();
+        pool->_queJobs.pop_front();
+        pthread_mutex_unlock( &pool->_mutex );
+
+        job->mRun();
+
+        pthread_mutex_lock( &pool->_mutex );
+        job->boolDone = true;
+        pthread_cond_broadcast( &pool->_condDone );
+    }
+    pthread_mutex_unlock( &pool->_mutex );
+    return 0;
+}
+
+void WorkerPool::mSubmit( WorkerJob* job ) {
+
+    // No threads, run it now
+    if( _vecThreads.empty() ) {
+        job->mRun();
+        job->boolDone = true;
+        return;
+    }
+
+    pthread_mutex_lock( &_mutex );
+    _queJobs.push_back( job );
+    pthread_cond_signal( &_condWork );
+    pthread_mutex_unlock( &_mutex );
+}
+
+void WorkerPool::mWait( WorkerJob* job ) {
+    pthread_mutex_lock( &_mutex );
+    while( ! job->boolDone ) {
+        pthread_cond_wait( &_condDone, &_mutex );
+    }
+    pthread_mutex_unlock( &_mutex );
+}
@@ -0,0 +1,69 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#ifndef WORKERPOOL_INCLUDE_H
+#define WORKERPOOL_INCLUDE_H
+
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+/*!
+ * A unit of work for the WorkerPool
+ */
+class WorkerJob {
+
+    public:
+        WorkerJob( void ) : boolDone(false) { }
+        virtual ~WorkerJob() { }
+        virtual void mRun( void ) = 0;
+
+        bool boolDone;
+};
+
+/*!
+ * Runs WorkerJobs on a pool of threads, the Files use 
+ * it to compress independent chunks in parallel
+ */
+class WorkerPool {
+
+    public:
+        WorkerPool( int );
+        ~WorkerPool();
+
+        //! Queue the job, without threads the job is run before we return
+        void mSubmit( WorkerJob* );
+        //! Block until the job has run
+        void mWait( WorkerJob* );
+        int  mGetThreads( void ) { return _vecThreads.size(); }
+
+        //! The threads to use when asked for intThreads, 0 is one per CPU
+        static int   mThreadsFor( int intThreads );
+        static void* mWorker( void* );
+
+        std::vector<pthread_t>      _vecThreads;
+        std::deque<WorkerJob*>      _queJobs;
+        pthread_mutex_t             _mutex;
+        pthread_cond_t              _condWork;
+        pthread_cond_t              _condDone;
+        bool                        _boolStop;
+};
+
+#endif // WORKERPOOL_INCLUDE_H
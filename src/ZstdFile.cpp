@@ -0,0 +1,609 @@
+/*  This file is part of the Ollie libraries
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ *
+ *  Copyright (C) 2007 Derrick J. Wippler <thrawn01@gmail.com>
+ **/
+
+#include <File.h>
+#include <string.h>
+#include <WorkerPool.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// The size of the compressed reads
+#define ZSTD_CHUNK_SIZE         131072
+// Magic numbers of the seekable format
+#define ZSTD_SKIPPABLE_MAGIC    0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC     0x8F92EAB1
+// The seek table footer, frame count, descriptor and magic
+#define ZSTD_FOOTER_SIZE        9
+
+static unsigned int readLE32( const char* arrData ) {
+    const unsigned char* arrBytes = reinterpret_cast<const unsigned char*>( arrData );
+    return arrBytes[0] | ( arrBytes[1] << 8 ) | ( arrBytes[2] << 16 ) | ( (unsigned int)arrBytes[3] << 24 );
+}
+
+static void writeLE32( std::string& strData, unsigned int intValue ) {
+    for( int i = 0 ; i < 4 ; ++i ) {
+        strData.push_back( char( ( intValue >> ( i * 8 ) ) & 0xff ) );
+    }
+}
+
+/*!
+ * A frame compressed on the WorkerPool
+ */
+class ZstdJob : public WorkerJob {
+
+    public:
+        virtual void mRun( void );
+
+        std::string     strIn;
+        std::string     strOut;
+        int             intLevel;
+        bool            boolFailed;
+};
+
+/*!
+ * Compress the data as a single independent frame
+ */
+void ZstdJob::mRun( void ) {
+#ifdef HAVE_ZSTD
+    strOut.resize( ZSTD_compressBound( strIn.size() ) );
+
+    size_t intLen = ZSTD_compress( &strOut[0], strOut.size(), strIn.data(), strIn.size(), intLevel );
+    if( ZSTD_isError( intLen ) ) {
+        boolFailed = true;
+        return;
+    }
+    strOut.resize( intLen );
+#else
+    boolFailed = true;
+#endif
+}
+
+/*!
+ * ZstdFile Constructor
+ */
+ZstdFile::ZstdFile( IOHandle* const ioHandle, OffSet offFrameSize ) : File( ioHandle ), _zRead(0),
+                    _offFrameSize( offFrameSize ), _intThreads( DEFAULT_ZSTD_THREADS ), 
+                    _intLevel( DEFAULT_ZSTD_LEVEL ), _offInPos(0), _offInSize(0), _boolBetween(true), 
+                    _boolEnd(false), _ptrCompressor(0), _offWritten(0) {
+
+    _vecIn.resize( ZSTD_CHUNK_SIZE );
+}
+
+/*!
+ * ZstdFile Destructor
+ */
+ZstdFile::~ZstdFile() {
+    mEnd();
+}
+
+/*!
+ * Release the decompression context and the compressor
+ */
+void ZstdFile::mEnd( void ) {
+#ifdef HAVE_ZSTD
+    if( _zRead ) {
+        ZSTD_freeDCtx( _zRead );
+        _zRead = 0;
+    }
+#endif
+    if( _ptrCompressor ) {
+        // Let the workers finish with any frame they still hold
+        for( std::deque<ZstdJob*>::iterator it = _queJobs.begin() ; it != _queJobs.end() ; ++it ) {
+            _ptrCompressor->mWait( *it );
+            delete *it;
+        }
+        _queJobs.clear();
+        delete _ptrCompressor;
+        _ptrCompressor = 0;
+    }
+    _strFrame.clear();
+}
+
+/*!
+ * Read all the bytes at the current position of the handle
+ */
+bool ZstdFile::mReadAll( char* arrData, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize ) {
+        // If we timeout waiting on clear to read
+        if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+
+        OffSet offLen = _ioHandle->mRead( arrData + offTotal, offSize - offTotal );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+        if( offLen == 0 ) {
+            mSetError() << "Zstd Error: Unexpected end of '" << mGetFileName() << "'";
+            return false;
+        }
+        offTotal += offLen;
+    }
+    return true;
+}
+
+/*!
+ * Read the seek table from the end of the file, returns false only on
+ * IO errors. Files without a seek table ( or a corrupt one ) are read 
+ * from the start
+ */
+bool ZstdFile::mLoadSeekTable( void ) {
+    char arrFooter[ ZSTD_FOOTER_SIZE ];
+
+    _vecFrames.clear();
+    _vecFrameOffSets.clear();
+
+    OffSet offFileSize = _ioHandle->mGetFileSize();
+    if( ! _ioHandle->mOffersSeek() or offFileSize < ZSTD_FOOTER_SIZE + 8 ) return true;
+
+    if( _ioHandle->mSeek( offFileSize - ZSTD_FOOTER_SIZE ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    if( ! mReadAll( arrFooter, ZSTD_FOOTER_SIZE ) ) return false;
+
+    if( readLE32( arrFooter + 5 ) != ZSTD_SEEKABLE_MAGIC ) return true;
+
+    // Each entry is the compressed and decompressed size, plus a checksum if flagged
+    OffSet offFrames = readLE32( arrFooter );
+    OffSet offEntrySize = ( arrFooter[4] & 0x80 ) ? 12 : 8;
+    OffSet offTableSize = ( offFrames * offEntrySize ) + ZSTD_FOOTER_SIZE;
+
+    if( offTableSize + 8 > offFileSize ) return true;
+
+    std::vector<char> vecTable( offTableSize + 8 );
+    if( _ioHandle->mSeek( offFileSize - vecTable.size() ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+    if( ! mReadAll( &vecTable[0], vecTable.size() ) ) return false;
+
+    if( readLE32( &vecTable[0] ) != ZSTD_SKIPPABLE_MAGIC or readLE32( &vecTable[4] ) != offTableSize ) return true;
+
+    OffSet offOut = 0;
+    OffSet offIn = 0;
+    for( OffSet i = 0 ; i < offFrames ; ++i ) {
+        const char* arrEntry = &vecTable[ 8 + ( i * offEntrySize ) ];
+        _vecFrameOffSets.push_back( offIn );
+        _vecFrames.push_back( offOut );
+        offIn += readLE32( arrEntry );
+        offOut += readLE32( arrEntry + 4 );
+    }
+
+    // The frames must end where the seek table starts
+    if( offIn != offFileSize - OffSet( vecTable.size() ) ) {
+        _vecFrames.clear();
+        _vecFrameOffSets.clear();
+        return true;
+    }
+
+    _vecFrameOffSets.push_back( offIn );
+    _vecFrames.push_back( offOut );
+    return true;
+}
+
+/*!
+ * Start decompressing again at the start of the frame
+ */
+#ifdef HAVE_ZSTD
+bool ZstdFile::mResetDecompress( int intFrame ) {
+    if( ! _zRead and ! ( _zRead = ZSTD_createDCtx() ) ) {
+        mSetError() << "Zstd Error: Unable to start decompressing '" << mGetFileName() << "'";
+        return false;
+    }
+    ZSTD_DCtx_reset( _zRead, ZSTD_reset_session_only );
+
+    OffSet offIn = 0;
+    _offCurrent = 0;
+    if( intFrame < int( _vecFrameOffSets.size() ) ) {
+        offIn = _vecFrameOffSets[ intFrame ];
+        _offCurrent = _vecFrames[ intFrame ];
+    }
+
+    if( _ioHandle->mSeek( offIn ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    _offInPos = 0;
+    _offInSize = 0;
+    _boolBetween = true;
+    _boolEnd = false;
+    return true;
+}
+#else
+bool ZstdFile::mResetDecompress( int ) {
+    mSetError() << "Zstd Error: Unable to read '" << mGetFileName() << "', ollie was built without zstd support";
+    return false;
+}
+#endif
+
+/*!
+ * Decompress up to offSize bytes into the buffer
+ * Returns the bytes decompressed, 0 at the end of the file or -1 on error
+ */
+#ifdef HAVE_ZSTD
+OffSet ZstdFile::mDecompress( char* arrBuffer, OffSet offSize ) {
+    ZSTD_outBuffer zOut = { arrBuffer, size_t( offSize ), 0 };
+
+    while( zOut.pos < zOut.size and ! _boolEnd ) {
+
+        if( _offInPos == _offInSize ) {
+            // If we timeout waiting on clear to read
+            if( _ioHandle->mWaitForClearToRead( _intTimeout ) ) {
+                mSetError( _ioHandle->mGetError() );
+                return -1;
+            }
+
+            OffSet offLen = _ioHandle->mRead( &_vecIn[0], _vecIn.size() );
+            if( offLen < 0 ) {
+                mSetError( _ioHandle->mGetError() );
+                return -1;
+            }
+            if( offLen == 0 ) {
+                if( _boolBetween ) {
+                    _boolEnd = true;
+                    break;
+                }
+                mSetError() << "Zstd Error: Unexpected end of compressed data in '" << mGetFileName() << "'";
+                return -1;
+            }
+            _offInPos = 0;
+            _offInSize = offLen;
+        }
+
+        // Skippable frames ( like the seek table ) are passed over by the decompressor
+        ZSTD_inBuffer zIn = { &_vecIn[0], size_t( _offInSize ), size_t( _offInPos ) };
+        size_t intRet = ZSTD_decompressStream( _zRead, &zOut, &zIn );
+        _offInPos = zIn.pos;
+
+        if( ZSTD_isError( intRet ) ) {
+            mSetError() << "Zstd Error: Unable to decompress '" << mGetFileName() << "' - " << ZSTD_getErrorName( intRet );
+            return -1;
+        }
+
+        // A return of 0 means the frame is complete
+        _boolBetween = ( intRet == 0 );
+    }
+
+    _offCurrent += zOut.pos;
+    return zOut.pos;
+}
+#else
+OffSet ZstdFile::mDecompress( char*, OffSet ) {
+    mSetError() << "Zstd Error: Unable to read '" << mGetFileName() << "', ollie was built without zstd support";
+    return -1;
+}
+#endif
+
+/*!
+ * With a seek table we know how much data is left
+ */
+OffSet ZstdFile::mPeekNextBlock( void ) {
+    if( _boolEnd ) return 0;
+
+    if( _vecFrames.size() ) {
+        OffSet offLeft = _vecFrames.back() - _offCurrent;
+        if( offLeft < _offBlockSize ) return offLeft;
+    }
+    return _offBlockSize;
+}
+
+/*
+ * Decompress the next block of text starting at the last read offset
+ *
+ * Zstd files have no additional attributes, we ignore the 
+ * attributes reference passed
+ */
+OffSet ZstdFile::mReadNextBlock( char* arrBlockData, Attributes& ) {
+    assert( _ioHandle != 0 );
+
+    if( ! _zRead and ! mResetDecompress( 0 ) ) return -1;
+
+    return mDecompress( arrBlockData, _offBlockSize );
+}
+
+/*
+ * Decompress a block of text at specific offset, only
+ * the frame that holds the offset is decompressed
+ */
+OffSet ZstdFile::mReadBlock( OffSet offset, char* arrBlockData, Attributes& attr ) {
+
+    // Set the current offset
+    if( mSetOffSet( offset ) == -1 ) {
+        return -1;
+    }
+
+    return mReadNextBlock( arrBlockData, attr );
+}
+
+/*
+ * Move to an uncompressed offset, starting at the frame that holds 
+ * the offset unless continuing from where we are is closer
+ */
+OffSet ZstdFile::mSetOffSet( OffSet offset ) {
+    assert( _ioHandle != 0 ); 
+
+    if( _ptrCompressor ) {
+        if( offset == _offCurrent ) return _offCurrent;
+        mSetError("ZstdFile can only write sequentially");
+        return -1;
+    }
+
+    if( ! _zRead and ! mResetDecompress( 0 ) ) return -1;
+
+    // Return if the requested location is the same
+    if( _offCurrent == offset ) return _offCurrent;
+
+    if( offset < 0 ) {
+        mSetError() << "Zstd Error: Invalid offset " << offset;
+        return -1;
+    }
+
+    // Find the frame that holds the offset, the last entry is the end of the data
+    int intFrame = 0;
+    while( intFrame + 2 < int( _vecFrames.size() ) and _vecFrames[ intFrame + 1 ] <= offset ) ++intFrame;
+
+    // Start over unless we can get there by reading forward
+    if( offset < _offCurrent or ( _vecFrames.size() and _vecFrames[ intFrame ] > _offCurrent ) ) {
+
+        // Starting over needs to seek the compressed data
+        if( ! _ioHandle->mOffersSeek() ) {
+            mSetError("Current IO Device does not support file seeks");
+            return -1;
+        }
+
+        if( ! mResetDecompress( intFrame ) ) return -1;
+    }
+
+    // Decompress up to the offset
+    std::vector<char> vecSkip;
+    while( _offCurrent < offset ) {
+        OffSet offSkip = offset - _offCurrent;
+        if( offSkip > ZSTD_CHUNK_SIZE ) offSkip = ZSTD_CHUNK_SIZE;
+        if( vecSkip.size() < size_t( offSkip ) ) vecSkip.resize( offSkip );
+
+        OffSet offLen = mDecompress( &vecSkip[0], offSkip );
+        if( offLen < 0 ) return -1;
+        if( offLen == 0 ) {
+            mSetError() << "Zstd Error: Offset " << offset << " is past the end of '" << mGetFileName() << "'";
+            return -1;
+        }
+    }
+
+    return _offCurrent;
+}
+
+/**
+ * Prepare to load a file, reading the seek table if it has one
+ */
+bool ZstdFile::mPrepareLoad( void ) {
+    if( ! mLoadSeekTable() ) return false;
+    return mResetDecompress( 0 );
+}
+
+/**
+ * Finalize the load
+ */
+bool ZstdFile::mFinalizeLoad( void ) {
+    return true;
+}
+
+/*!
+ * Write all the bytes to the handle
+ */
+bool ZstdFile::mWriteAll( const char* arrData, OffSet offSize ) {
+    OffSet offTotal = 0;
+
+    while( offTotal < offSize ) {
+        // If we timeout waiting on clear to write
+        if( _ioHandle->mWaitForClearToWrite( _intTimeout ) ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+
+        OffSet offLen = _ioHandle->mWrite( arrData + offTotal, offSize - offTotal );
+        if( offLen < 0 ) {
+            mSetError( _ioHandle->mGetError() );
+            return false;
+        }
+        offTotal += offLen;
+    }
+
+    _offWritten += offTotal;
+    return true;
+}
+
+/**
+ * Prepare to save a file, we always write the whole file from the start
+ */
+bool ZstdFile::mPrepareSave( void ) {
+#ifdef HAVE_ZSTD
+    // What we read before is about to change
+    mEnd();
+    _vecFrames.clear();
+    _vecFrameOffSets.clear();
+    _vecSeekTable.clear();
+
+    if( _ioHandle->mSeek( 0 ) == -1 ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    _offCurrent = 0;
+    _offWritten = 0;
+
+    // With a single thread the frames are compressed as they are queued
+    int intThreads = WorkerPool::mThreadsFor( _intThreads );
+    if( intThreads < 2 ) intThreads = 0;
+
+    _ptrCompressor = new WorkerPool( intThreads );
+    return true;
+#else
+    mSetError() << "Zstd Error: Unable to save '" << mGetFileName() << "', ollie was built without zstd support";
+    return false;
+#endif
+}
+
+/*!
+ * Hand the frame to the compressor, waiting for the oldest 
+ * frame to be written if too many are in flight
+ */
+bool ZstdFile::mQueueFrame( void ) {
+    ZstdJob* job = new ZstdJob();
+
+    job->strIn.swap( _strFrame );
+    job->intLevel = _intLevel;
+    job->boolFailed = false;
+
+    _queJobs.push_back( job );
+    _ptrCompressor->mSubmit( job );
+
+    while( _queJobs.size() > size_t( _ptrCompressor->mGetThreads() * 2 ) ) {
+        if( ! mCollectFrame() ) return false;
+    }
+    return true;
+}
+
+/*!
+ * Wait for the oldest frame to be compressed, write 
+ * it and remember its sizes for the seek table
+ */
+bool ZstdFile::mCollectFrame( void ) {
+    ZstdJob* job = _queJobs.front();
+    _queJobs.pop_front();
+
+    _ptrCompressor->mWait( job );
+
+    if( job->boolFailed ) {
+        mSetError() << "Zstd Error: Unable to compress '" << mGetFileName() << "'";
+        delete job;
+        return false;
+    }
+
+    _vecSeekTable.push_back( job->strOut.size() );
+    _vecSeekTable.push_back( job->strIn.size() );
+    bool boolResult = mWriteAll( job->strOut.data(), job->strOut.size() );
+
+    delete job;
+    return boolResult;
+}
+
+/*
+ * Compress a block of text at a specific offset, the 
+ * offset must be where the last block ended
+ */
+OffSet ZstdFile::mWriteBlock( OffSet offset, const char* arrBlockData, OffSet offBlockSize, Attributes& attr ) {
+
+    if( offset != _offCurrent ) {
+        mSetError("ZstdFile can only write sequentially");
+        return -1;
+    }
+
+    return mWriteNextBlock( arrBlockData, offBlockSize, attr );
+}
+
+/*
+ * Add the next block of text to the frame, queueing the frame once it is full
+ */
+OffSet ZstdFile::mWriteNextBlock( const char* arrBlockData, OffSet offBlockSize, Attributes& ) {
+    assert( _ioHandle != 0 );
+
+    if( ! _ptrCompressor ) {
+        mSetError("ZstdFile::mPrepareSave() must be called before writing");
+        return -1;
+    }
+
+    OffSet offDone = 0;
+    while( offDone < offBlockSize ) {
+        OffSet offLen = _offFrameSize - _strFrame.size();
+        if( offLen > offBlockSize - offDone ) offLen = offBlockSize - offDone;
+
+        _strFrame.append( arrBlockData + offDone, offLen );
+        offDone += offLen;
+
+        if( OffSet( _strFrame.size() ) == _offFrameSize and ! mQueueFrame() ) return -1;
+    }
+
+    // Keep track of where in the file we are
+    _offCurrent += offBlockSize;
+    return offBlockSize;
+}
+
+/**
+ * Write the last frame and the seek table, then truncate 
+ * anything left over from a larger file
+ */
+bool ZstdFile::mFinalizeSave( void ) {
+
+    if( ! _ptrCompressor ) {
+        mSetError("ZstdFile::mPrepareSave() must be called before writing");
+        return false;
+    }
+
+    bool boolResult = true;
+    if( _strFrame.size() ) boolResult = mQueueFrame();
+    while( boolResult and _queJobs.size() ) {
+        boolResult = mCollectFrame();
+    }
+
+    mEnd();
+    if( ! boolResult ) return false;
+
+    // The seek table is a skippable frame, without checksums
+    unsigned int intFrames = _vecSeekTable.size() / 2;
+    std::string strTable;
+    writeLE32( strTable, ZSTD_SKIPPABLE_MAGIC );
+    writeLE32( strTable, ( intFrames * 8 ) + ZSTD_FOOTER_SIZE );
+    for( size_t i = 0 ; i < _vecSeekTable.size() ; ++i ) {
+        writeLE32( strTable, _vecSeekTable[i] );
+    }
+    writeLE32( strTable, intFrames );
+    strTable.push_back( 0 );
+    writeLE32( strTable, ZSTD_SEEKABLE_MAGIC );
+
+    // Reads after the save can use the table we just wrote
+    OffSet offIn = 0;
+    OffSet offOut = 0;
+    for( size_t i = 0 ; i < _vecSeekTable.size() ; i += 2 ) {
+        _vecFrameOffSets.push_back( offIn );
+        _vecFrames.push_back( offOut );
+        offIn += _vecSeekTable[i];
+        offOut += _vecSeekTable[i + 1];
+    }
+    _vecFrameOffSets.push_back( offIn );
+    _vecFrames.push_back( offOut );
+    _vecSeekTable.clear();
+
+    if( ! mWriteAll( strTable.data(), strTable.size() ) ) return false;
+
+    if( _ioHandle->mTruncate( _offWritten ) == false ) {
+        mSetError( _ioHandle->mGetError() );
+        return false;
+    }
+
+    return true;
+}
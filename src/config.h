@@ -51,3 +51,50 @@ typedef __off_t OffSet;
 // The default size of each page of blocks
 #define DEFAULT_PAGE_SIZE      2000
 
+// Large files get larger pages so a buffer holds about DEFAULT_MAX_PAGES 
+// pages, each page is DEFAULT_PAGE_BLOCKS blocks and no larger than DEFAULT_MAX_PAGE_SIZE
+#define DEFAULT_MAX_PAGES       4096
+#define DEFAULT_MAX_PAGE_SIZE   4194304
+#define DEFAULT_PAGE_BLOCKS     16
+
+// Edits per page that halve the page size of a buffer sized for a large file
+#define DEFAULT_EDIT_DENSITY    8
+
+// How many blocks PageBuffer::mAppendFile() asks a File for with each mReadBlocks()
+#define DEFAULT_LOAD_BLOCKS     16
+
+// The number of block reads an AsyncIOHandle keeps in flight, and the threads that read them without io_uring ( 0 = one per CPU )
+#define DEFAULT_QUEUE_DEPTH     32
+#define DEFAULT_ASYNC_THREADS   4
+
+// The number of blocks a ReadAheadIOHandle prefetches ahead of the reader
+#define DEFAULT_READAHEAD_BLOCKS 16
+
+// The size of the staging buffer a BufferedIOHandle reads and writes through
+#define DEFAULT_STAGING_SIZE    1048576
+
+// How much of a stream a StreamIOHandle holds in memory before spilling to a temp file
+#define DEFAULT_SPILL_SIZE      67108864L
+
+// The size of each aligned buffer a direct IO PosixIOHandle reads through, and how many are kept for reuse
+#define DEFAULT_DIRECT_SIZE     1048576
+#define DEFAULT_DIRECT_POOL     8
+
+// How many uncompressed bytes a GzipFile reads between checkpoints
+#define DEFAULT_GZIP_SPAN       4194304
+
+// How many uncompressed bytes each thread deflates at a time when saving a GzipFile, and how many threads ( 0 = one per CPU )
+#define DEFAULT_GZIP_CHUNK      131072
+#define DEFAULT_GZIP_THREADS    0
+
+// How many uncompressed bytes go in each frame of a seekable zstd file, the compression level and the threads that compress the frames ( 0 = one per CPU )
+#define DEFAULT_ZSTD_FRAME      1048576
+#define DEFAULT_ZSTD_LEVEL      3
+#define DEFAULT_ZSTD_THREADS    0
+
+// Load every file into the buffer with LF line endings, the CR is put back on save. 
+// When off only files File::mIdentifyFile() sniffs as CRLF are normalized
+#define DEFAULT_NORMALIZE_CRLF  0
+
+// How many bytes File::mIdentifyFile() reads to guess the format of a file
+#define DEFAULT_SNIFF_SIZE      4096
@@ -72,9 +72,9 @@ namespace CxxTest
         ValueTraits( const Ollie::OllieBuffer::ByteArray &s )
         {
             *this << "\"";
-            for ( unsigned i = 0; i < s._strData.length(); ++ i ) {
+            for ( unsigned i = 0; i < s.mSize(); ++ i ) {
                 char c[sizeof("\\xXX")];
-                charToString( s._strData[i], c );
+                charToString( s.mData()[i], c );
                 *this << c;
             }
             *this << "\"";